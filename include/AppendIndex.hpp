@@ -0,0 +1,51 @@
+// === include/AppendIndex.hpp ===
+#pragma once
+#include "InodeMap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+
+// Settings of append-aware rescans (config "append_scan").
+struct AppendScanOptions {
+    bool          enabled        = false;
+    std::uint64_t min_file_bytes = 64ull << 10;   // smaller files are simply rescanned
+    std::uint64_t max_entries    = 10000;
+};
+
+// Text files that were scanned clean, by (dev, ino): how many bytes were scanned and
+// a checksum of those bytes (plus one of the first window, to reject rewrites early).
+// When the file is opened again larger and its old prefix is unchanged, only the
+// appended bytes (plus the last window, for matches that span the old end) are
+// matched. The caller only resumes while no pattern can match more than kWindow bytes.
+class AppendIndex {
+public:
+    static constexpr size_t kWindow = 4096;
+
+    struct Entry {
+        std::uint64_t ruleset_version{0};
+        std::uint64_t length{0};       // bytes scanned clean
+        std::uint64_t head_hash{0};    // xxh64 of [0, kWindow)
+        std::uint64_t prefix_hash{0};  // xxh64 of [0, length)
+    };
+
+    explicit AppendIndex(const AppendScanOptions& opt)
+        : min_file_bytes_(std::max<std::uint64_t>(opt.min_file_bytes, 2 * kWindow)),
+          map_(opt.max_entries) {}
+
+    // files below this are not recorded (always at least two windows)
+    std::uint64_t min_file_bytes() const { return min_file_bytes_; }
+
+    bool lookup(dev_t dev, ino_t ino, std::uint64_t ruleset_version, Entry& out) const;
+    void record(dev_t dev, ino_t ino, const Entry& e);
+    void forget(dev_t dev, ino_t ino);
+
+    // checksum of a window or prefix
+    static std::uint64_t hash(const char* p, size_t n);
+
+private:
+    mutable std::mutex  mu_;
+    const std::uint64_t min_file_bytes_;
+    InodeMap<Entry>     map_;
+};
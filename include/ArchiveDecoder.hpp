@@ -0,0 +1,48 @@
+// === include/ArchiveDecoder.hpp ===
+#pragma once
+#include "FileClassifier.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Limits for archive / compressed-file decoding (config "archives").
+struct ArchiveLimits {
+    bool          enabled            = true;
+    unsigned      max_depth          = 3;            // nested containers (.tar.gz = 2)
+    std::uint64_t max_total_bytes    = 4ull << 30;   // decoded bytes per scanned file
+    std::uint64_t max_ratio          = 250;          // decoded / compressed bytes per stream
+    std::uint64_t max_members        = 100000;       // tar/zip members per scanned file
+    std::uint64_t max_document_bytes = 64ull << 20;  // PDF/office/nested zip member held in memory
+    std::uint64_t max_decoder_memory = 256ull << 20; // xz decoder state (dictionary) per stream
+};
+
+// Streams the contents of gzip, xz, zstd (HAVE_ZSTD builds), tar and zip files into
+// the matcher without materializing them: decoded bytes are delivered in chunks that
+// carry the tail of the previous chunk, so matches up to kOverlap bytes long are
+// found across chunk borders. Members are classified and decoded recursively.
+class ArchiveDecoder {
+public:
+    static constexpr size_t kChunk   = 1u << 20;   // decoded bytes per delivery
+    static constexpr size_t kOverlap = 4096;       // previous-chunk tail carried into the next
+
+    enum class Result { Done, Stopped, Limit, Error };
+
+    // Receivers of decoded content; returning false stops decoding (Result::Stopped).
+    struct Sink {
+        // member text: up to kOverlap bytes already delivered, then the new bytes
+        std::function<bool(const std::string& member, FileKind kind, std::string_view bytes)> text;
+        // a PDF/office member, whole in memory
+        std::function<bool(const std::string& member, FileKind kind, std::string_view bytes)> document;
+    };
+
+    // kinds decode() can open
+    static bool isContainer(FileKind k);
+
+    // Decode the file behind fd (fsz bytes, classified as 'kind'). Member kinds with a
+    // Skip policy are not delivered; Head delivers the first head_bytes.
+    // Out: Done, Stopped (sink said stop), Limit (a limit cut decoding short), Error
+    static Result decode(int fd, size_t fsz, FileKind kind, const ArchiveLimits& limits,
+                         const TypePolicies* policies, const Sink& sink, std::string* error = nullptr);
+};
@@ -1,22 +1,86 @@
 #pragma once
+#include <chrono>
 #include <cstddef>
-#include <sys/types.h> // pid_t
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h> // pid_t, dev_t, ino_t
+
+// Why a file is scanned in the background; lower values are served first.
+enum class AsyncScanClass : int {
+    Miss       = 0,   // a user opened it (large-file cache miss)
+    Revalidate = 1,   // allowed under an older ruleset, opened again
+    Warmup     = 2,   // scope warmup prefetch
+};
+static constexpr size_t kAsyncScanClasses = 3;
+
+// Settings of the background scan queue (config "async_queue").
+struct AsyncQueueOptions {
+    std::uint64_t workers       = 1;
+    std::uint64_t max_wait_ms   = 10000;   // older tasks are served first, whatever class and size
+    std::uint64_t max_tasks     = 10000;   // queue bound (tasks)
+    std::uint64_t max_queued_mb = 65536;   // queue bound (file bytes waiting to be scanned)
+    std::uint64_t max_open_fds  = 256;     // tasks beyond this keep a file handle instead of an fd
+};
 
 struct AsyncScanTask {
     int   fd;
     pid_t pid;
     size_t size;
+    AsyncScanClass cls = AsyncScanClass::Miss;
+    // Revalidate: ruleset version whose delta (added patterns) is all the file needs; 0 = full scan
+    std::uint64_t delta_version = 0;
+    dev_t dev = 0;
+    ino_t ino = 0;
+    std::chrono::steady_clock::time_point enqueued{};
+    // set while queued without an fd (fd == -1): reopened at dequeue and checked against (dev, ino)
+    std::vector<char> handle{};    // struct file_handle from name_to_handle_at
+    int               mount_id = 0;
+    std::string       path{};      // fallback when the filesystem has no file handles
 };
+
+// Queue counters; depth is the number of queued tasks per class right now.
+struct AsyncQueueStats {
+    size_t        depth[kAsyncScanClasses]    = {};
+    std::uint64_t enqueued[kAsyncScanClasses] = {};
+    std::uint64_t served[kAsyncScanClasses]   = {};
+    std::uint64_t deduped = 0;   // enqueues of a file that was already queued
+    std::uint64_t aged    = 0;   // tasks served out of order after max_wait_ms
+    std::uint64_t dropped = 0;   // refused or evicted by the least urgent task when the queue was full
+    std::uint64_t parked  = 0;   // tasks queued as a file handle/path instead of an fd
+    std::uint64_t reopen_failed = 0;   // parked tasks whose file was gone or replaced at dequeue
+    size_t        open_fds = 0;        // fds held by queued tasks right now
+};
+
 struct ConfigManager;
 class CacheL1;
-class PatternMatcherHS;
+class MatcherRegistry;
+class ContentHashCache;
+class ExtractorPool;
+class ByteBudget;
+class AppendIndex;
+class ChunkIndex;
 
-void enqueue_async_scan(int dup_fd, pid_t pid, size_t size);
+// apply queue bounds and scheduling settings (before the first enqueue)
+void configure_async_scan_queue(const AsyncQueueOptions& opt);
+// takes ownership of dup_fd; false if the task was refused (queue full of more urgent work)
+bool enqueue_async_scan(int dup_fd, pid_t pid, size_t size, AsyncScanClass cls = AsyncScanClass::Miss,
+                        std::uint64_t delta_version = 0);
 bool wait_dequeue_async_scan(AsyncScanTask& out);
 void shutdown_async_scan_queue();
+AsyncQueueStats async_scan_queue_stats();
+const char* async_scan_class_name(AsyncScanClass cls);
 void start_async_workers(int log_write_fd,
                          const class ConfigManager& config,
-                         const class PatternMatcherHS* matcher,
+                         const class MatcherRegistry* registry,
                          class CacheL2& l2,
-                         size_t num_workers);
+                         size_t num_workers,
+                         ContentHashCache* dedup = nullptr,
+                         ExtractorPool* extractors = nullptr,
+                         ByteBudget* budget = nullptr,
+                         AppendIndex* appends = nullptr,
+                         ChunkIndex* chunks = nullptr);
+// resize the running worker pool (surplus workers retire after their current task)
+void set_async_workers(size_t num_workers);
+size_t async_worker_count();
 void stop_async_workers_and_join();
@@ -0,0 +1,91 @@
+// === include/ByteBudget.hpp ===
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Settings of the scan memory governor (config "memory_budget").
+struct ByteBudgetOptions {
+    bool          enabled = false;
+    std::uint64_t max_mb  = 512;   // file bytes all in-flight scans may hold together
+};
+
+// Byte-counting admission semaphore shared by the sync miss path and the async
+// workers. A scan charges the bytes it is about to hold; a request larger than the
+// whole budget is clamped to it (that scan then runs alone instead of never).
+class ByteBudget {
+public:
+    explicit ByteBudget(std::uint64_t capacity) : capacity_(std::max<std::uint64_t>(capacity, 1)) {}
+
+    // Bytes held until destruction (or release()).
+    class Grant {
+    public:
+        Grant() = default;
+        ~Grant() { release(); }
+        Grant(const Grant&) = delete;
+        Grant& operator=(const Grant&) = delete;
+        void release() {
+            if (budget_) budget_->give_back(bytes_);
+            budget_ = nullptr;
+            bytes_  = 0;
+        }
+    private:
+        friend class ByteBudget;
+        ByteBudget*   budget_{nullptr};
+        std::uint64_t bytes_{0};
+    };
+
+    // take n bytes if they are free right now
+    bool try_acquire(std::uint64_t n, Grant& g) {
+        g.release();
+        n = std::min(n, capacity_);
+        std::lock_guard<std::mutex> lk(m_);
+        if (used_ + n > capacity_) return false;
+        take_(n, g);
+        return true;
+    }
+    // wait until n bytes are free
+    void acquire(std::uint64_t n, Grant& g) {
+        g.release();
+        n = std::min(n, capacity_);
+        std::unique_lock<std::mutex> lk(m_);
+        if (used_ + n > capacity_) {
+            waits_.fetch_add(1, std::memory_order_relaxed);
+            cv_.wait(lk, [&] { return used_ + n <= capacity_; });
+        }
+        take_(n, g);
+    }
+
+    std::uint64_t capacity() const { return capacity_; }
+    std::uint64_t in_use() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return used_;
+    }
+    // admissions that had to wait / scans switched to streaming (see FileScanner)
+    std::uint64_t waits() const { return waits_.load(std::memory_order_relaxed); }
+    std::uint64_t streamed() const { return streamed_.load(std::memory_order_relaxed); }
+    void count_streamed() { streamed_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    void take_(std::uint64_t n, Grant& g) {
+        used_ += n;
+        g.budget_ = this;
+        g.bytes_  = n;
+    }
+    void give_back(std::uint64_t n) {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            used_ -= n;
+        }
+        cv_.notify_all();
+    }
+
+    const std::uint64_t        capacity_;
+    mutable std::mutex         m_;
+    std::condition_variable    cv_;
+    std::uint64_t              used_{0};
+    std::atomic<std::uint64_t> waits_{0};
+    std::atomic<std::uint64_t> streamed_{0};
+};
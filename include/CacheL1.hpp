@@ -1,17 +1,35 @@
 // === include/CacheManager.hpp ===
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <sys/stat.h>
 #include <sqlite3.h>
 #include <iostream>
+#include <string>
+#include <vector>
 
 class CacheL1 {
 public:
+    struct Row {
+        int64_t  dev{0}, ino{0};
+        int64_t  mtime_ns{0}, ctime_ns{0}, size{0};
+        int      decision{0};
+        int64_t  last_access_ts{0};
+        uint64_t hit_count{0};
+    };
+
     explicit CacheL1(sqlite3* db) : db_(db) {}  // store db handle
-    bool get(const struct stat& st, uint64_t ruleset_version, int& decision);
-    void put(const struct stat& st, uint64_t ruleset_version, int decision , uint64_t max_bytes);
+    // needs_delta: set when the row is an ALLOW of delta_base_version (only new patterns to check)
+    bool get(const struct stat& st, uint64_t ruleset_version, int& decision, bool* needs_delta = nullptr);
+    void put(const struct stat& st, uint64_t ruleset_version, int decision , uint64_t max_bytes,
+             const std::string& matched_ids = std::string());
+    // previous ruleset whose ALLOW rows stay valid modulo newly added patterns (0 = none)
+    void set_delta_base_version(uint64_t v) { delta_base_version_.store(v, std::memory_order_release); }
+    // hottest rows of the given ruleset (hit_count DESC, last_access_ts DESC)
+    std::vector<Row> hottest(uint64_t ruleset_version, size_t limit);
 
 private:
     sqlite3* db_{nullptr};
+    std::atomic<uint64_t> delta_base_version_{0};
     
 };
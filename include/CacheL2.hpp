@@ -1,10 +1,13 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <unordered_map>
 #include <shared_mutex>
+#include <string>
 #include <sys/stat.h>
 
 class CacheL1;
+class CacheShm;
 
 class CacheL2 {
 public:
@@ -27,13 +30,25 @@ public:
         int     decision{0};
         int64_t last_access_ts{0};
         uint64_t hit_count{0};
+        uint64_t generation{0};   // ruleset version the decision was made under
     };
 
 public:
     explicit CacheL2(CacheL1& l1_ref) : l1_(&l1_ref) {}
+    // Optional cross-instance tier consulted between L2 and L1 (get returns 3 on a shm hit).
+    // May be swapped at runtime (pattern reload); the previous tier must outlive in-flight calls.
+    void attach_shared(CacheShm* shm) { shm_.store(shm, std::memory_order_release); }
+    // Current generation (= active ruleset version). Entries of other generations read as
+    // misses, and late puts of an older generation do not repopulate L2 or the shared tier.
+    void set_generation(uint64_t ruleset_version) { generation_.store(ruleset_version, std::memory_order_release); }
+    // Free entries of older generations (after a reload); returns the number removed
+    size_t purge_stale();
 
+    // 0 = miss, 1 = L1 hit, 2 = L2 hit, 3 = shared-tier hit,
+    // 4 = miss that only needs the newly added patterns (see CacheL1::set_delta_base_version)
     int get(const struct stat& st, uint64_t ruleset_version, int& decision,uint64_t max_bytes);
-    void put(const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes);
+    void put(const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes,
+             const std::string& matched_ids = std::string());
     #ifdef LFU_SIZE
     // Evict up to max_rows_to_evict entries using size-aware LFU (age-decayed)
     void evict_lfu_size(int max_rows_to_evict, int candidate_limit = 256);
@@ -47,6 +62,12 @@ public:
         void evict_lfu(int max_rows_to_evict, double tau_seconds = 3600.0);
     #endif
 
+    // Snapshot persistence for warm restarts (entries + hotness, tied to ruleset_version)
+    bool save_snapshot(const std::string& path, uint64_t ruleset_version) const;
+    size_t load_snapshot(const std::string& path, uint64_t ruleset_version, uint64_t max_bytes);
+    // Fill remaining capacity from the hottest valid L1 rows (startup preload)
+    size_t preload_from_l1(uint64_t ruleset_version, uint64_t max_bytes);
+
 private:
     static inline int64_t to_ns(time_t s, long ns) {
         return static_cast<int64_t>(s) * 1000000000LL + static_cast<int64_t>(ns);
@@ -58,4 +79,6 @@ private:
     mutable std::shared_mutex mu_;
     std::unordered_map<Key, Entry, KeyHash> map_;
     CacheL1* l1_{nullptr};
+    std::atomic<CacheShm*> shm_{nullptr};
+    std::atomic<uint64_t>  generation_{0};
 };
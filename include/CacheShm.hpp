@@ -0,0 +1,40 @@
+// === include/CacheShm.hpp ===
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/stat.h>
+
+// Optional decision tier shared by all local fileguard instances that run the
+// same pattern set. Lives in a POSIX shared-memory segment named after the
+// patterns hash; slots are seqlock-protected and keyed by (dev, ino).
+class CacheShm {
+public:
+    CacheShm() = default;
+    ~CacheShm();
+    CacheShm(const CacheShm&) = delete;
+    CacheShm& operator=(const CacheShm&) = delete;
+
+    // Create or join the segment for this pattern set. slots is rounded up to a power of two.
+    bool attach(const std::string& patterns_hash, size_t slots);
+    bool attached() const { return hdr_ != nullptr; }
+    const std::string& patterns_hash() const { return hash_; }
+
+    // Lock-free lookup; true only if (dev, ino, mtime, ctime, size) all match.
+    bool get(const struct stat& st, int& decision) const;
+    // Best-effort publish; skipped if the target slot is being written by a live process.
+    void put(const struct stat& st, int decision);
+    // Drop the segment's name when its pattern set is retired (the mapping stays valid).
+    void unlink();
+
+private:
+    struct Header;
+    struct Slot;
+
+    Header* hdr_{nullptr};
+    std::string hash_;
+    std::string name_;
+    Slot*   slots_{nullptr};
+    size_t  map_len_{0};
+    uint64_t mask_{0};
+};
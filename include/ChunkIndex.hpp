@@ -0,0 +1,66 @@
+// === include/ChunkIndex.hpp ===
+#pragma once
+#include "InodeMap.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+// Settings of chunk-level rescans (config "chunk_scan").
+struct ChunkScanOptions {
+    bool          enabled        = false;
+    std::uint64_t min_file_bytes = 8ull << 20;   // smaller files are simply rescanned
+    std::uint64_t max_files      = 1000;
+};
+
+// Content-defined chunks (FastCDC, gear hash with normalized chunking) of large files
+// that were scanned clean, by (dev, ino). An edit in place changes the chunks around
+// it only; when such a file is scanned again, only chunks whose content is new, and
+// boundaries between chunks that were not neighbours before, are matched (each with
+// kWindow bytes of context on both sides for matches crossing a chunk edge). The
+// caller only uses it while no pattern can match more than kWindow bytes, and none
+// depends on buffer edges (^, $, \A, \z, \Z, \b, \B), since a range edge is not one.
+class ChunkIndex {
+public:
+    static constexpr size_t kMinChunk = 16u << 10;
+    static constexpr size_t kAvgChunk = 64u << 10;
+    static constexpr size_t kMaxChunk = 256u << 10;
+    static constexpr size_t kWindow   = 4096;
+
+    struct Chunk {
+        size_t        off;
+        size_t        len;
+        std::uint64_t hash;   // xxh64 of the chunk bytes
+    };
+    using Range = std::pair<size_t, size_t>;   // [first, second)
+
+    explicit ChunkIndex(const ChunkScanOptions& opt)
+        : min_file_bytes_(std::max<std::uint64_t>(opt.min_file_bytes, kMaxChunk)),
+          map_(opt.max_files) {}
+
+    std::uint64_t min_file_bytes() const { return min_file_bytes_; }
+
+    // cut data into content-defined chunks
+    static void split(const char* data, size_t n, std::vector<Chunk>& out);
+
+    // Byte ranges of a file (chunked as 'chunks', 'total' bytes) not covered by its
+    // recorded clean scan, merged and in order. Out: false if nothing is recorded
+    // for the file under this ruleset
+    bool dirty_ranges(dev_t dev, ino_t ino, std::uint64_t ruleset_version,
+                      const std::vector<Chunk>& chunks, size_t total, std::vector<Range>& out) const;
+    void record(dev_t dev, ino_t ino, std::uint64_t ruleset_version, const std::vector<Chunk>& chunks);
+    void forget(dev_t dev, ino_t ino);
+
+private:
+    struct Record {
+        std::uint64_t              ruleset_version;
+        std::vector<std::uint64_t> hashes;   // chunk hashes in file order
+    };
+
+    mutable std::mutex  mu_;
+    const std::uint64_t min_file_bytes_;
+    InodeMap<Record>    map_;
+};
@@ -0,0 +1,101 @@
+// === include/ConcurrencyController.hpp ===
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Settings of the adaptive worker pools (config "concurrency").
+struct ConcurrencyOptions {
+    bool          enabled           = false;
+    std::uint64_t min_sync          = 1;
+    std::uint64_t max_sync          = 0;     // 0 = twice the cores, at least 8 (set by the engine)
+    std::uint64_t min_async         = 1;
+    std::uint64_t max_async         = 0;     // 0 = the number of cores (set by the engine)
+    std::uint64_t interval_ms       = 1000;
+    std::uint64_t target_latency_ms = 100;   // mean miss decision time worth more workers
+    std::uint64_t cpu_psi_limit     = 25;    // % of "some" stall time (avg10) seen as overload
+    std::uint64_t io_psi_limit      = 25;
+};
+
+// Counting limit whose size can change while it is in use (the sync miss pool).
+// It also integrates how many slots were busy and how many callers waited over
+// time, which gives the pool's mean load for the controller.
+class WorkerLimit {
+public:
+    explicit WorkerLimit(size_t limit) : limit_(limit), mark_(Clock::now()) {}
+
+    void acquire();
+    void release();
+    void set_limit(size_t limit);
+    size_t limit() const;
+    // block new acquires and wait until nothing is in flight (shutdown)
+    void drain();
+
+    // mean busy slots and waiting callers since the previous call
+    struct Load {
+        double busy    = 0;
+        double waiting = 0;
+    };
+    Load take_load();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    void account_();   // m_ held
+
+    mutable std::mutex      m_;
+    std::condition_variable cv_;
+    size_t                  limit_;
+    size_t                  in_use_  = 0;
+    size_t                  waiting_ = 0;
+    double                  busy_sec_ = 0;   // integral of in_use_ over time
+    double                  wait_sec_ = 0;   // integral of waiting_ over time
+    Clock::time_point       mark_;
+    Clock::time_point       window_start_ = Clock::now();
+};
+
+// Pressure stall information of the whole system: percent of time some task stalled
+// on the resource over the last 10 s ("cpu", "io"). -1 if the kernel has no PSI.
+double read_psi(const char* resource);
+
+// AIMD controller for the sync miss pool and the async worker pool. Each interval
+// a pool grows by one worker while work queues up for it (or decisions are slower than
+// the target), shrinks by a quarter when CPU or I/O pressure passes its limit, and
+// otherwise drifts down to what its measured load needs (Little's law: mean busy
+// workers = arrival rate x service time), always within its bounds.
+class ConcurrencyController {
+public:
+    struct Signals {
+        double sync_busy    = 0;   // mean busy sync workers
+        double sync_waiting = 0;   // mean misses waiting for a sync worker
+        double latency_ms   = 0;   // mean decision time over the interval
+        size_t async_depth  = 0;   // queued background scans
+        double cpu_psi      = -1;
+        double io_psi       = -1;
+    };
+    struct Decision {
+        size_t      sync;
+        size_t      async;
+        const char* sync_reason;    // "grow", "pressure", "idle" or "hold"
+        const char* async_reason;
+    };
+
+    ConcurrencyController(const ConcurrencyOptions& opt, size_t sync_now, size_t async_now);
+
+    Decision step(const Signals& s);
+
+    size_t min_sync() const { return min_sync_; }
+    size_t max_sync() const { return max_sync_; }
+    size_t min_async() const { return min_async_; }
+    size_t max_async() const { return max_async_; }
+    std::uint64_t grows() const { return grows_; }
+    std::uint64_t cuts() const { return cuts_; }
+
+private:
+    ConcurrencyOptions opt_;
+    size_t             min_sync_, max_sync_, min_async_, max_async_;
+    size_t             sync_, async_;
+    std::uint64_t      grows_ = 0;
+    std::uint64_t      cuts_  = 0;
+};
@@ -4,20 +4,68 @@
 #include <string>
 #include <cstdint>
 #include <sqlite3.h>
+#include "ContentParser.hpp"
+#include "FileClassifier.hpp"
+#include "ArchiveDecoder.hpp"
+#include "ExtractorPool.hpp"
+#include "ScanContext.hpp"
+#include "ByteBudget.hpp"
+#include "PageCache.hpp"
+#include "AppendIndex.hpp"
+#include "ChunkIndex.hpp"
+#include "AsyncScanQueue.hpp"
+#include "ConcurrencyController.hpp"
 
 enum class WarmupMode { None, Scope, Pattern };
 
+// Result of a patterns-only change whose previous pattern set is known:
+// cached decisions can be migrated instead of dropped.
+struct RulesetDelta {
+    bool active = false;
+    std::uint64_t prev_version = 0;
+    std::vector<std::string> added_ids;     // stable ids (see ConfigManager::patternIds)
+    std::vector<std::string> removed_ids;
+};
+
+// Newline-delimited literal list (customer ids, code names, leaked tokens...).
+struct DictionarySpec {
+    std::string path;
+    bool        caseless = true;
+    std::string content_hash;   // hash of the file when the config was loaded
+};
+
+// Where a pattern applies: content types (ContentParser::detect_type names) and
+// path prefixes. An empty list means "any"; an unscoped pattern runs on every file.
+struct PatternScope {
+    std::vector<std::string> types;
+    std::vector<std::string> path_prefixes;
+
+    bool empty() const { return types.empty() && path_prefixes.empty(); }
+    bool applies(const std::string& type, const std::string& path) const;
+    std::string key() const;   // canonical form; equal scopes share one database
+};
+
 class ConfigManager {
 public:
     explicit ConfigManager() = default;
     bool loadFromFile(const std::string& config_path);
+    const std::string& configPath() const { return config_path_; }
 
     const std::string& getWatchMode()   const { return watch_mode_; }
     const std::string& getWatchTarget() const { return watch_target_; }
     const std::vector<std::string>& getPatternStrings() const { return pattern_strings_; }
+    // parallel to getPatternStrings()
+    const std::vector<PatternScope>& getPatternScopes() const { return pattern_scopes_; }
 
     std::string canonicalRulesJson() const;
     static std::string hashCanonical(const std::string& data);
+    std::string patternsHash() const { return hashCanonical(canonicalRulesJson()); }
+    // stable per-pattern id (hash prefix of the pattern string), parallel to getPatternStrings()
+    std::vector<std::string> patternIds() const;
+    const std::vector<DictionarySpec>& getDictionaries() const { return dictionaries_; }
+    // stable per-dictionary id (content hash + flags), parallel to getDictionaries()
+    std::vector<std::string> dictionaryIds() const;
+    const RulesetDelta& getRulesetDelta() const { return ruleset_delta_; }
     bool initRulesetVersion(sqlite3* db);
 
     std::uint64_t getRulesetVersion() const { return ruleset_version_; }
@@ -25,15 +73,79 @@ public:
     std::uint64_t max_file_size_sync_scan() const { return max_file_size_sync_scan_; }
     std::uint64_t getStatisticDurationSeconds() const { return duration_sec_; }
     WarmupMode getWarmupMode() const { return warmup_mode_; }
+    const std::string& l2_snapshot_path() const { return l2_snapshot_path_; }
+    std::uint64_t l2_snapshot_interval_sec() const { return l2_snapshot_interval_sec_; }
+    bool shared_cache_enabled() const { return shared_cache_enabled_; }
+    std::uint64_t shared_cache_slots() const { return shared_cache_slots_; }
+    bool content_hash_enabled() const { return content_hash_enabled_; }
+    std::uint64_t content_hash_max_entries() const { return content_hash_max_entries_; }
+    // directory for serialized Hyperscan databases; empty = always compile
+    const std::string& hs_db_cache_dir() const { return hs_db_cache_dir_; }
+    // reload-time delta tiers on top of the base database (1 = always recompile everything)
+    std::uint64_t pattern_max_tiers() const { return pattern_max_tiers_; }
+    std::uint64_t pattern_merge_interval_sec() const { return pattern_merge_interval_sec_; }
+    // miss path: small files from one fanotify read are scanned together
+    bool small_batch_enabled() const { return small_batch_enabled_; }
+    std::uint64_t small_batch_max_file_bytes() const { return small_batch_max_file_bytes_; }
+    std::uint64_t small_batch_max_files() const { return small_batch_max_files_; }
+    // PDF page workers and per-document page/time budget
+    const PdfLimits& pdf_limits() const { return pdf_limits_; }
+    // scan / skip / head-only per classified content kind
+    const TypePolicies& type_policies() const { return type_policies_; }
+    // nested decoding of gzip/xz/zstd/tar/zip files
+    const ArchiveLimits& archive_limits() const { return archive_limits_; }
+    // out-of-process PDF/office parsing
+    const ExtractorPoolOptions& extractor_pool() const { return extractor_pool_; }
+    // reusable per-worker scan buffers
+    const ScanContextOptions& scan_context() const { return scan_context_; }
+    // cap on file bytes held by all in-flight scans
+    const ByteBudgetOptions& memory_budget() const { return memory_budget_; }
+    // page-cache hygiene of background scans
+    const PageCacheOptions& page_cache() const { return page_cache_; }
+    // resume scans of growing text files at the previously scanned length
+    const AppendScanOptions& append_scan() const { return append_scan_; }
+    // rescan only the changed chunks of large files edited in place
+    const ChunkScanOptions& chunk_scan() const { return chunk_scan_; }
+    // background scan workers and scheduling
+    const AsyncQueueOptions& async_queue() const { return async_queue_; }
+    // runtime sizing of the sync miss pool and the async workers
+    const ConcurrencyOptions& concurrency() const { return concurrency_; }
 
 private:
+    std::string config_path_;
     std::string watch_mode_;
     std::string watch_target_;
     std::vector<std::string> pattern_strings_;
+    std::vector<PatternScope> pattern_scopes_;
+    std::vector<DictionarySpec> dictionaries_;
     std::uint64_t ruleset_version_ = 0;
     static std::uint64_t parse_size_kb_mb(const std::string& s);
     std::uint64_t cache_capacity_bytes_ = 0;
     std::uint64_t max_file_size_sync_scan_ = 0;
     std::uint64_t duration_sec_ = 0;
     WarmupMode warmup_mode_ = WarmupMode::None;
+    RulesetDelta ruleset_delta_;
+    std::string l2_snapshot_path_ = "cache/l2.snapshot";
+    std::uint64_t l2_snapshot_interval_sec_ = 300;
+    bool shared_cache_enabled_ = false;
+    std::uint64_t shared_cache_slots_ = 65536;
+    bool content_hash_enabled_ = false;
+    std::uint64_t content_hash_max_entries_ = 200000;
+    std::string hs_db_cache_dir_ = "cache";
+    std::uint64_t pattern_max_tiers_ = 4;
+    std::uint64_t pattern_merge_interval_sec_ = 300;
+    bool small_batch_enabled_ = false;
+    std::uint64_t small_batch_max_file_bytes_ = 4096;
+    std::uint64_t small_batch_max_files_ = 256;
+    PdfLimits pdf_limits_;
+    TypePolicies type_policies_;
+    ArchiveLimits archive_limits_;
+    ExtractorPoolOptions extractor_pool_;
+    ScanContextOptions scan_context_;
+    ByteBudgetOptions memory_budget_;
+    PageCacheOptions page_cache_;
+    AppendScanOptions append_scan_;
+    ChunkScanOptions chunk_scan_;
+    AsyncQueueOptions async_queue_;
+    ConcurrencyOptions concurrency_;
 };
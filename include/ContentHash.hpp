@@ -0,0 +1,34 @@
+// === include/ContentHash.hpp ===
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sqlite3.h>
+
+// 128-bit content fingerprint: two XXH64 lanes with independent, per-install seeds.
+struct ContentDigest {
+    uint64_t lo{0}, hi{0};
+    bool operator==(const ContentDigest& o) const noexcept { return lo == o.lo && hi == o.hi; }
+};
+
+uint64_t xxh64(const void* data, size_t len, uint64_t seed);
+
+// Content-fingerprint -> decision tier. Lets a new inode with already-seen
+// content skip extraction and matching. Rows are tied to ruleset_version.
+class ContentHashCache {
+public:
+    explicit ContentHashCache(sqlite3* db, uint64_t max_entries = 200000);
+
+    ContentDigest digest(const void* data, size_t len) const;
+    bool get(const ContentDigest& h, uint64_t size, uint64_t ruleset_version, int& decision);
+    void put(const ContentDigest& h, uint64_t size, uint64_t ruleset_version, int decision);
+
+private:
+    void prune_locked();
+
+    sqlite3*   db_{nullptr};
+    std::mutex mu_;
+    uint64_t   seed_{0};
+    uint64_t   max_entries_{0};
+    uint64_t   puts_since_prune_{0};
+};
@@ -1,13 +1,58 @@
-
+#pragma once
+#include "ArchiveDecoder.hpp"
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
+
+// Extracted text as segments for PatternMatcherHS::matches(segments); each segment
+// points into the raw content given to extract() or into 'owned'.
+struct ExtractedText {
+    std::vector<std::vector<char>> owned;     // extracted pages / converted documents
+    std::vector<std::string_view>  segments;  // scan order
+};
+
+// Page extraction limits for PDFs (config "pdf").
+struct PdfLimits {
+    unsigned      threads            = 4;   // page workers per document, also the process-wide cap
+    int           parallel_min_pages = 16;  // smaller documents stay on the calling thread
+    int           max_pages          = 0;   // 0 = every page
+    std::uint64_t time_budget_ms     = 0;   // 0 = no deadline
+};
 
 class ContentParser {
 public:
-    static std::string detect_type(const std::string& raw_content);
+    // FileClassifier kind name of the content ("text", "pdf", "docx", "elf", "image", ...)
+    static std::string detect_type(std::string_view raw_content);
 
-    static std::string extract_text(const std::string& type,
-                                    const std::string& file_path,
-                                    const std::string& raw_content,
-                                    int log_pipe_fd);
-};
+    // Extract text based on type without building one big string: plain content is
+    // the raw buffer itself, a PDF is one segment per page.
+    static void extract(const std::string& type,
+                        std::string_view raw_content,
+                        int log_pipe_fd,
+                        ExtractedText& out);
+
+    // PDF text one page at a time, pages in parallel for large documents (each worker
+    // loads its own Poppler document). on_page(index, text) may run on several threads
+    // at once and returns false to stop every worker. Stops early at the page/time budget.
+    // Out: pages delivered (0 = no text), -1 if the PDF cannot be loaded
+    static int extract_pdf_pages(std::string_view raw_content, int log_pipe_fd, const PdfLimits& limits,
+                                 const std::function<bool(int, std::string_view)>& on_page);
 
+    // OOXML/ODF documents one text part at a time (document body, shared strings,
+    // each slide...); on_part returns false to stop before the rest is inflated.
+    // *limited is set when a size limit cut the text short (logged).
+    // Out: false if raw_content is not a supported office document
+    static bool extract_office_parts(std::string_view raw_content, int log_pipe_fd,
+                                     const std::function<bool(std::string_view)>& on_part,
+                                     bool* limited = nullptr);
+
+    // gzip/xz/zstd/tar/zip file behind fd, streamed member by member into sink (see
+    // ArchiveDecoder); limit hits and corrupt members are logged.
+    // Out: ArchiveDecoder result: Limit = only part of the content reached the sink,
+    //      Error = the container itself could not be decoded (caller scans the raw bytes)
+    static ArchiveDecoder::Result extract_archive(int fd, size_t fsz, FileKind kind, const ArchiveLimits& limits,
+                                const TypePolicies* policies, int log_pipe_fd,
+                                const ArchiveDecoder::Sink& sink);
+};
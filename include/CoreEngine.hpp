@@ -4,11 +4,15 @@
 #include <sys/fanotify.h>
 #include <unistd.h>
 #include <sqlite3.h>
+#include <string>
+#include <vector>
 
 #include "ConfigManager.hpp"
 
 void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db);
 void start_core_engine_statistic(const ConfigManager& config);
 void start_core_engine_simulation(const ConfigManager& config, const std::string& filename = "");
+void start_core_engine_benchmark(const ConfigManager& config, int rounds = 5);
+void start_core_engine_dict_benchmark(const std::vector<size_t>& sizes);
 
 #endif // CORE_ENGINE_HPP
@@ -0,0 +1,84 @@
+// === include/ExtractorPool.hpp ===
+#pragma once
+#include "ContentParser.hpp"
+#include "FileClassifier.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+// Settings of the extractor pool (config "extractor_pool").
+struct ExtractorPoolOptions {
+    bool          enabled        = false;
+    unsigned      helpers        = 2;
+    std::uint64_t mem_limit_mb   = 1024;   // RLIMIT_AS per helper
+    std::uint64_t cpu_limit_sec  = 600;    // RLIMIT_CPU per helper (over its whole life)
+    std::uint64_t job_timeout_ms = 15000;  // a helper that takes longer is killed
+    std::uint64_t max_jobs       = 200;    // a helper is replaced after this many documents
+};
+
+// Long-lived helper processes that parse PDF and office documents out of process,
+// so a parser crash, hang or memory blow-up costs one helper instead of the daemon.
+// Helpers are the daemon binary re-executed in "extractor-helper" mode. A document
+// goes to a helper as a memfd (SCM_RIGHTS over a socketpair); its text comes back
+// part by part (PDF pages, office parts). Helpers are (re)started by a background
+// thread, never by a scanning thread: exec'ing the binary raises a permission event
+// that the event loop must be free to answer (see owns()).
+class ExtractorPool {
+public:
+    ExtractorPool() = default;
+    ~ExtractorPool();
+    ExtractorPool(const ExtractorPool&) = delete;
+    ExtractorPool& operator=(const ExtractorPool&) = delete;
+
+    // Start the spawner thread (helpers come up asynchronously).
+    // Out: false if the daemon binary cannot be located
+    bool start(const ExtractorPoolOptions& opt, int log_fd);
+    void stop();
+
+    // true if pid is one of the helpers (their own file opens are not scanned)
+    bool owns(pid_t pid) const;
+
+    // Text of a PDF/office document, one part per on_part call (false = stop).
+    // Waits up to job_timeout_ms for a free helper. *limited is set when a size limit
+    // cut an office document's text short.
+    // Out: parts delivered (0 = no text), -1 document could not be parsed,
+    //      -2 the helper crashed or timed out (it is replaced), -3 no helper available
+    int extract(FileKind kind, std::string_view raw, const PdfLimits& pdf,
+                const std::function<bool(std::string_view)>& on_part, bool* limited = nullptr);
+
+private:
+    struct Helper {
+        pid_t         pid{-1};
+        int           sock{-1};
+        std::uint64_t jobs{0};
+    };
+
+    void spawner_loop_();
+    bool spawn_(size_t slot);
+    void retire_(size_t slot, bool kill);
+    int  run_job_(Helper& h, FileKind kind, std::string_view raw, const PdfLimits& pdf,
+                  const std::function<bool(std::string_view)>& on_part, bool* limited);
+
+    ExtractorPoolOptions    opt_;
+    int                     log_fd_{-1};
+    std::string             exe_;
+    std::mutex              mu_;
+    std::condition_variable cv_;
+    std::vector<Helper>     helpers_;
+    std::unique_ptr<std::atomic<pid_t>[]> pids_;   // helper pids, read by owns()
+    std::vector<size_t>     idle_;                 // ready helpers
+    std::vector<size_t>     dead_;                 // slots waiting for the spawner
+    std::thread             spawner_;
+    bool                    running_{false};
+};
+
+// Entry point of a helper process: main() calls it for "extractor-helper <sock> <log_fd> <mem_mb> <cpu_sec>".
+int run_extractor_helper(int argc, char** argv);
@@ -0,0 +1,54 @@
+// === include/FileClassifier.hpp ===
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Content kinds told apart from the first bytes of a file. names() gives the
+// config / pattern-scope spelling ("text", "pdf", "docx", ...).
+enum class FileKind : uint8_t {
+    Text, Pdf, Office, Zip, Gzip, Zstd, Xz, Bzip2, SevenZip, Tar,
+    Elf, Pe, MachO, JavaClass, Wasm,
+    Image, Audio, Video, Font, Sqlite,
+    Binary,   // no known magic, not text
+    Random,   // no known magic, near-maximal entropy (encrypted or compressed)
+    Count
+};
+
+constexpr size_t kFileKindCount = static_cast<size_t>(FileKind::Count);
+
+// What the miss path does with a kind.
+enum class TypePolicy : uint8_t {
+    Scan,   // read and match the whole file
+    Skip,   // ALLOW without reading past the header
+    Head    // match only the first head_bytes
+};
+
+// Per-kind policies (config "type_policies"); every kind defaults to Scan.
+struct TypePolicies {
+    std::array<TypePolicy, kFileKindCount> by_kind{};
+    std::uint64_t head_bytes = 1u << 20;
+
+    TypePolicy of(FileKind k) const { return by_kind[static_cast<size_t>(k)]; }
+};
+
+// Result of FileClassifier::classify.
+struct FileClass {
+    FileKind kind{FileKind::Text};
+    double   entropy{0.0};   // bits per byte over the inspected head (0 if not computed)
+};
+
+// Table-driven magic-number lookup, then a text-vs-binary test (SSE2 when available)
+// and a byte-entropy estimate for headers no signature matches.
+class FileClassifier {
+public:
+    // bytes of the file head inspected; callers read at least this much when they can
+    static constexpr size_t kHeadBytes = 4096;
+
+    static FileClass classify(std::string_view head);
+    static const char* name(FileKind k);
+    // Out: false if 'name' is not a kind name
+    static bool fromName(const std::string& name, FileKind& out);
+};
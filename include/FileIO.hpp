@@ -0,0 +1,38 @@
+// === include/FileIO.hpp ===
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+
+// Small helpers shared by the on-disk formats (L2 snapshot, cached pattern databases)
+// and the extractor pool.
+
+// Desc: FNV-1a over a byte range (integrity checks of on-disk files)
+// In: const void* data, size_t len, uint64_t h (running hash)
+// Out: uint64_t
+inline std::uint64_t fnv1a64(const void* data, size_t len, std::uint64_t h = 1469598103934665603ULL) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Desc: write all bytes to fd, retrying on short writes and EINTR
+// In: int fd, const void* data, size_t len
+// Out: bool (true if everything was written)
+inline bool write_all(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t w = ::write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += w;
+        len -= static_cast<size_t>(w);
+    }
+    return true;
+}
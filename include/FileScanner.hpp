@@ -0,0 +1,61 @@
+// === include/FileScanner.hpp ===
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "ContentParser.hpp"
+#include "FileClassifier.hpp"
+#include <vector>
+
+class PatternMatcherHS;
+class ContentHashCache;
+class ExtractorPool;
+class ScanContext;
+class ByteBudget;
+class AppendIndex;
+class ChunkIndex;
+struct ScopedMatcher;
+
+// Everything the miss-path pipeline needs besides the file itself.
+struct ScanEnv {
+    const PatternMatcherHS* matcher{nullptr};
+    const PatternMatcherHS* dict{nullptr};       // optional literal dictionaries
+    const std::vector<ScopedMatcher>* scoped{nullptr}; // per type/path databases, picked per file
+    ContentHashCache*       dedup{nullptr};      // optional content-fingerprint tier
+    uint64_t                ruleset_version{0};
+    int                     log_fd{-1};
+    PdfLimits               pdf;                 // page workers and budget per PDF
+    const TypePolicies*     types{nullptr};      // optional scan/skip/head-only per content kind
+    const ArchiveLimits*    archives{nullptr};   // optional decoding of compressed files / archives
+    ExtractorPool*          extractors{nullptr}; // optional out-of-process PDF/office parsing
+    ScanContext*            ctx{nullptr};        // the worker's reusable buffers (nullptr = per scan)
+    ByteBudget*             budget{nullptr};     // optional cap on file bytes held by all scans
+    AppendIndex*            appends{nullptr};    // optional resume point of growing text files
+    ChunkIndex*             chunks{nullptr};     // optional chunk hashes of large files scanned clean
+};
+
+// Shared by the sync evaluator and the async workers:
+// read head -> classify (type policy) -> [archives: decode members from the fd] ->
+// [grown text file scanned clean before: match the appended bytes only] ->
+// memory budget (no room: stream text in chunks / documents wait) ->
+// read rest -> content-hash lookup -> [large file edited in place: changed chunks only] ->
+// extract -> match (unscoped, scopes covering type+path, dictionaries) -> record hash.
+// matched_ids (optional) receives the stable id of the pattern that caused a BLOCK.
+// Out: 0 = ALLOW, 1 = BLOCK, -1 = file could not be read completely
+int scan_file_contents(int fd, size_t fsz, const std::string& path, const ScanEnv& env,
+                       std::string* matched_ids = nullptr);
+
+// One small file of a batch (see scan_small_files).
+struct SmallFile {
+    int         fd{-1};
+    size_t      size{0};
+    std::string path;
+    int         verdict{-1};     // out: 0 = ALLOW, 1 = BLOCK, -1 = read failure
+    std::string matched_id;      // out: stable id of the pattern behind a BLOCK
+};
+
+// Batched miss path for many small files: one read arena, one scan of env.matcher
+// over all plain-text files with per-file attribution (a file it flags is confirmed
+// on its own), then scoped/dictionary matchers per file. Other types take
+// scan_file_contents().
+void scan_small_files(std::vector<SmallFile>& files, const ScanEnv& env);
@@ -0,0 +1,70 @@
+// === include/InodeMap.hpp ===
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <sys/types.h>
+#include <unordered_map>
+#include <utility>
+
+// Map keyed by (dev, ino) holding at most max_entries values; past that the oldest
+// inserted key goes first. Replacing a value keeps the key's place. Not thread-safe:
+// the owning index locks around it.
+template <class Value>
+class InodeMap {
+public:
+    explicit InodeMap(std::uint64_t max_entries) : max_entries_(std::max<std::uint64_t>(max_entries, 1)) {}
+
+    Value* find(dev_t dev, ino_t ino) {
+        auto it = map_.find(Key{dev, ino});
+        return it == map_.end() ? nullptr : &it->second.value;
+    }
+    const Value* find(dev_t dev, ino_t ino) const {
+        auto it = map_.find(Key{dev, ino});
+        return it == map_.end() ? nullptr : &it->second.value;
+    }
+
+    // insert or replace the value of (dev, ino)
+    void put(dev_t dev, ino_t ino, Value v) {
+        const Key key{dev, ino};
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            it->second.value = std::move(v);
+            return;
+        }
+        map_.emplace(key, Slot{std::move(v), ++seq_});
+        order_.emplace_back(key, seq_);
+        while (order_.size() > max_entries_) {
+            // a key erased and inserted again has a newer seq: only its latest slot counts
+            auto old = map_.find(order_.front().first);
+            if (old != map_.end() && old->second.seq == order_.front().second) map_.erase(old);
+            order_.pop_front();
+        }
+    }
+
+    // its (key, seq) stays in the FIFO until it reaches the front
+    void erase(dev_t dev, ino_t ino) { map_.erase(Key{dev, ino}); }
+
+private:
+    struct Key {
+        dev_t dev;
+        ino_t ino;
+        bool operator==(const Key& o) const noexcept { return dev == o.dev && ino == o.ino; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const noexcept {
+            return std::hash<std::uint64_t>()(static_cast<std::uint64_t>(k.ino) * 0x9E3779B97F4A7C15ull ^
+                                              static_cast<std::uint64_t>(k.dev));
+        }
+    };
+    struct Slot {
+        Value         value;
+        std::uint64_t seq;
+    };
+
+    std::unordered_map<Key, Slot, KeyHash>    map_;
+    std::deque<std::pair<Key, std::uint64_t>> order_;   // (key, seq) by insertion, oldest first
+    std::uint64_t                             seq_{0};
+    const std::uint64_t                       max_entries_;
+};
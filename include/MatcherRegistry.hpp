@@ -0,0 +1,62 @@
+// === include/MatcherRegistry.hpp ===
+#pragma once
+#include "ConfigManager.hpp"
+#include "PatternMatcherHS.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Patterns sharing one scope, compiled into their own database; scanned only
+// for events whose content type and path the scope covers.
+struct ScopedMatcher {
+    PatternScope             scope;
+    std::vector<std::string> pattern_ids;
+    PatternMatcherHS         matcher;
+};
+
+// One compiled generation of the pattern set. Immutable once published;
+// scans keep their set alive through the shared_ptr they loaded.
+struct MatcherSet {
+    uint64_t         generation{0};
+    uint64_t         ruleset_version{0};
+    std::string      patterns_hash;
+    // source of 'full', the unscoped patterns (a background merge recompiles it as one tier)
+    std::vector<std::string> patterns;
+    std::vector<std::string> pattern_ids;
+    std::vector<std::string> dict_ids;
+    // base database + delta tiers from reloads, until merged
+    PatternMatcherHS full;
+    // one database per distinct pattern scope
+    std::vector<ScopedMatcher> scoped;
+    // literal dictionaries, scanned alongside 'full' (never ready if none configured)
+    PatternMatcherHS dict;
+    // patterns added since delta_base_version (lazy revalidation of older ALLOWs)
+    PatternMatcherHS delta;
+    std::vector<ScopedMatcher> delta_scoped;
+    bool             has_delta{false};
+    uint64_t         delta_base_version{0};
+};
+
+// RCU-style publication point for the active MatcherSet: readers take a
+// reference with current(); a reload builds a new set off to the side and
+// swaps it in with publish(). The old set is freed by its last reader.
+class MatcherRegistry {
+public:
+    std::shared_ptr<const MatcherSet> current() const { return std::atomic_load(&cur_); }
+    uint64_t generation() const { return gen_.load(std::memory_order_acquire); }
+    void publish(std::shared_ptr<MatcherSet> set);
+
+    // Compile cfg's patterns (full set + added-pattern delta); nullptr on failure.
+    // With prev and max_tiers > 1, prev's databases are reused and only added
+    // patterns are compiled (one more delta tier on 'full').
+    static std::shared_ptr<MatcherSet> build(const ConfigManager& cfg, const std::string& cache_dir,
+                                             const MatcherSet* prev = nullptr, size_t max_tiers = 1);
+    // Same patterns and ruleset as cur, with 'full' recompiled into a single tier.
+    static std::shared_ptr<MatcherSet> merge(const MatcherSet& cur, const std::string& cache_dir);
+
+private:
+    std::shared_ptr<const MatcherSet> cur_;
+    std::atomic<uint64_t>             gen_{0};
+};
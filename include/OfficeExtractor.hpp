@@ -0,0 +1,26 @@
+// === include/OfficeExtractor.hpp ===
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Native text extraction for ZIP-based office documents (DOCX, XLSX, PPTX, ODT, ODS, ODP).
+// Works on the file already in memory: the ZIP central directory is read from the end,
+// only the text parts are inflated (zlib), and XML markup is stripped while inflating.
+class OfficeExtractor {
+public:
+    // Decompression limits (zip-bomb guard)
+    static constexpr size_t kMaxPartBytes  = 64u << 20;   // inflated XML per part
+    static constexpr size_t kMaxTotalBytes = 256u << 20;  // inflated XML per document
+
+    // Pass the text of each part (markup stripped) to on_part in document order:
+    // word/document.xml, xl/sharedStrings.xml, ppt/slides/slideN.xml (by N), content.xml.
+    // on_part returns false to stop; later parts are then never inflated. A part cut
+    // short by a size limit still passes the text inflated up to the limit, and
+    // *limited is set (so is error).
+    // Out: false if 'zip' is not a ZIP holding one of those parts (error says why)
+    static bool extract(std::string_view zip,
+                        const std::function<bool(std::string_view)>& on_part,
+                        std::string* error = nullptr, bool* limited = nullptr);
+};
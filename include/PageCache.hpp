@@ -0,0 +1,38 @@
+// === include/PageCache.hpp ===
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+
+// Settings of page-cache hygiene for background scans (config "page_cache").
+struct PageCacheOptions {
+    bool          enabled        = false;
+    std::uint64_t min_file_bytes = 8ull << 20;   // smaller files are left alone
+};
+
+// Read hints that keep background scans from evicting the applications' working set.
+// A guard taken before the scan remembers which pages were already cached for the
+// user (cachestat, else mincore); afterwards only the pages the scan itself pulled
+// in are dropped (POSIX_FADV_DONTNEED), and only once the process that opened the
+// file no longer holds it open: pages it read during the scan are its own.
+class PageCache {
+public:
+    class ScanGuard {
+    public:
+        // SEQUENTIAL readahead + residency snapshot (no-op for small files or when disabled)
+        // opener: pid that opened the file (0 = none, e.g. warmup)
+        ScanGuard(int fd, size_t fsz, const PageCacheOptions& opt, pid_t opener = 0);
+        // drop what the scan brought in
+        ~ScanGuard();
+        ScanGuard(const ScanGuard&) = delete;
+        ScanGuard& operator=(const ScanGuard&) = delete;
+
+    private:
+        int                        fd_{-1};
+        size_t                     fsz_{0};
+        pid_t                      opener_{0};
+        bool                       all_cold_{false};   // nothing was cached: drop everything
+        std::vector<unsigned char> resident_;          // per page (mincore) when partly cached
+    };
+};
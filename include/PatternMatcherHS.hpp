@@ -1,37 +1,140 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <hs/hs.h>
 
 class ConfigManager;
+struct DictionarySpec;
 
-// High-performance multi-regex matcher built on Hyperscan.
+// High-performance multi-regex matcher built on Hyperscan (vectored-mode databases).
+// A matcher is a list of tiers scanned in order: a stable base database plus small
+// delta databases holding patterns added since the base was compiled. Compiled tiers
+// are immutable and shared between matchers, so copies are cheap.
 class PatternMatcherHS {
 public:
     PatternMatcherHS();
     ~PatternMatcherHS();
+    PatternMatcherHS(const PatternMatcherHS&) = default;
+    PatternMatcherHS& operator=(const PatternMatcherHS&) = default;
 
     // Build (or rebuild) from ConfigManager's pattern strings.
+    // With a cache_dir, a serialized database for the same patterns and host
+    // platform is loaded instead of compiling (and written after a compile).
     // Returns false if compilation fails.
-    bool buildFromConfig(const ConfigManager& cfg);
+    bool buildFromConfig(const ConfigManager& cfg, const std::string& cache_dir = "");
+    // Build from an explicit pattern list; ids are the stable ids reported on match.
+    bool buildFromPatterns(const std::vector<std::string>& pats,
+                           const std::vector<std::string>& stable_ids);
+    // buildFromPatterns() through the serialized database cache ("" = no cache).
+    bool buildCached(const std::vector<std::string>& pats, const std::vector<std::string>& stable_ids,
+                     const std::string& patterns_hash, const std::string& cache_dir);
 
-    // Fast boolean check: does any pattern match 'text'?
-    bool matches(const std::string& text) const;
+    // Tiered rebuild: share prev's compiled tiers, compile only the patterns prev does not
+    // have into one new delta tier, and mask patterns that were removed. Returns false
+    // (leaving this matcher empty) if prev is not a regex matcher or the result would
+    // exceed max_tiers; the caller then does a full build.
+    bool buildIncremental(const PatternMatcherHS& prev, const std::vector<std::string>& pats,
+                          const std::vector<std::string>& stable_ids, size_t max_tiers);
+
+    // Literal databases (hs_compile_lit_multi): every line of a dictionary is matched
+    // verbatim and reports that dictionary's stable id. Much cheaper to compile and scan
+    // than the same strings as regexes.
+    bool buildFromDictionaries(const std::vector<DictionarySpec>& dicts,
+                               const std::vector<std::string>& stable_ids,
+                               const std::string& cache_dir = "");
+    bool buildFromLiterals(const std::vector<std::string>& literals,
+                           const std::string& stable_id, bool caseless);
+
+    // Fast boolean check: does any pattern match 'text'? Optionally reports the
+    // index of the first pattern that matched (see stableId()).
+    bool matches(std::string_view text, unsigned* matched_id = nullptr) const;
+    // Same over a list of segments (pages, chunks, mapped regions) scanned as one
+    // logical buffer with hs_scan_vector: no concatenation, matches may span segments.
+    bool matches(const std::vector<std::string_view>& segments, unsigned* matched_id = nullptr) const;
+    const std::string& stableId(unsigned id) const;
+    // Every active match over the segments: on_hit(id, end offset in the logical
+    // concatenation); return false to stop. Used for batched small-file scans.
+    bool forEachMatch(const std::vector<std::string_view>& segments,
+                      const std::function<bool(unsigned, unsigned long long)>& on_hit) const;
+    // Can several files be scanned glued into one buffer with per-file attribution?
+    // Not if a pattern depends on buffer edges (^, $, \A, \z, \Z, \b, \B outside classes) or
+    // a literal tier reports each dictionary only once per scan (single-match).
+    bool batchable() const;
+    // Longest match any pattern can produce, in bytes (kUnbounded for patterns such as
+    // "a.*b", or when it is not known). A part of a file matched with this much context
+    // on both sides sees every match that touches it.
+    static constexpr unsigned kUnbounded = ~0u;
+    unsigned maxWidth() const { return max_width_; }
+
+    // Serialized database cache (see PatternMatcherHSCache.cpp)
+    static std::string cachePath(const std::string& dir, const std::string& patterns_hash);
+    bool saveDatabase(const std::string& path) const;
+    bool loadDatabase(const std::string& path, const std::vector<std::string>& stable_ids,
+                      bool literal = false);
+
+    // Hyperscan scratch of one scanning thread. One scratch serves every matcher; it is
+    // regrown when the thread moves to another database and freed with its owner.
+    struct Scratch {
+        hs_scratch_t* s{nullptr};
+        uint64_t      gen{0};
+        Scratch() = default;
+        ~Scratch();
+        Scratch(const Scratch&) = delete;
+        Scratch& operator=(const Scratch&) = delete;
+    };
+    // Scratch for the calling thread's scans (a ScanContext's); nullptr = a thread-local
+    // one, freed when the thread exits.
+    static void bindScratch(Scratch* s);
 
     // Optional helpers
     size_t patternCount() const { return count_; }
     bool   isReady()      const { return ready_; }
+    size_t databaseBytes() const;
+    size_t scratchBytes()  const;
+    size_t tierCount()    const { return tiers_.size(); }
+    size_t maskedCount()  const;
 
 private:
+    // One compiled database; match id i reports stable_ids[i]
+    struct Tier {
+        hs_database_t*           db{nullptr};
+        std::vector<std::string> stable_ids;
+        size_t                   expressions{0};
+        bool                     literal{false};
+        ~Tier();
+    };
+
     // HS state
-    hs_database_t* db_{nullptr};
-    hs_scratch_t*  base_scratch_{nullptr};
+    std::vector<std::shared_ptr<const Tier>> tiers_;
+    std::vector<size_t>  offsets_;  // global match id of each tier's first id
+    std::vector<uint8_t> masked_;   // by global id: 1 = pattern removed, hits ignored
+    std::shared_ptr<hs_scratch_t> base_scratch_; // large enough for every tier
     bool           ready_{false};
+    bool           anchored_{false};
+    unsigned       max_width_{0};
     size_t         count_{0};
+    // identity of the tier list for the per-thread scratch (new value on every build/load)
+    uint64_t       scratch_gen_{0};
 
-    // For safe per-thread scanning we clone scratch lazily.
-    static thread_local hs_scratch_t* tls_scratch_;
+    // For safe per-thread scanning we clone scratch lazily into the bound Scratch
+    static thread_local Scratch* tls_bound_;
 
     // Internal helpers
     void freeAll_() noexcept;
+    static uint64_t nextScratchGen();
+    bool scanVector_(const char* const* data, const unsigned* lens, unsigned count,
+                     unsigned* matched_id) const;
+    hs_scratch_t* prepareScratch_() const;
+    static bool anyAnchored_(const std::vector<std::string>& pats);
+    static unsigned maxWidth_(const std::vector<std::string>& pats);
+    bool adoptSingle_(hs_database_t* db, const std::vector<std::string>& stable_ids,
+                      size_t expressions, bool literal);
+    const std::string& globalStableId_(size_t gid) const;
+    bool compileLiterals_(const std::vector<const char*>& lits, const std::vector<size_t>& lens,
+                          const std::vector<unsigned>& ids, const std::vector<unsigned>& flags,
+                          const std::vector<std::string>& stable_ids);
 };
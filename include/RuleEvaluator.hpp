@@ -2,22 +2,65 @@
 #define RULE_EVALUATOR_HPP
 
 #include "ConfigManager.hpp"
-#include "PatternMatcherHS.hpp"
+#include "MatcherRegistry.hpp"
+#include "ScanContext.hpp"
 #include <linux/fanotify.h>
 #include <string>
+#include <vector>
+#include <sys/types.h>
+
+class ContentHashCache;
+class ExtractorPool;
+class ByteBudget;
+class AppendIndex;
+class ChunkIndex;
+
+// A small-file miss waiting in a batch (see handle_small_batch).
+struct BatchEvent {
+    int         fd{-1};          // event fd; closed once answered
+    pid_t       pid{0};
+    size_t      size{0};
+    int         decision{0};     // out: 0 = ALLOW, 1 = BLOCK
+    std::string matched;         // out: stable id of the pattern behind a BLOCK
+};
 
 class RuleEvaluator {
 public:
-    RuleEvaluator(const ConfigManager& config, const PatternMatcherHS& matcher);
+    RuleEvaluator(const ConfigManager& config, const MatcherRegistry& registry);
+    // optional content-fingerprint tier for the miss path
+    void set_content_hash_cache(ContentHashCache* dedup) { dedup_ = dedup; }
+    // optional helper processes for PDF/office parsing
+    void set_extractor_pool(ExtractorPool* extractors) { extractors_ = extractors; }
+    // optional memory governor shared with the async workers
+    void set_byte_budget(ByteBudget* budget) { budget_ = budget; }
+    // optional resume points of growing text files (shared with the async workers)
+    void set_append_index(AppendIndex* appends) { appends_ = appends; }
+    // optional chunk hashes of large files (shared with the async workers)
+    void set_chunk_index(ChunkIndex* chunks) { chunks_ = chunks; }
     
     // main handler: takes fanotify event and returns whether to allow or deny
+    // set: pattern generation to scan with (nullptr = the registry's current one)
+    // delta_only: scan with set->delta (only newly added patterns)
+    // out_matched: stable id of the pattern behind a BLOCK
 void handle_event(int fan_fd,
                   const struct fanotify_event_metadata* metadata,
                   int log_pipe_fd,
-                  int& out_decision);
+                  int& out_decision,
+                  std::string* out_matched = nullptr,
+                  const MatcherSet* set = nullptr,
+                  bool delta_only = false);
+    // scan a batch of small files together and answer every event
+    void handle_small_batch(int fan_fd, std::vector<BatchEvent>& events, int log_pipe_fd,
+                            const MatcherSet* set = nullptr);
 private:
     const ConfigManager& config;
-    const PatternMatcherHS& matcher;
+    const MatcherRegistry& registry;
+    ContentHashCache* dedup_{nullptr};
+    ExtractorPool* extractors_{nullptr};
+    ByteBudget* budget_{nullptr};
+    AppendIndex* appends_{nullptr};
+    ChunkIndex* chunks_{nullptr};
+    ScanContextPool contexts_;   // per-scan buffers + scratch, reused by the miss threads
 };
 
 #endif // RULE_EVALUATOR_HPP
@@ -0,0 +1,97 @@
+// === include/ScanContext.hpp ===
+#pragma once
+#include "PatternMatcherHS.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Settings of the per-worker scan state (config "scan_context").
+struct ScanContextOptions {
+    std::uint64_t memory_ceiling_mb = 64;     // buffer bytes a context keeps between scans
+    bool          huge_pages        = false;  // madvise(MADV_HUGEPAGE) on buffers >= 2 MB
+};
+
+// Page-aligned anonymous mapping reused across scans. Growing keeps the bytes
+// already read (mremap) and never zero-fills: pages are touched only by pread.
+class ScanBuffer {
+public:
+    ScanBuffer() = default;
+    ~ScanBuffer();
+    ScanBuffer(const ScanBuffer&) = delete;
+    ScanBuffer& operator=(const ScanBuffer&) = delete;
+
+    // Capacity of at least n bytes, contents kept. Out: nullptr if mapping fails
+    char* reserve(size_t n, bool huge_pages);
+    void  release();
+    char*  data()     const { return p_; }
+    size_t capacity() const { return cap_; }
+
+private:
+    char*  p_{nullptr};
+    size_t cap_{0};
+};
+
+// Everything one scanning worker reuses from file to file: the file buffer, the
+// small-batch arena and the Hyperscan scratch. Buffers that grew past the memory
+// ceiling for one large file are unmapped again by trim(), so an idle context holds
+// at most the ceiling plus its scratch.
+class ScanContext {
+public:
+    explicit ScanContext(const ScanContextOptions& opt = ScanContextOptions{});
+
+    ScanBuffer& file()  { return file_; }
+    ScanBuffer& batch() { return batch_; }
+    bool huge_pages() const { return opt_.huge_pages; }
+
+    // after a scan: give back buffers above the ceiling
+    void trim();
+    size_t retained_bytes() const { return file_.capacity() + batch_.capacity(); }
+
+    // Makes the calling thread's matchers use this context's scratch while in scope.
+    class Bind {
+    public:
+        explicit Bind(ScanContext& ctx) { PatternMatcherHS::bindScratch(&ctx.scratch_); }
+        ~Bind() { PatternMatcherHS::bindScratch(nullptr); }
+        Bind(const Bind&) = delete;
+        Bind& operator=(const Bind&) = delete;
+    };
+
+private:
+    ScanContextOptions        opt_;
+    ScanBuffer                file_;
+    ScanBuffer                batch_;
+    PatternMatcherHS::Scratch scratch_;
+};
+
+// Contexts for short-lived scanning threads (the sync miss path): a thread leases one
+// for its scan and returns it, so buffers and scratch outlive the thread.
+class ScanContextPool {
+public:
+    explicit ScanContextPool(const ScanContextOptions& opt = ScanContextOptions{}) : opt_(opt) {}
+
+    class Lease {
+    public:
+        Lease(ScanContextPool& pool, std::unique_ptr<ScanContext> ctx)
+            : pool_(pool), ctx_(std::move(ctx)), bind_(*ctx_) {}
+        ~Lease();
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ScanContext& operator*() const { return *ctx_; }
+        ScanContext* get() const { return ctx_.get(); }
+
+    private:
+        ScanContextPool&             pool_;
+        std::unique_ptr<ScanContext> ctx_;
+        ScanContext::Bind            bind_;
+    };
+
+    // an idle context (or a new one), bound to the calling thread until the lease ends
+    Lease acquire();
+
+private:
+    ScanContextOptions                        opt_;
+    std::mutex                                mu_;
+    std::vector<std::unique_ptr<ScanContext>> idle_;
+};
@@ -0,0 +1,33 @@
+// === include/ZipReader.hpp ===
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One entry of a ZIP central directory.
+struct ZipEntry {
+    std::string name;
+    uint16_t    method{0};        // 0 = stored, 8 = deflate
+    bool        encrypted{false};
+    uint64_t    comp_size{0};
+    uint64_t    size{0};          // uncompressed size as recorded
+    uint64_t    local_off{0};
+};
+
+// Central-directory reader for a ZIP held in memory or read from an fd with pread
+// (ZIP64 aware). Shared by the office extractor and the archive decoder.
+class ZipReader {
+public:
+    // Entries in directory order. Out: false if there is no directory or it is corrupt
+    static bool list(std::string_view zip, std::vector<ZipEntry>& out, std::string* error = nullptr);
+    // Compressed bytes of an entry (after its local header). Out: false if out of bounds
+    static bool data(std::string_view zip, const ZipEntry& e, std::string_view& out, std::string* error = nullptr);
+
+    // Same for a file of fsz bytes; only the directory (at most max_dir_bytes) is held
+    // in memory. A file that shrinks meanwhile reads short instead of faulting.
+    static bool list(int fd, uint64_t fsz, uint64_t max_dir_bytes, std::vector<ZipEntry>& out,
+                     std::string* error = nullptr);
+    // file offset of an entry's compressed bytes (comp_size of them)
+    static bool data(int fd, uint64_t fsz, const ZipEntry& e, uint64_t& off, std::string* error = nullptr);
+};
@@ -11,6 +11,7 @@ struct StartupResult {
     std::string error;              
     std::vector<std::string> logs;
     ConfigManager config;
+    std::string db_path;
     std::unique_ptr<sqlite3, void(*)(sqlite3*)> db{nullptr, [](sqlite3* p){ if (p) sqlite3_close(p); }};
 };
 
@@ -18,6 +19,13 @@ class Requirements {
 public:
     static StartupResult run(const std::string& config_path,
                              const std::string& db_path);
+    // Delete cache rows of older ruleset versions on a separate connection
+    // (startup no longer blocks on it; CacheL1 already ignores stale rows).
+    // A patterns-only delta first migrates rows that stay valid. Runs are serialized;
+    // a run for an older ruleset stops once a newer one has been requested.
+    static void startBackgroundInvalidation(const std::string& db_path,
+                                            std::uint64_t ruleset_version,
+                                            const RulesetDelta& delta);
 
 private:
     static void ensureDir(const char* path, StartupResult& out);
@@ -1,18 +1,27 @@
 // main.cpp
 #include "CoreEngine.hpp"
+#include "ExtractorPool.hpp"
 #include "requirements.hpp"
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <vector>
 
 void print_help() {
     std::cout << "Usage:\n"
               << "  ./filegaurde                Run in blocking mode (default)\n"
               << "  ./filegaurde statistic      Run in statistic gathering mode\n"
               << "  ./filegaurde simulation     Run in simulation mode\n"
+              << "  ./filegaurde benchmark [N]  Compare pattern compile vs cached database load\n"
+              << "  ./filegaurde benchmark dict [sizes...]  Literal dictionaries vs regexes\n"
               << "  ./filegaurde -h, --help     Show this help message\n";
 }
 
 int main(int argc, char** argv) {
+    // extractor helper process (spawned by the daemon's ExtractorPool, not by users)
+    if (argc > 1 && std::string(argv[1]) == "extractor-helper") {
+        return run_extractor_helper(argc, argv);
+    }
     // Handle help flag early
     if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
         print_help();
@@ -44,7 +53,25 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    // "benchmark dict" mode: literal dictionaries vs regexes (synthetic data)
+    if (argc > 2 && std::string(argv[1]) == "benchmark" && std::string(argv[2]) == "dict") {
+        std::vector<size_t> sizes;
+        for (int i = 3; i < argc; ++i) sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+        if (sizes.empty()) sizes = {100000, 250000, 500000, 1000000};
+        start_core_engine_dict_benchmark(sizes);
+        return 0;
+    }
+
+    // "benchmark" mode
+    if (argc > 1 && std::string(argv[1]) == "benchmark") {
+        int rounds = (argc > 2) ? std::atoi(argv[2]) : 5;
+        start_core_engine_benchmark(boot.config, rounds);
+        return 0;
+    }
+
     // default: blocking mode
+    Requirements::startBackgroundInvalidation(boot.db_path, boot.config.getRulesetVersion(),
+                                              boot.config.getRulesetDelta());
     start_core_engine_blocking(boot.config, boot.db.get());
     return 0;
 }
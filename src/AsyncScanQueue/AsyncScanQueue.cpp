@@ -1,21 +1,31 @@
 #include "AsyncScanQueue.hpp"
 #include <mutex>
 #include <condition_variable>
-#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
 #include <utility>
 #include "ConfigManager.hpp"
 #include "CacheL1.hpp"
 #include "CacheL2.hpp"
-#include "ContentParser.hpp"
-#include "PatternMatcherHS.hpp"
+#include "FileScanner.hpp"
+#include "MatcherRegistry.hpp"
+#include "ScanContext.hpp"
+#include "PageCache.hpp"
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <functional>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <string>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <sched.h>
@@ -32,50 +42,380 @@
 #endif
 
 namespace {
+    // queued task plus its place in the per-class indexes
+    struct QueuedTask {
+        AsyncScanTask task;
+        uint64_t      seq;   // enqueue order (smaller = older)
+    };
+    struct FileKey {
+        dev_t dev;
+        ino_t ino;
+        bool operator<(const FileKey& o) const { return dev != o.dev ? dev < o.dev : ino < o.ino; }
+    };
+
     std::mutex                g_mtx;
     std::condition_variable   g_cv;
-    std::deque<AsyncScanTask> g_q;
+    std::unordered_map<uint64_t, QueuedTask> g_tasks;                            // by seq
+    std::set<std::pair<size_t, uint64_t>>   g_by_size[kAsyncScanClasses];      // (size, seq): shortest first
+    std::set<uint64_t>                      g_by_age[kAsyncScanClasses];       // seq: oldest first
+    std::map<FileKey, uint64_t>             g_queued;                          // (dev, ino) -> seq
+    std::map<int, int>                      g_mount_fds;                       // mount id -> fd of its root (-1: none)
+    uint64_t                  g_seq = 0;
+    uint64_t                  g_queued_bytes = 0;
+    size_t                    g_open_fds = 0;
+    std::chrono::milliseconds g_max_wait{AsyncQueueOptions{}.max_wait_ms};
+    uint64_t                  g_max_tasks = AsyncQueueOptions{}.max_tasks;
+    uint64_t                  g_max_bytes = AsyncQueueOptions{}.max_queued_mb << 20;
+    size_t                    g_max_fds   = AsyncQueueOptions{}.max_open_fds;
+    AsyncQueueStats           g_stats;
     bool                      g_shutdown = false;
-    std::vector<std::thread>  g_workers;
+    size_t                    g_workers_wanted  = 0;   // set by start/set_async_workers
+    size_t                    g_workers_running = 0;   // workers not yet retired (g_mtx)
+
+    // one background worker; 'done' is set once its loop has returned
+    struct Worker {
+        std::thread                        th;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::mutex                g_workers_mtx;   // guards g_workers and g_worker_main
+    std::vector<Worker>       g_workers;
+    std::function<void()>     g_worker_main;   // worker loop bound to the engine's state
     std::atomic<bool>         g_started{false};
 }
 
+// Desc: add a queued task to the indexes of its class (g_mtx held)
+// In: const QueuedTask& q
+// Out: void
+static void index_task(const QueuedTask& q) {
+    const size_t c = static_cast<size_t>(q.task.cls);
+    g_by_size[c].emplace(q.task.size, q.seq);
+    g_by_age[c].insert(q.seq);
+    g_queued_bytes += q.task.size;
+}
+
+// Desc: remove a queued task from the indexes of its class (g_mtx held)
+// In: const QueuedTask& q
+// Out: void
+static void unindex_task(const QueuedTask& q) {
+    const size_t c = static_cast<size_t>(q.task.cls);
+    g_by_size[c].erase(std::make_pair(q.task.size, q.seq));
+    g_by_age[c].erase(q.seq);
+    g_queued_bytes -= q.task.size;
+}
+
+// Desc: take a task out of the queue entirely (g_mtx held)
+// In: uint64_t seq
+// Out: AsyncScanTask
+static AsyncScanTask remove_task(uint64_t seq) {
+    auto it = g_tasks.find(seq);
+    unindex_task(it->second);
+    AsyncScanTask t = std::move(it->second.task);
+    g_tasks.erase(it);
+    auto qi = g_queued.find(FileKey{t.dev, t.ino});
+    if (qi != g_queued.end() && qi->second == seq) g_queued.erase(qi);
+    if (t.fd >= 0) --g_open_fds;
+    return t;
+}
+
+// Desc: the task to serve next: the oldest one past max_wait, else the smallest of the
+//       most urgent non-empty class (g_mtx held, queue not empty)
+// In: bool& aged (set if picked by age)
+// Out: uint64_t (seq)
+static uint64_t pick_task(bool& aged) {
+    const auto now = std::chrono::steady_clock::now();
+    aged = false;
+    uint64_t pick = 0;
+    for (size_t c = 0; c < kAsyncScanClasses; ++c) {
+        if (g_by_age[c].empty()) continue;
+        const uint64_t seq = *g_by_age[c].begin();
+        if (now - g_tasks[seq].task.enqueued < g_max_wait) continue;
+        if (!aged || seq < pick) pick = seq;
+        aged = true;
+    }
+    if (aged) return pick;
+    for (size_t c = 0; c < kAsyncScanClasses; ++c) {
+        if (!g_by_size[c].empty()) return g_by_size[c].begin()->second;
+    }
+    return 0;
+}
+
+// Desc: make room for a task of class cls and size bytes by evicting less urgent tasks
+//       (largest of the least urgent class first); evicted tasks are moved to 'evicted'.
+//       The victims are chosen first: if they cannot make enough room, nothing is evicted.
+//       (g_mtx held)
+// In: AsyncScanClass cls, size_t size, std::vector<AsyncScanTask>& evicted
+// Out: bool (false if the queue is full of work at least as urgent)
+static bool make_room(AsyncScanClass cls, size_t size, std::vector<AsyncScanTask>& evicted) {
+    size_t tasks = g_tasks.size();
+    uint64_t bytes = g_queued_bytes;
+    auto full = [&]() { return tasks > 0 && (tasks + 1 > g_max_tasks || bytes + size > g_max_bytes); };
+    std::vector<uint64_t> victims;
+    for (size_t c = kAsyncScanClasses; c > 0 && full(); --c) {
+        const auto vcls = static_cast<AsyncScanClass>(c - 1);
+        if (vcls < cls) break;
+        for (auto it = g_by_size[c - 1].rbegin(); it != g_by_size[c - 1].rend() && full(); ++it) {
+            if (vcls == cls && it->first <= size) break;
+            victims.push_back(it->second);
+            --tasks;
+            bytes -= it->first;
+        }
+    }
+    if (full()) return false;
+    for (uint64_t seq : victims) evicted.push_back(remove_task(seq));
+    return true;
+}
+
+// Desc: open the root directory of a mount, for open_by_handle_at (which refuses O_PATH
+//       fds). The mount point comes from /proc/self/mountinfo; the fd is checked to be on
+//       that very mount (not hidden by another mount on top). Unlike an fd of a user file,
+//       it keeps no unlinked file alive.
+// In: int mount_id
+// Out: int (fd, -1 if the mount cannot be opened)
+static int open_mount_root(int mount_id) {
+    FILE* f = std::fopen("/proc/self/mountinfo", "re");
+    if (!f) return -1;
+    char line[8192];
+    std::string point;
+    while (std::fgets(line, sizeof(line), f)) {
+        // "<id> <parent> <major:minor> <root> <mount point> ..."
+        int id = 0;
+        char mp[4096];
+        if (std::sscanf(line, "%d %*d %*s %*s %4095s", &id, mp) != 2 || id != mount_id) continue;
+        // octal escapes for space, tab, newline and backslash
+        for (const char* p = mp; *p; ++p) {
+            if (p[0] == '\\' && p[1] >= '0' && p[1] <= '3' && p[2] >= '0' && p[2] <= '7' && p[3] >= '0' && p[3] <= '7') {
+                point += static_cast<char>(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0'));
+                p += 3;
+            } else {
+                point += *p;
+            }
+        }
+        break;
+    }
+    std::fclose(f);
+    if (point.empty()) return -1;
+    const int fd = ::open(point.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    std::vector<char> buf(sizeof(struct file_handle) + MAX_HANDLE_SZ);
+    auto* fh = reinterpret_cast<struct file_handle*>(buf.data());
+    fh->handle_bytes = MAX_HANDLE_SZ;
+    int id = 0;
+    if (::name_to_handle_at(fd, "", fh, &id, AT_EMPTY_PATH) != 0 || id != mount_id) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Desc: replace the task's fd with a file handle (or, where the filesystem has none, its
+//       path) so it can wait in the queue without holding an fd (g_mtx held)
+// In: AsyncScanTask& t
+// Out: bool (false if the file cannot be named without its fd)
+static bool park_task(AsyncScanTask& t) {
+    std::vector<char> buf(sizeof(struct file_handle) + MAX_HANDLE_SZ);
+    auto* fh = reinterpret_cast<struct file_handle*>(buf.data());
+    fh->handle_bytes = MAX_HANDLE_SZ;
+    int mount_id = 0;
+    bool named = false;
+    if (::name_to_handle_at(t.fd, "", fh, &mount_id, AT_EMPTY_PATH) == 0) {
+        // open_by_handle_at needs an fd on the mount: its root is opened once per mount
+        auto mi = g_mount_fds.find(mount_id);
+        if (mi == g_mount_fds.end()) mi = g_mount_fds.emplace(mount_id, open_mount_root(mount_id)).first;
+        if (mi->second >= 0) {
+            buf.resize(sizeof(struct file_handle) + fh->handle_bytes);
+            t.handle.swap(buf);
+            t.mount_id = mount_id;
+            named = true;
+        }
+    }
+    if (!named) {
+        char link[64];
+        snprintf(link, sizeof(link), "/proc/self/fd/%d", t.fd);
+        char path[4096];
+        const ssize_t n = ::readlink(link, path, sizeof(path) - 1);
+        if (n <= 0 || path[0] != '/') return false;
+        path[n] = '\0';
+        t.path = path;   // an unlinked file reads "... (deleted)" and fails the reopen check
+    }
+    ::close(t.fd);
+    t.fd = -1;
+    return true;
+}
 
-// Desc: enqueue a scan task into the async queue
-// In: int dup_fd, pid_t pid, size_t size
+// Desc: reopen a parked task's file and check it is still the queued inode
+// In: AsyncScanTask& t, int mount_fd
+// Out: bool
+static bool reopen_task(AsyncScanTask& t, int mount_fd) {
+    int fd = -1;
+    if (!t.handle.empty()) {
+        fd = ::open_by_handle_at(mount_fd, reinterpret_cast<struct file_handle*>(t.handle.data()),
+                                 O_RDONLY | O_CLOEXEC);
+    } else if (!t.path.empty()) {
+        fd = ::open(t.path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_dev != t.dev || st.st_ino != t.ino) {
+        ::close(fd);
+        return false;
+    }
+    t.fd = fd;
+    return true;
+}
+
+
+// Desc: apply queue bounds and scheduling settings; the fd budget is capped at a quarter
+//       of RLIMIT_NOFILE so fanotify always has fds left
+// In: const AsyncQueueOptions& opt
 // Out: void
-void enqueue_async_scan(int dup_fd, pid_t pid, size_t size) {
+void configure_async_scan_queue(const AsyncQueueOptions& opt) {
+    size_t max_fds = static_cast<size_t>(opt.max_open_fds);
+    struct rlimit rl{};
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+        max_fds = std::min<size_t>(max_fds, static_cast<size_t>(rl.rlim_cur / 4));
+    }
+    std::lock_guard<std::mutex> lk(g_mtx);
+    g_max_wait  = std::chrono::milliseconds(opt.max_wait_ms);
+    g_max_tasks = std::max<uint64_t>(opt.max_tasks, 1);
+    g_max_bytes = opt.max_queued_mb << 20;
+    g_max_fds   = max_fds;
+}
+
+
+// Desc: enqueue a scan task into the async queue; a file already queued is not queued
+//       twice (its task moves up to the more urgent class); when the queue is full the
+//       least urgent task is evicted or, if nothing queued is less urgent, this one is
+//       refused; past the fd budget the task waits as a file handle
+// In: int dup_fd, pid_t pid, size_t size, AsyncScanClass cls, uint64_t delta_version
+// Out: bool (false if refused; dup_fd is closed either way)
+bool enqueue_async_scan(int dup_fd, pid_t pid, size_t size, AsyncScanClass cls, uint64_t delta_version) {
     AsyncScanTask t{dup_fd, pid, size};
+    t.cls           = cls;
+    t.delta_version = delta_version;
+    t.enqueued = std::chrono::steady_clock::now();
+    struct stat st{};
+    const bool keyed = ::fstat(dup_fd, &st) == 0;
+    if (keyed) { t.dev = st.st_dev; t.ino = st.st_ino; }
+    std::vector<AsyncScanTask> evicted;
+    bool admitted = true;
     {
         std::lock_guard<std::mutex> lk(g_mtx);
-        g_q.emplace_back(std::move(t));
+        auto it = keyed ? g_queued.find(FileKey{t.dev, t.ino}) : g_queued.end();
+        if (it != g_queued.end()) {
+            // the queued task reads the same inode at scan time; keep its age
+            QueuedTask& q = g_tasks[it->second];
+            unindex_task(q);
+            if (cls < q.task.cls) q.task.cls = cls;
+            // a delta scan only stands in for both if both asked for the same delta
+            if (q.task.delta_version != delta_version) q.task.delta_version = 0;
+            q.task.size = size;
+            index_task(q);
+            ++g_stats.deduped;
+            ::close(dup_fd);
+            return true;
+        }
+        admitted = !g_shutdown && make_room(cls, size, evicted);
+        g_stats.dropped += evicted.size() + (admitted ? 0 : 1);
+        if (admitted) {
+            if (g_open_fds >= g_max_fds && keyed && park_task(t)) ++g_stats.parked;
+            if (t.fd >= 0) ++g_open_fds;
+            const uint64_t seq = ++g_seq;
+            QueuedTask& q = g_tasks[seq];
+            q.task = std::move(t);
+            q.seq  = seq;
+            index_task(q);
+            if (keyed) g_queued[FileKey{q.task.dev, q.task.ino}] = seq;
+            ++g_stats.enqueued[static_cast<size_t>(cls)];
+        }
+    }
+    for (auto& e : evicted) {
+        if (e.fd >= 0) ::close(e.fd);
+    }
+    if (!admitted) {
+        ::close(dup_fd);
+        return false;
     }
     g_cv.notify_one();
+    return true;
 }
 
 
-// Desc: wait for and pop one scan task from queue
+// Desc: wait for and pop the next scan task (see pick_task); parked tasks are reopened,
+//       and skipped if their file is gone or was replaced
 // In: AsyncScanTask& out
-// Out: bool (false if shutdown and empty)
+// Out: bool (false if shutdown and empty, or if this worker is retired by a smaller pool)
 bool wait_dequeue_async_scan(AsyncScanTask& out) {
-    std::unique_lock<std::mutex> lk(g_mtx);
-    g_cv.wait(lk, []{ return g_shutdown || !g_q.empty(); });
-    if (g_shutdown && g_q.empty()) return false;
-    out = std::move(g_q.front());
-    g_q.pop_front();
-    return true;
+    for (;;) {
+        int mount_fd = -1;
+        {
+            std::unique_lock<std::mutex> lk(g_mtx);
+            g_cv.wait(lk, []{ return g_shutdown || g_workers_running > g_workers_wanted || !g_tasks.empty(); });
+            if (g_shutdown && g_tasks.empty()) return false;
+            if (g_workers_running > g_workers_wanted) {
+                --g_workers_running;
+                return false;
+            }
+            bool aged = false;
+            out = remove_task(pick_task(aged));
+            ++g_stats.served[static_cast<size_t>(out.cls)];
+            if (aged) ++g_stats.aged;
+            if (out.fd >= 0) return true;
+            auto mi = g_mount_fds.find(out.mount_id);
+            if (mi != g_mount_fds.end()) mount_fd = mi->second;
+        }
+        if (reopen_task(out, mount_fd)) return true;
+        std::lock_guard<std::mutex> lk(g_mtx);
+        ++g_stats.reopen_failed;
+    }
 }
 
 
-// Desc: signal shutdown to all worker threads
+// Desc: signal shutdown to all worker threads; pending (best-effort) tasks are dropped
 // In: (none)
 // Out: void
 void shutdown_async_scan_queue() {
+    std::unordered_map<uint64_t, QueuedTask> dropped;
     {
         std::lock_guard<std::mutex> lk(g_mtx);
         g_shutdown = true;
+        dropped.swap(g_tasks);
+        for (size_t c = 0; c < kAsyncScanClasses; ++c) {
+            g_by_size[c].clear();
+            g_by_age[c].clear();
+        }
+        g_queued.clear();
+        g_queued_bytes = 0;
+        g_open_fds = 0;
     }
     g_cv.notify_all();
+    for (auto& kv : dropped) {
+        if (kv.second.task.fd >= 0) ::close(kv.second.task.fd);
+    }
+}
+
+
+// Desc: snapshot of the queue counters and per-class depth
+// In: (none)
+// Out: AsyncQueueStats
+AsyncQueueStats async_scan_queue_stats() {
+    std::lock_guard<std::mutex> lk(g_mtx);
+    AsyncQueueStats s = g_stats;
+    for (size_t c = 0; c < kAsyncScanClasses; ++c) s.depth[c] = g_by_age[c].size();
+    s.open_fds = g_open_fds;
+    return s;
+}
+
+
+// Desc: printable name of a scan class
+// In: AsyncScanClass cls
+// Out: const char*
+const char* async_scan_class_name(AsyncScanClass cls) {
+    switch (cls) {
+        case AsyncScanClass::Miss:       return "miss";
+        case AsyncScanClass::Revalidate: return "revalidate";
+        case AsyncScanClass::Warmup:     return "warmup";
+    }
+    return "?";
 }
 
 
@@ -116,66 +456,139 @@ static void set_thread_background_mode() {
 
 
 // Desc: worker loop to read file, extract text, match rules, cache decision
-// In: int log_write_fd, const ConfigManager* config, CacheManager* cache
+// In: int log_write_fd, const ConfigManager* config, const MatcherRegistry* registry, CacheL2* l2,
+//     ContentHashCache* dedup, ExtractorPool* extractors, ByteBudget* budget, AppendIndex* appends,
+//     ChunkIndex* chunks
 // Out: void
 static void async_worker_loop(int log_write_fd,
                               const ConfigManager* config,
-                              const PatternMatcherHS* matcher,
-                              CacheL2* l2)
+                              const MatcherRegistry* registry,
+                              CacheL2* l2,
+                              ContentHashCache* dedup,
+                              ExtractorPool* extractors,
+                              ByteBudget* budget,
+                              AppendIndex* appends,
+                              ChunkIndex* chunks)
 {
     set_thread_background_mode();
+    // this worker's buffers and Hyperscan scratch, reused for every task
+    ScanContext ctx(config->scan_context());
+    ScanContext::Bind bind(ctx);
     for (;;) {
         AsyncScanTask t;
         if (!wait_dequeue_async_scan(t)) break;
 
         int decision = 0; // 0 = ALLOW
+        std::string matched;
+        // pattern generation current at dequeue time; the result is tagged with its version
+        std::shared_ptr<const MatcherSet> set = registry->current();
+        if (!set) { if (t.fd >= 0) ::close(t.fd); continue; }
         struct stat st{};
         if (fstat(t.fd, &st) == 0 && st.st_size > 0) {
             size_t fsz = static_cast<size_t>(st.st_size);
-            std::vector<char> buffer(fsz);
-            ssize_t done = 0;
-            while (static_cast<size_t>(done) < fsz) {
-                ssize_t r = pread(t.fd, buffer.data() + done, fsz - done, done);
-                if (r <= 0) break;
-                done += r;
-            }
             char linkpath[64];
             snprintf(linkpath, sizeof(linkpath), "/proc/self/fd/%d", t.fd);
             char path_buf[512] = {0};
             ssize_t n = readlink(linkpath, path_buf, sizeof(path_buf)-1);
             if (n < 0) path_buf[0] = '\0';
             else path_buf[n] = '\0';
-            if (static_cast<size_t>(done) == fsz) {
-                std::string header(buffer.data(), std::min<size_t>(5, buffer.size()));
-                std::string type = ContentParser::detect_type(header);
-                std::string extracted = ContentParser::extract_text(
-                    type,std::string(path_buf), std::string(buffer.data(), buffer.size()), log_write_fd
-                );
-                if (matcher && matcher->matches(extracted)) {
-                    decision = 1; // BLOCK
-                }
+
+            // revalidation: only the patterns added since the file was allowed, as long as
+            // the set is still the generation the task was queued against
+            const bool use_delta = t.delta_version != 0 && set->has_delta &&
+                                   set->ruleset_version == t.delta_version;
+            ScanEnv env;
+            env.matcher         = use_delta ? &set->delta : &set->full;
+            env.dict            = use_delta ? nullptr : &set->dict;
+            env.scoped          = use_delta ? &set->delta_scoped : &set->scoped;
+            env.dedup           = dedup;
+            env.ruleset_version = set->ruleset_version;
+            env.log_fd          = log_write_fd;
+            env.pdf             = config->pdf_limits();
+            env.types           = &config->type_policies();
+            env.archives        = &config->archive_limits();
+            env.extractors      = extractors;
+            env.ctx             = &ctx;
+            env.budget          = budget;
+            env.appends         = appends;
+            env.chunks          = chunks;
+            // a background read must not evict the applications' cached data
+            PageCache::ScanGuard cache_guard(t.fd, fsz, config->page_cache(), t.pid);
+            if (scan_file_contents(t.fd, fsz, std::string(path_buf), env, &matched) == 1) {
+                decision = 1; // BLOCK
             }
         }
-        l2->put(st, config->getRulesetVersion(), decision, config->max_cache_bytes());
+        l2->put(st, set->ruleset_version, decision, config->max_cache_bytes(), matched);
         if (t.fd >= 0) ::close(t.fd);
+        ctx.trim();
     }
 }
 
 // Desc: start N background async scan workers (idempotent)
-// In: int log_write_fd, const ConfigManager& config, CacheManager& cache, size_t num_workers
+// In: int log_write_fd, const ConfigManager& config, const MatcherRegistry* registry, CacheL2& l2,
+//     size_t num_workers, ContentHashCache* dedup, ExtractorPool* extractors, ByteBudget* budget,
+//     AppendIndex* appends, ChunkIndex* chunks
 // Out: void
 void start_async_workers(int log_write_fd,
                          const ConfigManager& config,
-                         const PatternMatcherHS* matcher,
+                         const MatcherRegistry* registry,
                          CacheL2& l2,
-                         size_t num_workers)
+                         size_t num_workers,
+                         ContentHashCache* dedup,
+                         ExtractorPool* extractors,
+                         ByteBudget* budget,
+                         AppendIndex* appends,
+                         ChunkIndex* chunks)
 {
     if (g_started.exchange(true)) return; // already started
+    {
+        std::lock_guard<std::mutex> wl(g_workers_mtx);
+        g_worker_main = [=, &config, &l2]() {
+            async_worker_loop(log_write_fd, &config, registry, &l2, dedup, extractors, budget, appends, chunks);
+        };
+    }
+    set_async_workers(num_workers);
+}
+
+
+// Desc: resize the worker pool: new workers start at once, surplus ones retire after
+//       their current task (no-op before start_async_workers)
+// In: size_t num_workers (at least 1)
+// Out: void
+void set_async_workers(size_t num_workers) {
     if (num_workers == 0) num_workers = 1;
-    g_workers.reserve(num_workers);
-    for (size_t i = 0; i < num_workers; ++i) {
-        g_workers.emplace_back(async_worker_loop, log_write_fd, &config, matcher, &l2);
+    std::lock_guard<std::mutex> wl(g_workers_mtx);
+    if (!g_worker_main) return;
+    // join the workers that retired since the last resize
+    for (auto it = g_workers.begin(); it != g_workers.end();) {
+        if (!it->done->load()) { ++it; continue; }
+        if (it->th.joinable()) it->th.join();
+        it = g_workers.erase(it);
     }
+    size_t spawn = 0;
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        g_workers_wanted = num_workers;
+        if (g_workers_running < num_workers) {
+            spawn = num_workers - g_workers_running;
+            g_workers_running = num_workers;
+        }
+    }
+    g_cv.notify_all();
+    for (size_t i = 0; i < spawn; ++i) {
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::function<void()> main = g_worker_main;
+        g_workers.push_back(Worker{std::thread([main, done]() { main(); done->store(true); }), done});
+    }
+}
+
+
+// Desc: current target size of the worker pool
+// In: (none)
+// Out: size_t
+size_t async_worker_count() {
+    std::lock_guard<std::mutex> lk(g_mtx);
+    return g_workers_wanted;
 }
 
 
@@ -184,9 +597,21 @@ void start_async_workers(int log_write_fd,
 // Out: void
 void stop_async_workers_and_join() {
     shutdown_async_scan_queue();
-    for (auto& th : g_workers) {
-        if (th.joinable()) th.join();
+    {
+        std::lock_guard<std::mutex> wl(g_workers_mtx);
+        for (auto& w : g_workers) {
+            if (w.th.joinable()) w.th.join();
+        }
+        g_workers.clear();
+        g_worker_main = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        g_shutdown = false;
+        g_workers_wanted  = 0;
+        g_workers_running = 0;
+        for (auto& kv : g_mount_fds) if (kv.second >= 0) ::close(kv.second);
+        g_mount_fds.clear();
     }
-    g_workers.clear();
     g_started = false;
 }
\ No newline at end of file
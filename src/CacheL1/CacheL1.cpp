@@ -168,9 +168,9 @@
     #endif
 
     // Desc: check cache for file and fetch decision if metadata matches
-    // In: const struct stat& st, uint64_t ruleset_version, int& decision
+    // In: const struct stat& st, uint64_t ruleset_version, int& decision, bool* needs_delta
     // Out: bool (true=hit, false=miss)
-    bool CacheL1::get(const struct stat& st, uint64_t ruleset_version, int& decision) {
+    bool CacheL1::get(const struct stat& st, uint64_t ruleset_version, int& decision, bool* needs_delta) {
     if (!db_) return false;
 
     const char* sql =
@@ -186,6 +186,7 @@
     sqlite3_bind_int64(stmt, 2, static_cast<long long>(st.st_ino));
 
     bool hit = false;
+    const uint64_t delta_base = delta_base_version_.load(std::memory_order_acquire);
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         const long long row_mtime_ns    = sqlite3_column_int64(stmt, 0);
@@ -205,6 +206,14 @@
             row_ctime_ns    == cur_ctime_ns) {
             decision = row_decision;
             hit = true;
+        } else if (needs_delta && delta_base != 0 &&
+                   row_ruleset_ver == static_cast<long long>(delta_base) &&
+                   row_decision    == 0 &&
+                   row_mtime_ns    == cur_mtime_ns &&
+                   row_size        == static_cast<long long>(st.st_size) &&
+                   row_ctime_ns    == cur_ctime_ns) {
+            // clean under the previous patterns: only the added ones need a scan
+            *needs_delta = true;
         }
     }
 
@@ -232,9 +241,11 @@
 
 
     // Desc: upsert cache entry; may evict if over capacity
-    // In: const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes
+    // In: const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes,
+    //     const std::string& matched_ids (stable ids of the patterns behind a BLOCK)
     // Out: void
-    void CacheL1::put(const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes) {
+    void CacheL1::put(const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes,
+                      const std::string& matched_ids) {
         if (!db_) return;
 
         #ifdef DEBUG
@@ -250,8 +261,8 @@
 
         const char* sql =
             "INSERT OR REPLACE INTO cache_entries "
-            "(dev, ino, mtime_ns, ctime_ns, size, ruleset_version, decision, last_access_ts, hit_count) "
-            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, 0);";
+            "(dev, ino, mtime_ns, ctime_ns, size, ruleset_version, decision, last_access_ts, hit_count, matched_ids) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, 0, ?);";
 
         sqlite3_stmt* stmt = nullptr;
         if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
@@ -272,9 +283,45 @@
         sqlite3_bind_int64(stmt, 6, static_cast<long long>(ruleset_version));
         sqlite3_bind_int(stmt,   7, decision);
         sqlite3_bind_int64(stmt, 8, now);
+        sqlite3_bind_text(stmt,  9, matched_ids.c_str(), -1, SQLITE_TRANSIENT);
 
         (void)sqlite3_step(stmt);
         (void)sqlite3_finalize(stmt);
     }
 
 
+    // Desc: fetch the most frequently hit rows that are valid for a ruleset
+    // In: uint64_t ruleset_version, size_t limit
+    // Out: std::vector<Row> (hottest first)
+    std::vector<CacheL1::Row> CacheL1::hottest(uint64_t ruleset_version, size_t limit) {
+        std::vector<Row> rows;
+        if (!db_ || limit == 0) return rows;
+
+        const char* sql =
+            "SELECT dev, ino, mtime_ns, ctime_ns, size, decision, last_access_ts, hit_count "
+            "FROM cache_entries WHERE ruleset_version=? "
+            "ORDER BY hit_count DESC, last_access_ts DESC "
+            "LIMIT ?;";
+
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            return rows;
+        }
+        sqlite3_bind_int64(stmt, 1, static_cast<long long>(ruleset_version));
+        sqlite3_bind_int64(stmt, 2, static_cast<long long>(limit));
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            Row r;
+            r.dev            = sqlite3_column_int64(stmt, 0);
+            r.ino            = sqlite3_column_int64(stmt, 1);
+            r.mtime_ns       = sqlite3_column_int64(stmt, 2);
+            r.ctime_ns       = sqlite3_column_int64(stmt, 3);
+            r.size           = sqlite3_column_int64(stmt, 4);
+            r.decision       = sqlite3_column_int(stmt,   5);
+            r.last_access_ts = sqlite3_column_int64(stmt, 6);
+            r.hit_count      = static_cast<uint64_t>(sqlite3_column_int64(stmt, 7));
+            rows.push_back(r);
+        }
+        (void)sqlite3_finalize(stmt);
+        return rows;
+    }
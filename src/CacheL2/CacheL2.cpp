@@ -1,5 +1,6 @@
 #include "CacheL2.hpp"
 #include "CacheL1.hpp"
+#include "CacheShm.hpp"
 #include <ctime>
 #include <mutex>
 #include <iostream>
@@ -177,8 +178,55 @@ bool CacheL2::check_capacity(uint64_t max_bytes) const {
 }
 
 
+// Desc: fill free L2 capacity with the hottest L1 rows of the current ruleset
+// In: uint64_t ruleset_version, uint64_t max_bytes
+// Out: size_t (entries inserted)
+size_t CacheL2::preload_from_l1(uint64_t ruleset_version, uint64_t max_bytes) {
+    if (!l1_) return 0;
+    const uint64_t node_bytes = sizeof(Key) + sizeof(Entry) + sizeof(void*);
+    const uint64_t used = sum_cached_file_sizes();
+    if (used >= max_bytes) return 0;
+    const size_t limit = static_cast<size_t>((max_bytes - used) / node_bytes);
+
+    std::vector<CacheL1::Row> rows;
+    {
+        std::lock_guard<std::mutex> lk(g_l1_mu);
+        rows = l1_->hottest(ruleset_version, limit);
+    }
+
+    size_t loaded = 0;
+    std::unique_lock wlk(mu_);
+    for (const auto& r : rows) {
+        const uint64_t bucket_bytes = static_cast<uint64_t>(map_.bucket_count()) * sizeof(void*);
+        if (bucket_bytes + (map_.size() + 1) * node_bytes >= max_bytes) break;
+        Entry ent{};
+        ent.mtime_ns       = r.mtime_ns;
+        ent.ctime_ns       = r.ctime_ns;
+        ent.size           = r.size;
+        ent.decision       = r.decision;
+        ent.last_access_ts = r.last_access_ts;
+        ent.hit_count      = r.hit_count;
+        ent.generation     = ruleset_version;
+        if (map_.emplace(Key{r.dev, r.ino}, ent).second) ++loaded;
+    }
+    return loaded;
+}
+
+// Desc: erase entries decided under a previous generation (they can never hit again)
+// In: (none)
+// Out: size_t (entries removed)
+size_t CacheL2::purge_stale() {
+    const uint64_t gen = generation_.load(std::memory_order_acquire);
+    size_t removed = 0;
+    std::unique_lock wlk(mu_);
+    for (auto it = map_.begin(); it != map_.end(); ) {
+        if (it->second.generation != gen) { it = map_.erase(it); ++removed; }
+        else ++it;
+    }
+    return removed;
+}
+
 int CacheL2::get(const struct stat& st, uint64_t ruleset_version, int& decision,uint64_t max_bytes) {
-    (void)ruleset_version; // used only if we consult L1
     const Key k{ static_cast<int64_t>(st.st_dev), static_cast<int64_t>(st.st_ino) };
     const int64_t cur_mtime_ns = to_ns(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
     const int64_t cur_ctime_ns = to_ns(st.st_ctim.tv_sec, st.st_ctim.tv_nsec);
@@ -193,7 +241,8 @@ int CacheL2::get(const struct stat& st, uint64_t ruleset_version, int& decision,
         auto it = map_.find(k);
         if (it != map_.end()) {
             const Entry& e = it->second;
-            if (e.mtime_ns == cur_mtime_ns &&
+            if (e.generation == ruleset_version &&
+                e.mtime_ns == cur_mtime_ns &&
                 e.ctime_ns == cur_ctime_ns &&
                 e.size     == cur_size) {
                 decision = e.decision;
@@ -211,12 +260,37 @@ int CacheL2::get(const struct stat& st, uint64_t ruleset_version, int& decision,
         }
     }
 
+    CacheShm* shm = shm_.load(std::memory_order_acquire);
+    if (shm && ruleset_version == generation_.load(std::memory_order_acquire)) {
+        int d = 0;
+        if (shm->get(st, d)) {
+            #ifdef DEBUG
+            std::cout << "[shm] Cache hit — served from shared tier" << std::endl;
+            #endif
+            Entry ent{};
+            ent.mtime_ns = cur_mtime_ns;
+            ent.ctime_ns = cur_ctime_ns;
+            ent.size = cur_size;
+            ent.decision = d;
+            ent.last_access_ts = static_cast<int64_t>(std::time(nullptr));
+            ent.hit_count = 0;
+            ent.generation = ruleset_version;
+            if (check_capacity(max_bytes)) {
+                std::unique_lock wlk(mu_);
+                map_[k] = ent;
+            }
+            decision = d;
+            return 3;
+        }
+    }
+
     if (l1_) {
         #ifdef DEBUG_TIMING
         auto t_l1_start = Clock::now();
         #endif
         int d = 0;
-        if (l1_->get(st, ruleset_version, d)) {
+        bool needs_delta = false;
+        if (l1_->get(st, ruleset_version, d, &needs_delta)) {
             if (!check_capacity(max_bytes)) {
                 #ifdef LFU_SIZE
                 // std::cout << "\033[31m"
@@ -249,6 +323,7 @@ int CacheL2::get(const struct stat& st, uint64_t ruleset_version, int& decision,
             ent.decision = d;
             ent.last_access_ts = static_cast<int64_t>(std::time(nullptr));
             ent.hit_count = 0;
+            ent.generation = ruleset_version;
 
             std::unique_lock wlk(mu_);
             map_[k] = ent;
@@ -260,6 +335,7 @@ int CacheL2::get(const struct stat& st, uint64_t ruleset_version, int& decision,
             #endif
             return 1;
         }
+        if (needs_delta) return 4;
     }
     #ifdef DEBUG
     std::cout << "[MISS] Not found in any cache — reading from source" << std::endl;
@@ -268,11 +344,15 @@ int CacheL2::get(const struct stat& st, uint64_t ruleset_version, int& decision,
     return 0;
 }
 
-void CacheL2::put(const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes) {
+void CacheL2::put(const struct stat& st, uint64_t ruleset_version, int decision, uint64_t max_bytes,
+                  const std::string& matched_ids) {
      if (l1_) {
         std::lock_guard<std::mutex> lk(g_l1_mu);   // <-- افزودن این خط
-        l1_->put(st, ruleset_version, decision, max_bytes);
+        l1_->put(st, ruleset_version, decision, max_bytes, matched_ids);
     }
+    // decided by a matcher generation that has since been replaced: keep it out of memory tiers
+    if (ruleset_version != generation_.load(std::memory_order_acquire)) return;
+    if (CacheShm* shm = shm_.load(std::memory_order_acquire)) shm->put(st, decision);
 
     if (!check_capacity(max_bytes)) {
         #ifdef LFU_SIZE
@@ -305,6 +385,7 @@ void CacheL2::put(const struct stat& st, uint64_t ruleset_version, int decision,
     ent.decision = decision;
     ent.last_access_ts = static_cast<int64_t>(std::time(nullptr));
     ent.hit_count = 0;
+    ent.generation = ruleset_version;
 
     {
         std::unique_lock wlk(mu_);
@@ -0,0 +1,163 @@
+// === src/CacheL2/CacheL2Snapshot.cpp ===
+#include "CacheL2.hpp"
+#include "FileIO.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk layout: SnapshotHeader followed by `count` SnapshotRecord entries,
+// ordered hottest first so a smaller cache keeps the most useful part.
+static const char     kSnapshotMagic[8] = {'F','G','L','2','S','N','A','P'};
+static const uint32_t kSnapshotFormat   = 1;
+
+struct SnapshotHeader {
+    char     magic[8];
+    uint32_t format;
+    uint32_t record_size;
+    uint64_t ruleset_version;
+    uint64_t count;
+    uint64_t checksum;
+};
+
+struct SnapshotRecord {
+    int64_t  dev;
+    int64_t  ino;
+    int64_t  mtime_ns;
+    int64_t  ctime_ns;
+    int64_t  size;
+    int64_t  last_access_ts;
+    uint64_t hit_count;
+    int32_t  decision;
+    int32_t  reserved;
+};
+
+// Desc: persist L2 entries and hotness to a binary snapshot (tmp file + rename)
+// In: const std::string& path, uint64_t ruleset_version
+// Out: bool (true on success)
+bool CacheL2::save_snapshot(const std::string& path, uint64_t ruleset_version) const {
+    if (path.empty()) return false;
+
+    std::vector<SnapshotRecord> recs;
+    {
+        std::shared_lock rlk(mu_);
+        recs.reserve(map_.size());
+        for (const auto& kv : map_) {
+            if (kv.second.generation != ruleset_version) continue; // superseded by a reload
+            SnapshotRecord r{};
+            r.dev            = kv.first.dev;
+            r.ino            = kv.first.ino;
+            r.mtime_ns       = kv.second.mtime_ns;
+            r.ctime_ns       = kv.second.ctime_ns;
+            r.size           = kv.second.size;
+            r.last_access_ts = kv.second.last_access_ts;
+            r.hit_count      = kv.second.hit_count;
+            r.decision       = kv.second.decision;
+            recs.push_back(r);
+        }
+    }
+
+    // hottest first: hit_count DESC, last_access_ts DESC
+    std::sort(recs.begin(), recs.end(), [](const SnapshotRecord& a, const SnapshotRecord& b){
+        if (a.hit_count != b.hit_count) return a.hit_count > b.hit_count;
+        return a.last_access_ts > b.last_access_ts;
+    });
+
+    SnapshotHeader hdr{};
+    std::memcpy(hdr.magic, kSnapshotMagic, sizeof(hdr.magic));
+    hdr.format          = kSnapshotFormat;
+    hdr.record_size     = static_cast<uint32_t>(sizeof(SnapshotRecord));
+    hdr.ruleset_version = ruleset_version;
+    hdr.count           = static_cast<uint64_t>(recs.size());
+    hdr.checksum        = fnv1a64(recs.data(), recs.size() * sizeof(SnapshotRecord));
+
+    const std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "[L2] snapshot open failed: " << tmp << " (" << std::strerror(errno) << ")\n";
+        return false;
+    }
+    bool ok = write_all(fd, &hdr, sizeof(hdr)) &&
+              write_all(fd, recs.data(), recs.size() * sizeof(SnapshotRecord)) &&
+              ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "[L2] snapshot write failed: " << path << " (" << std::strerror(errno) << ")\n";
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    #ifdef DEBUG
+    std::cout << "[L2] snapshot saved: entries=" << recs.size() << " ver=" << ruleset_version << std::endl;
+    #endif
+    return true;
+}
+
+// Desc: mmap a snapshot and bulk-load it into L2 if it matches the current ruleset
+// In: const std::string& path, uint64_t ruleset_version, uint64_t max_bytes
+// Out: size_t (number of entries loaded; 0 if missing/stale/corrupt)
+size_t CacheL2::load_snapshot(const std::string& path, uint64_t ruleset_version, uint64_t max_bytes) {
+    if (path.empty()) return 0;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        return 0;
+    }
+    const size_t file_len = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return 0;
+    (void)::madvise(base, file_len, MADV_SEQUENTIAL);
+
+    size_t loaded = 0;
+    const auto* hdr  = static_cast<const SnapshotHeader*>(base);
+    const auto* recs = reinterpret_cast<const SnapshotRecord*>(static_cast<const char*>(base) + sizeof(SnapshotHeader));
+    const size_t rec_bytes = file_len - sizeof(SnapshotHeader);
+
+    if (std::memcmp(hdr->magic, kSnapshotMagic, sizeof(hdr->magic)) != 0 ||
+        hdr->format != kSnapshotFormat ||
+        hdr->record_size != sizeof(SnapshotRecord) ||
+        hdr->count != rec_bytes / sizeof(SnapshotRecord) ||
+        rec_bytes % sizeof(SnapshotRecord) != 0) {
+        std::cerr << "[L2] snapshot ignored (bad header): " << path << "\n";
+    } else if (hdr->ruleset_version != ruleset_version) {
+        #ifdef DEBUG
+        std::cout << "[L2] snapshot ignored (ruleset " << hdr->ruleset_version
+                  << " != " << ruleset_version << ")" << std::endl;
+        #endif
+    } else if (fnv1a64(recs, rec_bytes) != hdr->checksum) {
+        std::cerr << "[L2] snapshot ignored (checksum mismatch): " << path << "\n";
+    } else {
+        const uint64_t node_bytes = sizeof(Key) + sizeof(Entry) + sizeof(void*);
+        std::unique_lock wlk(mu_);
+        const uint64_t fit = max_bytes / node_bytes;
+        map_.reserve(map_.size() + static_cast<size_t>(std::min<uint64_t>(hdr->count, fit)));
+        const uint64_t bucket_bytes = static_cast<uint64_t>(map_.bucket_count()) * sizeof(void*);
+        for (uint64_t i = 0; i < hdr->count; ++i) {
+            if (bucket_bytes + (map_.size() + 1) * node_bytes >= max_bytes) break;
+            const SnapshotRecord& r = recs[i];
+            Entry ent{};
+            ent.mtime_ns       = r.mtime_ns;
+            ent.ctime_ns       = r.ctime_ns;
+            ent.size           = r.size;
+            ent.decision       = r.decision;
+            ent.last_access_ts = r.last_access_ts;
+            ent.hit_count      = r.hit_count;
+            ent.generation     = ruleset_version;
+            // entries already present were refreshed after the snapshot was taken
+            if (map_.emplace(Key{r.dev, r.ino}, ent).second) ++loaded;
+        }
+    }
+
+    ::munmap(base, file_len);
+    return loaded;
+}
@@ -0,0 +1,253 @@
+// === src/CacheShm/CacheShm.cpp ===
+#include "CacheShm.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint64_t kShmMagic  = 0x464753484D4C3202ULL; // "FGSHML2" + format 2
+static const size_t   kProbe     = 8;                     // linear-probe window
+// segment names: prefix + layout tag + patterns hash (format 1 had no tag)
+static const char*    kShmPrefix = "/fileguard-l2-";
+static const char*    kShmLayout = "v2-";
+
+// Segment states (low half of Header::state). Fresh shm memory is zero-filled => kUninit.
+enum : uint32_t { kUninit = 0, kInitializing = 1, kReady = 2 };
+
+// A state or seq value and the pid that owns it, in one word: an owner is recorded
+// in the same compare-and-swap that claims the segment or slot, so a crash can never
+// leave a claim without its owner.
+static inline uint64_t owned(int32_t pid, uint32_t v) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32) | v;
+}
+static inline int32_t owner_of(uint64_t w) { return static_cast<int32_t>(w >> 32); }
+static inline uint32_t value_of(uint64_t w) { return static_cast<uint32_t>(w); }
+
+struct CacheShm::Header {
+    std::atomic<uint64_t> state;      // owned(initializer pid, kInitializing) or kReady
+    uint64_t              magic;
+    uint64_t              slot_count;
+    uint64_t              reserved[5];
+};
+
+// One cache line per slot. The seq half of seq is even when stable, odd while a writer
+// owns it; the pid half is the writer (0 while stable).
+struct CacheShm::Slot {
+    std::atomic<uint64_t> seq;
+    std::atomic<int64_t>  dev;
+    std::atomic<int64_t>  ino;
+    std::atomic<int64_t>  mtime_ns;
+    std::atomic<int64_t>  ctime_ns;
+    std::atomic<int64_t>  size;
+    std::atomic<int32_t>  decision;
+    std::atomic<int32_t>  used;
+    std::atomic<int64_t>  stamp;
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free, "shm slots need lock-free 64-bit atomics");
+static_assert(sizeof(std::atomic<int64_t>) == sizeof(int64_t), "unexpected atomic layout");
+
+// Desc: true if a pid no longer exists (crashed owner); 0 = no owner recorded, assume alive
+// In: int32_t pid
+// Out: bool
+static bool pid_is_dead(int32_t pid) {
+    if (pid <= 0) return false;
+    return ::kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+static inline int64_t to_ns(time_t s, long ns) {
+    return static_cast<int64_t>(s) * 1000000000LL + static_cast<int64_t>(ns);
+}
+
+// Desc: mix (dev, ino) into a slot index seed
+// In: int64_t dev, int64_t ino
+// Out: uint64_t
+static inline uint64_t slot_hash(int64_t dev, int64_t ino) {
+    uint64_t x = static_cast<uint64_t>(ino) * 0x9e3779b97f4a7c15ULL;
+    x ^= static_cast<uint64_t>(dev) + 0x632be59bd9b4e019ULL + (x << 6) + (x >> 2);
+    x ^= x >> 31;
+    return x;
+}
+
+CacheShm::~CacheShm() {
+    if (hdr_) ::munmap(hdr_, map_len_);
+}
+
+// Desc: create or join the shared segment; recovers from a crashed initializer
+// In: const std::string& patterns_hash, size_t slots
+// Out: bool (true if attached and ready)
+bool CacheShm::attach(const std::string& patterns_hash, size_t slots) {
+    if (hdr_) return true;
+    uint64_t n = 1024;
+    while (n < slots) n <<= 1;
+
+    // a segment of the same patterns in an older layout is never joined again
+    (void)::shm_unlink((kShmPrefix + patterns_hash).c_str());
+    const std::string name = kShmPrefix + std::string(kShmLayout) + patterns_hash;
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "[shm] shm_open failed: " << name << " (" << std::strerror(errno) << ")\n";
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    if (st.st_size == 0) {
+        // first attacher sizes the segment; racing attachers request the same size or keep theirs
+        (void)::ftruncate(fd, static_cast<off_t>(sizeof(Header) + n * sizeof(Slot)));
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    }
+    if (static_cast<size_t>(st.st_size) < sizeof(Header) + 1024 * sizeof(Slot)) {
+        std::cerr << "[shm] segment too small: " << name << "\n";
+        ::close(fd);
+        return false;
+    }
+    const size_t len = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return false;
+
+    auto* hdr = static_cast<Header*>(base);
+    // the segment size decides the slot count (another instance may have created it)
+    uint64_t fit = 1024;
+    while ((fit << 1) * sizeof(Slot) + sizeof(Header) <= len) fit <<= 1;
+
+    const int32_t me = static_cast<int32_t>(::getpid());
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        uint64_t s = hdr->state.load(std::memory_order_acquire);
+        if (s == kReady) break;
+
+        bool claim = false;
+        if (s == kUninit) {
+            claim = hdr->state.compare_exchange_strong(s, owned(me, kInitializing), std::memory_order_acq_rel);
+        } else if (value_of(s) == kInitializing && pid_is_dead(owner_of(s))) {
+            // initializer died mid-way: take ownership and redo the init
+            claim = hdr->state.compare_exchange_strong(s, owned(me, kInitializing), std::memory_order_acq_rel);
+        }
+        if (claim) {
+            hdr->magic = kShmMagic;
+            hdr->slot_count = fit;
+            std::memset(static_cast<void*>(reinterpret_cast<char*>(base) + sizeof(Header)), 0, fit * sizeof(Slot));
+            hdr->state.store(kReady, std::memory_order_release);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    if (hdr->state.load(std::memory_order_acquire) != kReady ||
+        hdr->magic != kShmMagic || hdr->slot_count != fit) {
+        std::cerr << "[shm] segment not usable: " << name << "\n";
+        ::munmap(base, len);
+        return false;
+    }
+
+    hdr_     = hdr;
+    hash_    = patterns_hash;
+    name_    = name;
+    slots_   = reinterpret_cast<Slot*>(reinterpret_cast<char*>(base) + sizeof(Header));
+    map_len_ = len;
+    mask_    = fit - 1;
+    #ifdef DEBUG
+    std::cout << "[shm] attached " << name << " slots=" << fit << std::endl;
+    #endif
+    return true;
+}
+
+// Desc: seqlock read of the probe window for (dev, ino)
+// In: const struct stat& st, int& decision
+// Out: bool (true on validated hit)
+bool CacheShm::get(const struct stat& st, int& decision) const {
+    if (!hdr_) return false;
+    const int64_t dev = static_cast<int64_t>(st.st_dev);
+    const int64_t ino = static_cast<int64_t>(st.st_ino);
+    const uint64_t h = slot_hash(dev, ino);
+
+    for (size_t i = 0; i < kProbe; ++i) {
+        const Slot& s = slots_[(h + i) & mask_];
+        const uint64_t s1 = s.seq.load(std::memory_order_acquire);
+        if (value_of(s1) & 1u) continue; // being written
+        if (!s.used.load(std::memory_order_relaxed)) continue;
+        const int64_t d  = s.dev.load(std::memory_order_relaxed);
+        const int64_t in = s.ino.load(std::memory_order_relaxed);
+        const int64_t mt = s.mtime_ns.load(std::memory_order_relaxed);
+        const int64_t ct = s.ctime_ns.load(std::memory_order_relaxed);
+        const int64_t sz = s.size.load(std::memory_order_relaxed);
+        const int32_t dc = s.decision.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != s1) continue; // torn read
+
+        if (d != dev || in != ino) continue;
+        if (mt != to_ns(st.st_mtim.tv_sec, st.st_mtim.tv_nsec) ||
+            ct != to_ns(st.st_ctim.tv_sec, st.st_ctim.tv_nsec) ||
+            sz != static_cast<int64_t>(st.st_size)) {
+            return false; // same inode, different content version
+        }
+        decision = dc;
+        return true;
+    }
+    return false;
+}
+
+// Desc: publish a decision; reuses the key's slot, else an empty one, else the oldest
+// In: const struct stat& st, int decision
+// Out: void
+void CacheShm::put(const struct stat& st, int decision) {
+    if (!hdr_) return;
+    const int64_t dev = static_cast<int64_t>(st.st_dev);
+    const int64_t ino = static_cast<int64_t>(st.st_ino);
+    const uint64_t h = slot_hash(dev, ino);
+
+    Slot* target = nullptr;
+    Slot* oldest = nullptr;
+    int64_t oldest_stamp = INT64_MAX;
+    for (size_t i = 0; i < kProbe; ++i) {
+        Slot& s = slots_[(h + i) & mask_];
+        if (!s.used.load(std::memory_order_relaxed)) { if (!target) target = &s; continue; }
+        if (s.dev.load(std::memory_order_relaxed) == dev &&
+            s.ino.load(std::memory_order_relaxed) == ino) { target = &s; break; }
+        const int64_t stamp = s.stamp.load(std::memory_order_relaxed);
+        if (stamp < oldest_stamp) { oldest_stamp = stamp; oldest = &s; }
+    }
+    if (!target) target = oldest;
+    if (!target) return;
+
+    const int32_t me = static_cast<int32_t>(::getpid());
+    uint64_t w = target->seq.load(std::memory_order_acquire);
+    uint32_t s0 = value_of(w);
+    if (s0 & 1u) {
+        // a writer holds the slot; steal it only if that process crashed mid-write
+        if (!pid_is_dead(owner_of(w))) return;
+        s0 += 2; // still odd: we are the writer now
+    } else {
+        s0 += 1;
+    }
+    if (!target->seq.compare_exchange_strong(w, owned(me, s0), std::memory_order_acq_rel)) return;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    target->dev.store(dev, std::memory_order_relaxed);
+    target->ino.store(ino, std::memory_order_relaxed);
+    target->mtime_ns.store(to_ns(st.st_mtim.tv_sec, st.st_mtim.tv_nsec), std::memory_order_relaxed);
+    target->ctime_ns.store(to_ns(st.st_ctim.tv_sec, st.st_ctim.tv_nsec), std::memory_order_relaxed);
+    target->size.store(static_cast<int64_t>(st.st_size), std::memory_order_relaxed);
+    target->decision.store(decision, std::memory_order_relaxed);
+    target->stamp.store(static_cast<int64_t>(std::time(nullptr)), std::memory_order_relaxed);
+    target->used.store(1, std::memory_order_relaxed);
+
+    target->seq.store(owned(0, s0 + 1), std::memory_order_release);
+}
+
+// Desc: remove the segment's name (its pattern set was replaced); instances already
+//       attached keep their mapping, later ones create a fresh segment
+// In: (none)
+// Out: void
+void CacheShm::unlink() {
+    if (!name_.empty()) (void)::shm_unlink(name_.c_str());
+}
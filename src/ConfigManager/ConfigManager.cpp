@@ -8,6 +8,8 @@
 #include <regex>
 #include <stdexcept>
 #include <filesystem>
+#include <iterator>
+#include <utility>
 #include <nlohmann/json.hpp>
 using nlohmann::json;
 
@@ -99,6 +101,7 @@ static void ensure_meta_table(sqlite3* db) {
 
 
 bool ConfigManager::loadFromFile(const std::string& config_path) {
+    config_path_ = config_path;
     std::ifstream file(config_path);
     if (!file.is_open()) {
         std::cerr << "[ConfigManager] cannot open file: " << config_path << "\n";
@@ -125,23 +128,77 @@ bool ConfigManager::loadFromFile(const std::string& config_path) {
         if (watch_target_.empty()) { std::cerr << "[ConfigManager] 'watch_target' must be non-empty\n"; return false; }
     } else { std::cerr << "[ConfigManager] missing or invalid 'watch_target'\n"; return false; }
 
-    // patterns (strings only)
+    // patterns: "regex" or { "pattern": "regex", "types": [...], "paths": [...] } (scoped)
     pattern_strings_.clear();
-    auto add_pat = [&](const std::string& pat) {
+    pattern_scopes_.clear();
+    auto add_pat = [&](const std::string& pat, PatternScope scope) {
         // Accept as-is; Hyperscan will compile/validate later
         pattern_strings_.push_back(pat);
+        pattern_scopes_.push_back(std::move(scope));
+    };
+    auto read_list = [](const json& o, const char* key, std::vector<std::string>& out) {
+        if (!o.contains(key)) return true;
+        const auto& a = o[key];
+        if (!a.is_array()) return false;
+        for (const auto& v : a) {
+            if (!v.is_string() || v.get<std::string>().empty()) return false;
+            out.push_back(v.get<std::string>());
+        }
+        return true;
     };
     if (j.contains("patterns")) {
         if (j["patterns"].is_array()) {
-            for (const auto& p : j["patterns"]) if (p.is_string()) add_pat(p.get<std::string>());
+            for (const auto& p : j["patterns"]) {
+                if (p.is_string()) { add_pat(p.get<std::string>(), {}); continue; }
+                if (!p.is_object()) continue;
+                if (!p.contains("pattern") || !p["pattern"].is_string()) {
+                    std::cerr << "[ConfigManager] scoped pattern needs a string 'pattern'\n";
+                    return false;
+                }
+                PatternScope scope;
+                if (!read_list(p, "types", scope.types) || !read_list(p, "paths", scope.path_prefixes)) {
+                    std::cerr << "[ConfigManager] 'types'/'paths' of a pattern must be arrays of non-empty strings\n";
+                    return false;
+                }
+                add_pat(p["pattern"].get<std::string>(), std::move(scope));
+            }
         } else if (j["patterns"].is_string()) {
-            add_pat(j["patterns"].get<std::string>());
+            add_pat(j["patterns"].get<std::string>(), {});
         } else {
-            std::cerr << "[ConfigManager] 'patterns' must be string or array of strings\n";
+            std::cerr << "[ConfigManager] 'patterns' must be string or array of strings/objects\n";
             return false;
         }
     }
 
+    // dictionaries (optional): [ "file" | { "path": "...", "caseless": bool } ], one literal per line
+    dictionaries_.clear();
+    if (j.contains("dictionaries")) {
+        if (!j["dictionaries"].is_array()) {
+            std::cerr << "[ConfigManager] 'dictionaries' must be an array\n";
+            return false;
+        }
+        for (const auto& d : j["dictionaries"]) {
+            DictionarySpec spec;
+            if (d.is_string()) {
+                spec.path = d.get<std::string>();
+            } else if (d.is_object() && d.contains("path") && d["path"].is_string()) {
+                spec.path = d["path"].get<std::string>();
+                if (d.contains("caseless")) {
+                    if (!d["caseless"].is_boolean()) { std::cerr << "[ConfigManager] 'dictionaries[].caseless' must be boolean\n"; return false; }
+                    spec.caseless = d["caseless"].get<bool>();
+                }
+            } else {
+                std::cerr << "[ConfigManager] 'dictionaries' entries must be a path or { \"path\": ... }\n";
+                return false;
+            }
+            std::ifstream df(spec.path, std::ios::binary);
+            if (!df.is_open()) { std::cerr << "[ConfigManager] cannot open dictionary: " << spec.path << "\n"; return false; }
+            std::string content((std::istreambuf_iterator<char>(df)), std::istreambuf_iterator<char>());
+            spec.content_hash = hashCanonical(content);
+            dictionaries_.push_back(std::move(spec));
+        }
+    }
+
     // sizes
     cache_capacity_bytes_ = 0;
     if (j.contains("cache_capacity_bytes") && j["cache_capacity_bytes"].is_string()) {
@@ -165,6 +222,415 @@ bool ConfigManager::loadFromFile(const std::string& config_path) {
         } else { std::cerr << "[ConfigManager] missing or invalid 'statistical.duration_sec'\n"; return false; }
     } else { std::cerr << "[ConfigManager] missing or invalid 'statistical' object\n"; return false; }
 
+    // l2_snapshot (optional): { "path": "...", "interval_sec": N }, interval 0 = only on shutdown
+    l2_snapshot_path_ = "cache/l2.snapshot";
+    l2_snapshot_interval_sec_ = 300;
+    if (j.contains("l2_snapshot")) {
+        const auto& s = j["l2_snapshot"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'l2_snapshot' must be an object\n"; return false; }
+        if (s.contains("path")) {
+            if (!s["path"].is_string()) { std::cerr << "[ConfigManager] 'l2_snapshot.path' must be string\n"; return false; }
+            l2_snapshot_path_ = s["path"].get<std::string>();
+        }
+        if (s.contains("interval_sec")) {
+            if (!s["interval_sec"].is_number_unsigned()) { std::cerr << "[ConfigManager] 'l2_snapshot.interval_sec' must be integer >= 0\n"; return false; }
+            l2_snapshot_interval_sec_ = s["interval_sec"].get<std::uint64_t>();
+        }
+    }
+
+    // shared_cache (optional): { "enabled": bool, "slots": N } cross-instance decision tier in shm
+    shared_cache_enabled_ = false;
+    shared_cache_slots_ = 65536;
+    if (j.contains("shared_cache")) {
+        const auto& s = j["shared_cache"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'shared_cache' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'shared_cache.enabled' must be boolean\n"; return false; }
+            shared_cache_enabled_ = s["enabled"].get<bool>();
+        }
+        if (s.contains("slots")) {
+            if (!s["slots"].is_number_unsigned() || s["slots"].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'shared_cache.slots' must be integer > 0\n"; return false;
+            }
+            shared_cache_slots_ = s["slots"].get<std::uint64_t>();
+        }
+    }
+
+    // content_hash_cache (optional): { "enabled": bool, "max_entries": N } dedup by content fingerprint
+    content_hash_enabled_ = false;
+    content_hash_max_entries_ = 200000;
+    if (j.contains("content_hash_cache")) {
+        const auto& s = j["content_hash_cache"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'content_hash_cache' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'content_hash_cache.enabled' must be boolean\n"; return false; }
+            content_hash_enabled_ = s["enabled"].get<bool>();
+        }
+        if (s.contains("max_entries")) {
+            if (!s["max_entries"].is_number_unsigned()) { std::cerr << "[ConfigManager] 'content_hash_cache.max_entries' must be integer >= 0\n"; return false; }
+            content_hash_max_entries_ = s["max_entries"].get<std::uint64_t>();
+        }
+    }
+
+    // hs_db_cache (optional): { "enabled": bool, "dir": "..." } reuse compiled pattern databases
+    hs_db_cache_dir_ = "cache";
+    if (j.contains("hs_db_cache")) {
+        const auto& s = j["hs_db_cache"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'hs_db_cache' must be an object\n"; return false; }
+        if (s.contains("dir")) {
+            if (!s["dir"].is_string()) { std::cerr << "[ConfigManager] 'hs_db_cache.dir' must be string\n"; return false; }
+            hs_db_cache_dir_ = s["dir"].get<std::string>();
+        }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'hs_db_cache.enabled' must be boolean\n"; return false; }
+            if (!s["enabled"].get<bool>()) hs_db_cache_dir_.clear();
+        }
+    }
+
+    // pattern_tiers (optional): { "max_tiers": N, "merge_interval_sec": S } base + delta databases on reload
+    pattern_max_tiers_ = 4;
+    pattern_merge_interval_sec_ = 300;
+    if (j.contains("pattern_tiers")) {
+        const auto& s = j["pattern_tiers"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'pattern_tiers' must be an object\n"; return false; }
+        if (s.contains("max_tiers")) {
+            if (!s["max_tiers"].is_number_unsigned() || s["max_tiers"].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'pattern_tiers.max_tiers' must be a positive integer\n";
+                return false;
+            }
+            pattern_max_tiers_ = s["max_tiers"].get<std::uint64_t>();
+        }
+        if (s.contains("merge_interval_sec")) {
+            if (!s["merge_interval_sec"].is_number_unsigned()) {
+                std::cerr << "[ConfigManager] 'pattern_tiers.merge_interval_sec' must be a non-negative integer\n";
+                return false;
+            }
+            pattern_merge_interval_sec_ = s["merge_interval_sec"].get<std::uint64_t>();
+        }
+    }
+
+    // small_file_batch (optional): { "enabled": bool, "max_file_bytes": N, "max_files": N }
+    small_batch_enabled_ = false;
+    small_batch_max_file_bytes_ = 4096;
+    small_batch_max_files_ = 256;
+    if (j.contains("small_file_batch")) {
+        const auto& s = j["small_file_batch"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'small_file_batch' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'small_file_batch.enabled' must be boolean\n"; return false; }
+            small_batch_enabled_ = s["enabled"].get<bool>();
+        }
+        if (s.contains("max_file_bytes")) {
+            if (!s["max_file_bytes"].is_number_unsigned() || s["max_file_bytes"].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'small_file_batch.max_file_bytes' must be a positive integer\n";
+                return false;
+            }
+            small_batch_max_file_bytes_ = s["max_file_bytes"].get<std::uint64_t>();
+        }
+        if (s.contains("max_files")) {
+            if (!s["max_files"].is_number_unsigned() || s["max_files"].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'small_file_batch.max_files' must be a positive integer\n";
+                return false;
+            }
+            small_batch_max_files_ = s["max_files"].get<std::uint64_t>();
+        }
+    }
+
+    // pdf (optional): { "threads": N, "parallel_min_pages": N, "max_pages": N, "time_budget_ms": N }
+    pdf_limits_ = PdfLimits{};
+    if (j.contains("pdf")) {
+        const auto& s = j["pdf"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'pdf' must be an object\n"; return false; }
+        if (s.contains("threads")) {
+            if (!s["threads"].is_number_unsigned() || s["threads"].get<std::uint64_t>() == 0 ||
+                s["threads"].get<std::uint64_t>() > 64) {
+                std::cerr << "[ConfigManager] 'pdf.threads' must be an integer in 1..64\n";
+                return false;
+            }
+            pdf_limits_.threads = s["threads"].get<unsigned>();
+        }
+        if (s.contains("parallel_min_pages")) {
+            if (!s["parallel_min_pages"].is_number_unsigned() || s["parallel_min_pages"].get<std::uint64_t>() > 1000000) {
+                std::cerr << "[ConfigManager] 'pdf.parallel_min_pages' must be a non-negative integer\n";
+                return false;
+            }
+            pdf_limits_.parallel_min_pages = s["parallel_min_pages"].get<int>();
+        }
+        if (s.contains("max_pages")) {
+            if (!s["max_pages"].is_number_unsigned() || s["max_pages"].get<std::uint64_t>() > 1000000) {
+                std::cerr << "[ConfigManager] 'pdf.max_pages' must be a non-negative integer (0 = all)\n";
+                return false;
+            }
+            pdf_limits_.max_pages = s["max_pages"].get<int>();
+        }
+        if (s.contains("time_budget_ms")) {
+            if (!s["time_budget_ms"].is_number_unsigned()) {
+                std::cerr << "[ConfigManager] 'pdf.time_budget_ms' must be a non-negative integer (0 = none)\n";
+                return false;
+            }
+            pdf_limits_.time_budget_ms = s["time_budget_ms"].get<std::uint64_t>();
+        }
+    }
+
+    // archives (optional): { "enabled": bool, "max_depth": N, "max_total_bytes": N, "max_ratio": N,
+    //                        "max_members": N, "max_document_bytes": N, "max_decoder_memory": N }
+    archive_limits_ = ArchiveLimits{};
+    if (j.contains("archives")) {
+        const auto& s = j["archives"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'archives' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'archives.enabled' must be boolean\n"; return false; }
+            archive_limits_.enabled = s["enabled"].get<bool>();
+        }
+        if (s.contains("max_depth")) {
+            if (!s["max_depth"].is_number_unsigned() || s["max_depth"].get<std::uint64_t>() > 16) {
+                std::cerr << "[ConfigManager] 'archives.max_depth' must be an integer in 0..16\n";
+                return false;
+            }
+            archive_limits_.max_depth = s["max_depth"].get<unsigned>();
+        }
+        const std::pair<const char*, std::uint64_t*> sizes[] = {
+            {"max_total_bytes",    &archive_limits_.max_total_bytes},
+            {"max_ratio",          &archive_limits_.max_ratio},
+            {"max_members",        &archive_limits_.max_members},
+            {"max_document_bytes", &archive_limits_.max_document_bytes},
+            {"max_decoder_memory", &archive_limits_.max_decoder_memory},
+        };
+        for (const auto& f : sizes) {
+            if (!s.contains(f.first)) continue;
+            if (!s[f.first].is_number_unsigned() || s[f.first].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'archives." << f.first << "' must be a positive integer\n";
+                return false;
+            }
+            *f.second = s[f.first].get<std::uint64_t>();
+        }
+    }
+
+    // extractor_pool (optional): { "enabled": bool, "helpers": N, "mem_limit_mb": N, "cpu_limit_sec": N,
+    //                              "job_timeout_ms": N, "max_jobs": N }
+    extractor_pool_ = ExtractorPoolOptions{};
+    if (j.contains("extractor_pool")) {
+        const auto& s = j["extractor_pool"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'extractor_pool' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'extractor_pool.enabled' must be boolean\n"; return false; }
+            extractor_pool_.enabled = s["enabled"].get<bool>();
+        }
+        if (s.contains("helpers")) {
+            if (!s["helpers"].is_number_unsigned() || s["helpers"].get<std::uint64_t>() == 0 ||
+                s["helpers"].get<std::uint64_t>() > 64) {
+                std::cerr << "[ConfigManager] 'extractor_pool.helpers' must be an integer in 1..64\n";
+                return false;
+            }
+            extractor_pool_.helpers = s["helpers"].get<unsigned>();
+        }
+        const std::pair<const char*, std::uint64_t*> sizes[] = {
+            {"mem_limit_mb",   &extractor_pool_.mem_limit_mb},
+            {"cpu_limit_sec",  &extractor_pool_.cpu_limit_sec},
+            {"job_timeout_ms", &extractor_pool_.job_timeout_ms},
+            {"max_jobs",       &extractor_pool_.max_jobs},
+        };
+        for (const auto& f : sizes) {
+            if (!s.contains(f.first)) continue;
+            if (!s[f.first].is_number_unsigned() || s[f.first].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'extractor_pool." << f.first << "' must be a positive integer\n";
+                return false;
+            }
+            *f.second = s[f.first].get<std::uint64_t>();
+        }
+    }
+
+    // scan_context (optional): { "memory_ceiling_mb": N, "huge_pages": bool }
+    scan_context_ = ScanContextOptions{};
+    if (j.contains("scan_context")) {
+        const auto& s = j["scan_context"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'scan_context' must be an object\n"; return false; }
+        if (s.contains("memory_ceiling_mb")) {
+            if (!s["memory_ceiling_mb"].is_number_unsigned()) {
+                std::cerr << "[ConfigManager] 'scan_context.memory_ceiling_mb' must be a non-negative integer\n";
+                return false;
+            }
+            scan_context_.memory_ceiling_mb = s["memory_ceiling_mb"].get<std::uint64_t>();
+        }
+        if (s.contains("huge_pages")) {
+            if (!s["huge_pages"].is_boolean()) { std::cerr << "[ConfigManager] 'scan_context.huge_pages' must be boolean\n"; return false; }
+            scan_context_.huge_pages = s["huge_pages"].get<bool>();
+        }
+    }
+
+    // memory_budget (optional): { "enabled": bool, "max_mb": N }
+    memory_budget_ = ByteBudgetOptions{};
+    if (j.contains("memory_budget")) {
+        const auto& s = j["memory_budget"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'memory_budget' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'memory_budget.enabled' must be boolean\n"; return false; }
+            memory_budget_.enabled = s["enabled"].get<bool>();
+        }
+        if (s.contains("max_mb")) {
+            if (!s["max_mb"].is_number_unsigned() || s["max_mb"].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'memory_budget.max_mb' must be a positive integer\n";
+                return false;
+            }
+            memory_budget_.max_mb = s["max_mb"].get<std::uint64_t>();
+        }
+    }
+
+    // page_cache (optional): { "enabled": bool, "min_file_bytes": N }
+    page_cache_ = PageCacheOptions{};
+    if (j.contains("page_cache")) {
+        const auto& s = j["page_cache"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'page_cache' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'page_cache.enabled' must be boolean\n"; return false; }
+            page_cache_.enabled = s["enabled"].get<bool>();
+        }
+        if (s.contains("min_file_bytes")) {
+            if (!s["min_file_bytes"].is_number_unsigned()) {
+                std::cerr << "[ConfigManager] 'page_cache.min_file_bytes' must be a non-negative integer\n";
+                return false;
+            }
+            page_cache_.min_file_bytes = s["min_file_bytes"].get<std::uint64_t>();
+        }
+    }
+
+    // append_scan (optional): { "enabled": bool, "min_file_bytes": N, "max_entries": N }
+    append_scan_ = AppendScanOptions{};
+    if (j.contains("append_scan")) {
+        const auto& s = j["append_scan"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'append_scan' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'append_scan.enabled' must be boolean\n"; return false; }
+            append_scan_.enabled = s["enabled"].get<bool>();
+        }
+        const std::pair<const char*, std::uint64_t*> sizes[] = {
+            {"min_file_bytes", &append_scan_.min_file_bytes},
+            {"max_entries",    &append_scan_.max_entries},
+        };
+        for (const auto& f : sizes) {
+            if (!s.contains(f.first)) continue;
+            if (!s[f.first].is_number_unsigned() || s[f.first].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'append_scan." << f.first << "' must be a positive integer\n";
+                return false;
+            }
+            *f.second = s[f.first].get<std::uint64_t>();
+        }
+    }
+
+    // chunk_scan (optional): { "enabled": bool, "min_file_bytes": N, "max_files": N }
+    chunk_scan_ = ChunkScanOptions{};
+    if (j.contains("chunk_scan")) {
+        const auto& s = j["chunk_scan"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'chunk_scan' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'chunk_scan.enabled' must be boolean\n"; return false; }
+            chunk_scan_.enabled = s["enabled"].get<bool>();
+        }
+        const std::pair<const char*, std::uint64_t*> sizes[] = {
+            {"min_file_bytes", &chunk_scan_.min_file_bytes},
+            {"max_files",      &chunk_scan_.max_files},
+        };
+        for (const auto& f : sizes) {
+            if (!s.contains(f.first)) continue;
+            if (!s[f.first].is_number_unsigned() || s[f.first].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'chunk_scan." << f.first << "' must be a positive integer\n";
+                return false;
+            }
+            *f.second = s[f.first].get<std::uint64_t>();
+        }
+    }
+
+    // async_queue (optional): { "workers": N, "max_wait_ms": N, "max_tasks": N, "max_queued_mb": N, "max_open_fds": N }
+    async_queue_ = AsyncQueueOptions{};
+    if (j.contains("async_queue")) {
+        const auto& s = j["async_queue"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'async_queue' must be an object\n"; return false; }
+        const std::pair<const char*, std::uint64_t*> sizes[] = {
+            {"workers",       &async_queue_.workers},
+            {"max_wait_ms",   &async_queue_.max_wait_ms},
+            {"max_tasks",     &async_queue_.max_tasks},
+            {"max_queued_mb", &async_queue_.max_queued_mb},
+            {"max_open_fds",  &async_queue_.max_open_fds},
+        };
+        for (const auto& f : sizes) {
+            if (!s.contains(f.first)) continue;
+            if (!s[f.first].is_number_unsigned() || s[f.first].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'async_queue." << f.first << "' must be a positive integer\n";
+                return false;
+            }
+            *f.second = s[f.first].get<std::uint64_t>();
+        }
+    }
+
+    // concurrency (optional): { "enabled": bool, "min_sync": N, "max_sync": N, "min_async": N, "max_async": N,
+    //                           "interval_ms": N, "target_latency_ms": N, "cpu_psi_limit": N, "io_psi_limit": N }
+    concurrency_ = ConcurrencyOptions{};
+    if (j.contains("concurrency")) {
+        const auto& s = j["concurrency"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'concurrency' must be an object\n"; return false; }
+        if (s.contains("enabled")) {
+            if (!s["enabled"].is_boolean()) { std::cerr << "[ConfigManager] 'concurrency.enabled' must be boolean\n"; return false; }
+            concurrency_.enabled = s["enabled"].get<bool>();
+        }
+        const std::pair<const char*, std::uint64_t*> sizes[] = {
+            {"min_sync",          &concurrency_.min_sync},
+            {"max_sync",          &concurrency_.max_sync},
+            {"min_async",         &concurrency_.min_async},
+            {"max_async",         &concurrency_.max_async},
+            {"interval_ms",       &concurrency_.interval_ms},
+            {"target_latency_ms", &concurrency_.target_latency_ms},
+            {"cpu_psi_limit",     &concurrency_.cpu_psi_limit},
+            {"io_psi_limit",      &concurrency_.io_psi_limit},
+        };
+        for (const auto& f : sizes) {
+            if (!s.contains(f.first)) continue;
+            if (!s[f.first].is_number_unsigned() || s[f.first].get<std::uint64_t>() == 0) {
+                std::cerr << "[ConfigManager] 'concurrency." << f.first << "' must be a positive integer\n";
+                return false;
+            }
+            *f.second = s[f.first].get<std::uint64_t>();
+        }
+        if (concurrency_.max_sync && concurrency_.max_sync < concurrency_.min_sync) {
+            std::cerr << "[ConfigManager] 'concurrency.max_sync' must not be below 'min_sync'\n";
+            return false;
+        }
+        if (concurrency_.max_async && concurrency_.max_async < concurrency_.min_async) {
+            std::cerr << "[ConfigManager] 'concurrency.max_async' must not be below 'min_async'\n";
+            return false;
+        }
+    }
+
+    // type_policies (optional): { "head_bytes": N, "<kind>": "scan" | "skip" | "head", ... }
+    type_policies_ = TypePolicies{};
+    if (j.contains("type_policies")) {
+        const auto& s = j["type_policies"];
+        if (!s.is_object()) { std::cerr << "[ConfigManager] 'type_policies' must be an object\n"; return false; }
+        for (auto it = s.begin(); it != s.end(); ++it) {
+            if (it.key() == "head_bytes") {
+                if (!it->is_number_unsigned() || it->get<std::uint64_t>() == 0) {
+                    std::cerr << "[ConfigManager] 'type_policies.head_bytes' must be a positive integer\n";
+                    return false;
+                }
+                type_policies_.head_bytes = it->get<std::uint64_t>();
+                continue;
+            }
+            FileKind kind;
+            if (!FileClassifier::fromName(it.key(), kind)) {
+                std::cerr << "[ConfigManager] 'type_policies': unknown content type '" << it.key() << "'\n";
+                return false;
+            }
+            const std::string v = it->is_string() ? it->get<std::string>() : "";
+            TypePolicy& pol = type_policies_.by_kind[static_cast<size_t>(kind)];
+            if (v == "scan")      pol = TypePolicy::Scan;
+            else if (v == "skip") pol = TypePolicy::Skip;
+            else if (v == "head") pol = TypePolicy::Head;
+            else {
+                std::cerr << "[ConfigManager] 'type_policies." << it.key() << "' must be \"scan\", \"skip\" or \"head\"\n";
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -177,9 +643,91 @@ std::string ConfigManager::canonicalRulesJson() const {
     std::sort(sorted.begin(), sorted.end());
     json c;
     c["patterns"] = sorted;
+    // scoped patterns carry their scope in their id; absent key keeps older hashes stable
+    std::vector<std::string> scoped;
+    const std::vector<std::string> ids = patternIds();
+    for (size_t i = 0; i < ids.size(); ++i) if (!pattern_scopes_[i].empty()) scoped.push_back(ids[i]);
+    if (!scoped.empty()) {
+        std::sort(scoped.begin(), scoped.end());
+        c["scoped"] = scoped;
+    }
+    // dictionaries are identified by content; absent key keeps older hashes stable
+    if (!dictionaries_.empty()) {
+        std::vector<std::string> dict_ids = dictionaryIds();
+        std::sort(dict_ids.begin(), dict_ids.end());
+        c["dictionaries"] = dict_ids;
+    }
+    return c.dump();
+}
+
+// Desc: stable ids for the configured dictionaries (hash of content hash + flags)
+// In: (none)
+// Out: std::vector<std::string> (same order as getDictionaries())
+std::vector<std::string> ConfigManager::dictionaryIds() const {
+    std::vector<std::string> ids;
+    ids.reserve(dictionaries_.size());
+    for (const auto& d : dictionaries_)
+        ids.push_back(hashCanonical("dict:" + d.content_hash + (d.caseless ? "/i" : "")).substr(0, 16));
+    return ids;
+}
+
+// Desc: stable ids for the configured patterns (first 16 hex chars of their hash;
+//       a scoped pattern hashes its scope too, so a scope change is a remove + add)
+// In: (none)
+// Out: std::vector<std::string> (same order as getPatternStrings())
+std::vector<std::string> ConfigManager::patternIds() const {
+    std::vector<std::string> ids;
+    ids.reserve(pattern_strings_.size());
+    for (size_t i = 0; i < pattern_strings_.size(); ++i) {
+        const PatternScope& sc = pattern_scopes_[i];
+        const std::string src = sc.empty() ? pattern_strings_[i] : pattern_strings_[i] + '\x1f' + sc.key();
+        ids.push_back(hashCanonical(src).substr(0, 16));
+    }
+    return ids;
+}
+
+// Desc: canonical form of a scope (sorted types and prefixes)
+// In: (none)
+// Out: std::string
+std::string PatternScope::key() const {
+    std::vector<std::string> t = types, p = path_prefixes;
+    std::sort(t.begin(), t.end());
+    std::sort(p.begin(), p.end());
+    json c;
+    c["types"] = t;
+    c["paths"] = p;
     return c.dump();
 }
 
+// Desc: does the scope cover a file of this type at this path? A prefix matches whole
+//       path components ("/src" covers "/src/a.c", not "/srcx/a.c").
+// In: const std::string& type, const std::string& path
+// Out: bool
+bool PatternScope::applies(const std::string& type, const std::string& path) const {
+    if (!types.empty() && std::find(types.begin(), types.end(), type) == types.end()) return false;
+    if (path_prefixes.empty()) return true;
+    for (const auto& pre : path_prefixes) {
+        if (path.compare(0, pre.size(), pre) != 0) continue;
+        if (path.size() == pre.size() || pre.back() == '/' || path[pre.size()] == '/') return true;
+    }
+    return false;
+}
+
+// Desc: split a comma-separated id list
+// In: const std::string& csv
+// Out: std::vector<std::string>
+static std::vector<std::string> split_ids(const std::string& csv) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start < csv.size()) {
+        size_t end = csv.find(',', start);
+        if (end == std::string::npos) end = csv.size();
+        if (end > start) out.push_back(csv.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
 // Desc: hash data into hex (SHA-256 if available, else FNV-based)
 // In: const std::string& data
 // Out: std::string (hex digest)
@@ -237,7 +785,28 @@ bool ConfigManager::initRulesetVersion(sqlite3* db) {
     // 2) read previous hashes & version
     std::string last_scope_hash;
     std::string last_patterns_hash;
+    std::string last_pattern_ids;
     std::uint64_t last_ver = 0;
+    ruleset_delta_ = RulesetDelta{};
+
+    std::vector<std::string> cur_ids = patternIds();
+    const std::vector<std::string> dict_ids = dictionaryIds();
+    cur_ids.insert(cur_ids.end(), dict_ids.begin(), dict_ids.end());
+    std::sort(cur_ids.begin(), cur_ids.end());
+    cur_ids.erase(std::unique(cur_ids.begin(), cur_ids.end()), cur_ids.end());
+    std::string cur_pattern_ids;
+    for (const auto& id : cur_ids) {
+        if (!cur_pattern_ids.empty()) cur_pattern_ids += ',';
+        cur_pattern_ids += id;
+    }
+    // remember the id set so the next patterns-only change can be applied incrementally
+    auto store_pattern_ids = [&]() {
+        sqlite3_stmt* u = nullptr;
+        if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO meta(key,value) VALUES('pattern_ids',?)", -1, &u, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(u, 1, cur_pattern_ids.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(u); sqlite3_finalize(u);
+        }
+    };
 
     {
         sqlite3_stmt* s = nullptr;
@@ -259,6 +828,16 @@ bool ConfigManager::initRulesetVersion(sqlite3* db) {
             sqlite3_finalize(s);
         }
     }
+    {
+        sqlite3_stmt* s = nullptr;
+        if (sqlite3_prepare_v2(db, "SELECT value FROM meta WHERE key='pattern_ids'", -1, &s, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(s) == SQLITE_ROW) {
+                const unsigned char* t = sqlite3_column_text(s, 0);
+                if (t) last_pattern_ids = (const char*)t;
+            }
+            sqlite3_finalize(s);
+        }
+    }
     {
         sqlite3_stmt* s = nullptr;
         if (sqlite3_prepare_v2(db, "SELECT value FROM meta WHERE key='ruleset_version'", -1, &s, nullptr) == SQLITE_OK) {
@@ -297,6 +876,7 @@ bool ConfigManager::initRulesetVersion(sqlite3* db) {
             sqlite3_bind_text(u, 1, cur_patterns_hash.c_str(), -1, SQLITE_TRANSIENT);
             sqlite3_step(u); sqlite3_finalize(u);
         }
+        store_pattern_ids();
         sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
 
         ruleset_version_ = last_ver;
@@ -311,6 +891,7 @@ bool ConfigManager::initRulesetVersion(sqlite3* db) {
 
     // 4) unchanged
     if (!scope_changed && !patterns_changed) {
+        if (last_pattern_ids != cur_pattern_ids) store_pattern_ids(); // upgrade from older meta
         ruleset_version_ = last_ver;
         #ifdef DEBUG
         std::cerr << "[ruleset] no change. version=" << ruleset_version_ << "\n";
@@ -344,6 +925,7 @@ bool ConfigManager::initRulesetVersion(sqlite3* db) {
             sqlite3_bind_text(u, 1, cur_patterns_hash.c_str(), -1, SQLITE_TRANSIENT);
             sqlite3_step(u); sqlite3_finalize(u);
         }
+        store_pattern_ids();
         sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
 
         ruleset_version_ = new_ver;
@@ -372,11 +954,33 @@ bool ConfigManager::initRulesetVersion(sqlite3* db) {
             sqlite3_bind_text(u, 1, cur_patterns_hash.c_str(), -1, SQLITE_TRANSIENT);
             sqlite3_step(u); sqlite3_finalize(u);
         }
+        store_pattern_ids();
         sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
 
         ruleset_version_ = new_ver;
+
+        // previous id set known => describe the change so cached decisions can be migrated
+        if (!last_pattern_ids.empty()) {
+            std::vector<std::string> prev_ids = split_ids(last_pattern_ids);
+            std::sort(prev_ids.begin(), prev_ids.end());
+            ruleset_delta_.active = true;
+            ruleset_delta_.prev_version = last_ver;
+            std::set_difference(cur_ids.begin(), cur_ids.end(), prev_ids.begin(), prev_ids.end(),
+                                std::back_inserter(ruleset_delta_.added_ids));
+            std::set_difference(prev_ids.begin(), prev_ids.end(), cur_ids.begin(), cur_ids.end(),
+                                std::back_inserter(ruleset_delta_.removed_ids));
+            // a new/changed dictionary is not part of the delta matcher: full revalidation
+            for (const auto& id : ruleset_delta_.added_ids) {
+                if (std::find(dict_ids.begin(), dict_ids.end(), id) != dict_ids.end()) {
+                    ruleset_delta_ = RulesetDelta{};
+                    break;
+                }
+            }
+        }
         #ifdef DEBUG
-        std::cerr << "[ruleset] patterns changed (scope unchanged). bumped version to " << ruleset_version_ << "\n";
+        std::cerr << "[ruleset] patterns changed (scope unchanged). bumped version to " << ruleset_version_
+                  << " added=" << ruleset_delta_.added_ids.size()
+                  << " removed=" << ruleset_delta_.removed_ids.size() << "\n";
         #endif
         warmup_mode_ = WarmupMode::Scope;
         return true;
@@ -0,0 +1,208 @@
+// === src/ContentHash/ContentHash.cpp ===
+#include "ContentHash.hpp"
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <sys/random.h>
+
+static const uint64_t P1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t P3 = 0x165667B19E3779F9ULL;
+static const uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+static inline uint64_t read64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+static inline uint32_t read32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    acc  = rotl64(acc, 31);
+    return acc * P1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * P1 + P4;
+}
+
+// Desc: XXH64 (little-endian reference algorithm); ~memory bandwidth on one core
+// In: const void* data, size_t len, uint64_t seed
+// Out: uint64_t
+uint64_t xxh64(const void* data, size_t len, uint64_t seed) {
+    const unsigned char* p   = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        const unsigned char* limit = end - 32;
+        uint64_t v1 = seed + P1 + P2;
+        uint64_t v2 = seed + P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - P1;
+        do {
+            v1 = xxh_round(v1, read64(p));      p += 8;
+            v2 = xxh_round(v2, read64(p));      p += 8;
+            v3 = xxh_round(v3, read64(p));      p += 8;
+            v4 = xxh_round(v4, read64(p));      p += 8;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + P5;
+    }
+
+    h += static_cast<uint64_t>(len);
+    while (p + 8 <= end) {
+        h ^= xxh_round(0, read64(p));
+        h  = rotl64(h, 27) * P1 + P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * P1;
+        h  = rotl64(h, 23) * P2 + P3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= static_cast<uint64_t>(*p) * P5;
+        h  = rotl64(h, 11) * P1;
+        ++p;
+    }
+
+    h ^= h >> 33; h *= P2;
+    h ^= h >> 29; h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+
+// Desc: load or create the per-install hash seed in meta (keeps digests unpredictable)
+// In: sqlite3* db
+// Out: uint64_t
+static uint64_t load_or_create_seed(sqlite3* db) {
+    uint64_t seed = 0;
+    sqlite3_stmt* s = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT value FROM meta WHERE key='content_hash_seed'", -1, &s, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(s) == SQLITE_ROW) {
+            const unsigned char* t = sqlite3_column_text(s, 0);
+            if (t) seed = std::strtoull((const char*)t, nullptr, 10);
+        }
+        sqlite3_finalize(s);
+    }
+    if (seed != 0) return seed;
+
+    if (getrandom(&seed, sizeof(seed), 0) != static_cast<ssize_t>(sizeof(seed)) || seed == 0) {
+        seed = static_cast<uint64_t>(std::time(nullptr)) * P1;
+    }
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO meta(key,value) VALUES('content_hash_seed',?)", -1, &s, nullptr) == SQLITE_OK) {
+        const std::string v = std::to_string(seed);
+        sqlite3_bind_text(s, 1, v.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(s);
+        sqlite3_finalize(s);
+    }
+    return seed;
+}
+
+ContentHashCache::ContentHashCache(sqlite3* db, uint64_t max_entries)
+    : db_(db), max_entries_(max_entries) {
+    if (db_) seed_ = load_or_create_seed(db_);
+}
+
+// Desc: 128-bit digest of a buffer (two seeded XXH64 lanes)
+// In: const void* data, size_t len
+// Out: ContentDigest
+ContentDigest ContentHashCache::digest(const void* data, size_t len) const {
+    ContentDigest d;
+    d.lo = xxh64(data, len, seed_);
+    d.hi = xxh64(data, len, rotl64(seed_, 32) ^ P3);
+    return d;
+}
+
+// Desc: look up a decision by content digest and size for the current ruleset
+// In: const ContentDigest& h, uint64_t size, uint64_t ruleset_version, int& decision
+// Out: bool (true=hit)
+bool ContentHashCache::get(const ContentDigest& h, uint64_t size, uint64_t ruleset_version, int& decision) {
+    if (!db_) return false;
+    std::lock_guard<std::mutex> lk(mu_);
+
+    const char* sql =
+        "SELECT decision FROM content_hashes "
+        "WHERE hash_lo=? AND hash_hi=? AND size=? AND ruleset_version=?;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    sqlite3_bind_int64(stmt, 1, static_cast<long long>(h.lo));
+    sqlite3_bind_int64(stmt, 2, static_cast<long long>(h.hi));
+    sqlite3_bind_int64(stmt, 3, static_cast<long long>(size));
+    sqlite3_bind_int64(stmt, 4, static_cast<long long>(ruleset_version));
+
+    bool hit = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        decision = sqlite3_column_int(stmt, 0);
+        hit = true;
+    }
+    (void)sqlite3_finalize(stmt);
+
+    if (hit) {
+        sqlite3_stmt* upd = nullptr;
+        if (sqlite3_prepare_v2(db_,
+                "UPDATE content_hashes SET hit_count = hit_count + 1, last_access_ts = ? "
+                "WHERE hash_lo=? AND hash_hi=? AND size=?;", -1, &upd, nullptr) == SQLITE_OK) {
+            sqlite3_bind_int64(upd, 1, static_cast<long long>(time(nullptr)));
+            sqlite3_bind_int64(upd, 2, static_cast<long long>(h.lo));
+            sqlite3_bind_int64(upd, 3, static_cast<long long>(h.hi));
+            sqlite3_bind_int64(upd, 4, static_cast<long long>(size));
+            (void)sqlite3_step(upd);
+            (void)sqlite3_finalize(upd);
+        }
+    }
+    return hit;
+}
+
+// Desc: record the decision for a content digest; prunes LRU rows over capacity
+// In: const ContentDigest& h, uint64_t size, uint64_t ruleset_version, int decision
+// Out: void
+void ContentHashCache::put(const ContentDigest& h, uint64_t size, uint64_t ruleset_version, int decision) {
+    if (!db_) return;
+    std::lock_guard<std::mutex> lk(mu_);
+
+    const char* sql =
+        "INSERT OR REPLACE INTO content_hashes "
+        "(hash_lo, hash_hi, size, ruleset_version, decision, last_access_ts, hit_count) "
+        "VALUES (?, ?, ?, ?, ?, ?, 0);";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return;
+    sqlite3_bind_int64(stmt, 1, static_cast<long long>(h.lo));
+    sqlite3_bind_int64(stmt, 2, static_cast<long long>(h.hi));
+    sqlite3_bind_int64(stmt, 3, static_cast<long long>(size));
+    sqlite3_bind_int64(stmt, 4, static_cast<long long>(ruleset_version));
+    sqlite3_bind_int(stmt,   5, decision);
+    sqlite3_bind_int64(stmt, 6, static_cast<long long>(time(nullptr)));
+    (void)sqlite3_step(stmt);
+    (void)sqlite3_finalize(stmt);
+
+    if (++puts_since_prune_ >= 1024) {
+        puts_since_prune_ = 0;
+        prune_locked();
+    }
+}
+
+// Desc: keep at most max_entries rows (least recently used go first)
+// In: (none)
+// Out: void
+void ContentHashCache::prune_locked() {
+    if (max_entries_ == 0) return;
+    const char* sql =
+        "DELETE FROM content_hashes WHERE rowid IN ("
+        "  SELECT rowid FROM content_hashes ORDER BY last_access_ts ASC "
+        "  LIMIT MAX((SELECT COUNT(*) FROM content_hashes) - ?, 0)"
+        ");";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return;
+    sqlite3_bind_int64(stmt, 1, static_cast<long long>(max_entries_));
+    (void)sqlite3_step(stmt);
+    (void)sqlite3_finalize(stmt);
+}
@@ -0,0 +1,672 @@
+// === src/ContentParser/ArchiveDecoder.cpp ===
+#include "ArchiveDecoder.hpp"
+#include "ZipReader.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <lzma.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using Result = ArchiveDecoder::Result;
+
+// decoded bytes allowed before the expansion ratio is enforced (small inputs compress well)
+static const uint64_t kRatioSlack = 1u << 20;
+static const size_t   kInBuf      = 64u << 10;
+
+// State shared by every stream of one decode() call.
+struct DecodeCtx {
+    const ArchiveLimits&         lim;
+    const TypePolicies*          pol;
+    const ArchiveDecoder::Sink&  sink;
+    uint64_t                     out_bytes{0};   // decoded bytes delivered or held
+    uint64_t                     members{0};
+    bool                         limited{false}; // some content was left undecoded
+    bool                         abort{false};   // a per-file limit was hit: stop everything
+    std::string                  error;
+
+    DecodeCtx(const ArchiveLimits& l, const TypePolicies* p, const ArchiveDecoder::Sink& s)
+        : lim(l), pol(p), sink(s) {}
+
+    // Desc: record a limit; fatal ones end the whole decode
+    void limit(const std::string& why, bool fatal) {
+        limited = true;
+        if (fatal) abort = true;
+        if (error.empty()) error = why;
+    }
+    void fail(const std::string& why) { if (error.empty()) error = why; }
+    // Desc: account decoded bytes against max_total_bytes
+    bool take(uint64_t n) {
+        out_bytes += n;
+        if (out_bytes <= lim.max_total_bytes) return true;
+        limit("decoded size limit reached", true);
+        return false;
+    }
+};
+
+// Pull-style byte stream.
+class Source {
+public:
+    virtual ~Source() = default;
+    // Out: bytes read (0 = end of stream), -1 = error
+    virtual long read(char* dst, size_t n) = 0;
+    // Desc: discard n bytes
+    virtual bool skip(uint64_t n) {
+        char tmp[4096];
+        while (n > 0) {
+            const long r = read(tmp, static_cast<size_t>(std::min<uint64_t>(n, sizeof(tmp))));
+            if (r <= 0) return false;
+            n -= static_cast<uint64_t>(r);
+        }
+        return true;
+    }
+};
+
+// Desc: read until n bytes or end of stream
+// In: Source& s, char* dst, size_t n
+// Out: long (bytes read, -1 on error)
+static long read_full(Source& s, char* dst, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        const long r = s.read(dst + got, n - got);
+        if (r < 0) return -1;
+        if (r == 0) break;
+        got += static_cast<size_t>(r);
+    }
+    return static_cast<long>(got);
+}
+
+// The scanned file itself, read with pread (skips are free).
+class FdSource : public Source {
+public:
+    FdSource(int fd, uint64_t size, uint64_t off = 0) : fd_(fd), off_(off), end_(off + size) {}
+    long read(char* dst, size_t n) override {
+        if (off_ >= end_) return 0;
+        n = static_cast<size_t>(std::min<uint64_t>(n, end_ - off_));
+        const ssize_t r = ::pread(fd_, dst, n, static_cast<off_t>(off_));
+        if (r < 0) return -1;
+        off_ += static_cast<uint64_t>(r);
+        return static_cast<long>(r);
+    }
+    bool skip(uint64_t n) override {
+        if (n > end_ - off_) return false;
+        off_ += n;
+        return true;
+    }
+
+private:
+    int      fd_;
+    uint64_t off_;
+    uint64_t end_;
+};
+
+// Bytes already in memory (zip members).
+class MemSource : public Source {
+public:
+    explicit MemSource(std::string_view d) : d_(d) {}
+    long read(char* dst, size_t n) override {
+        n = std::min(n, d_.size() - pos_);
+        std::memcpy(dst, d_.data() + pos_, n);
+        pos_ += n;
+        return static_cast<long>(n);
+    }
+    bool skip(uint64_t n) override {
+        if (n > d_.size() - pos_) return false;
+        pos_ += static_cast<size_t>(n);
+        return true;
+    }
+
+private:
+    std::string_view d_;
+    size_t           pos_{0};
+};
+
+// The next 'len' bytes of an inner source (one tar member).
+class LimitSource : public Source {
+public:
+    LimitSource(Source& in, uint64_t len) : in_(in), left_(len) {}
+    long read(char* dst, size_t n) override {
+        if (left_ == 0) return 0;
+        const long r = in_.read(dst, static_cast<size_t>(std::min<uint64_t>(n, left_)));
+        if (r <= 0) return -1; // the archive ended inside the member
+        left_ -= static_cast<uint64_t>(r);
+        return r;
+    }
+    bool skip(uint64_t n) override {
+        if (n > left_ || !in_.skip(n)) return false;
+        left_ -= n;
+        return true;
+    }
+    // Desc: move the inner source to the end of the member
+    bool drain() { return skip(left_); }
+
+private:
+    Source&  in_;
+    uint64_t left_;
+};
+
+// Reads the head of a stream for classification, then replays it.
+class PeekSource : public Source {
+public:
+    explicit PeekSource(Source& in) : in_(in) {}
+    bool peek(size_t n) {
+        head_.resize(n);
+        const long r = read_full(in_, &head_[0], n);
+        if (r < 0) return false;
+        head_.resize(static_cast<size_t>(r));
+        return true;
+    }
+    std::string_view head() const { return head_; }
+    long read(char* dst, size_t n) override {
+        if (pos_ < head_.size()) {
+            n = std::min(n, head_.size() - pos_);
+            std::memcpy(dst, head_.data() + pos_, n);
+            pos_ += n;
+            return static_cast<long>(n);
+        }
+        return in_.read(dst, n);
+    }
+    bool skip(uint64_t n) override {
+        const size_t h = static_cast<size_t>(std::min<uint64_t>(n, head_.size() - pos_));
+        pos_ += h;
+        return in_.skip(n - h);
+    }
+
+private:
+    Source&     in_;
+    std::string head_;
+    size_t      pos_{0};
+};
+
+// Common part of the decompressors: input buffering and the expansion-ratio check.
+class Decompressor : public Source {
+protected:
+    Decompressor(Source& in, DecodeCtx& c) : in_(in), c_(c), buf_(new unsigned char[kInBuf]) {}
+
+    // Desc: refill next_/avail_ once the input buffer is consumed
+    // Out: bool (false on read error)
+    bool refill() {
+        if (avail_ > 0 || in_eof_) return true;
+        const long r = in_.read(reinterpret_cast<char*>(buf_.get()), kInBuf);
+        if (r < 0) return false;
+        if (r == 0) { in_eof_ = true; return true; }
+        next_  = buf_.get();
+        avail_ = static_cast<size_t>(r);
+        in_bytes_ += static_cast<uint64_t>(r);
+        return true;
+    }
+    // Desc: count produced bytes; a stream expanding beyond max_ratio is cut off
+    bool produced(size_t n) {
+        out_bytes_ += n;
+        if (out_bytes_ <= c_.lim.max_ratio * in_bytes_ + kRatioSlack) return true;
+        c_.limit("expansion ratio limit reached", false);
+        return false;
+    }
+
+    Source&                          in_;
+    DecodeCtx&                       c_;
+    std::unique_ptr<unsigned char[]> buf_;
+    const unsigned char*             next_{nullptr};   // unconsumed input
+    size_t                           avail_{0};
+    bool                             in_eof_{false};
+    uint64_t                         in_bytes_{0};
+    uint64_t                         out_bytes_{0};
+};
+
+// gzip (concatenated members) or raw deflate (zip entries).
+class InflateSource : public Decompressor {
+public:
+    InflateSource(Source& in, DecodeCtx& c, bool gzip) : Decompressor(in, c), gzip_(gzip) {
+        ok_ = inflateInit2(&zs_, gzip ? 15 + 32 : -MAX_WBITS) == Z_OK;
+    }
+    ~InflateSource() override { if (ok_) inflateEnd(&zs_); }
+
+    long read(char* dst, size_t n) override {
+        if (!ok_) return -1;
+        n = std::min<size_t>(n, UINT_MAX);
+        for (;;) {
+            if (done_) return 0;
+            if (!refill()) return -1;
+            if (ended_) {
+                // another gzip member may follow; trailing zero padding ends the stream
+                if (avail_ == 0 && in_eof_) { done_ = true; return 0; }
+                inflateReset(&zs_);
+                ended_ = false;
+                member_out_ = 0;
+            }
+            const size_t take = std::min<size_t>(avail_, UINT_MAX);
+            zs_.next_in   = const_cast<Bytef*>(next_);
+            zs_.avail_in  = static_cast<uInt>(take);
+            zs_.next_out  = reinterpret_cast<Bytef*>(dst);
+            zs_.avail_out = static_cast<uInt>(n);
+            const int rc = inflate(&zs_, Z_NO_FLUSH);
+            next_  = zs_.next_in;
+            avail_ -= take - zs_.avail_in;
+            const size_t got = n - zs_.avail_out;
+            member_out_ += got;
+            if (rc == Z_STREAM_END) {
+                ++members_;
+                if (gzip_) ended_ = true;
+                else done_ = true;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                if (members_ > 0 && member_out_ == 0) { done_ = true; return 0; } // garbage after the last member
+                c_.fail("corrupt deflate data");
+                return -1;
+            }
+            if (got > 0) return produced(got) ? static_cast<long>(got) : -1;
+            if (rc != Z_STREAM_END && avail_ == 0 && in_eof_) {
+                c_.fail("truncated deflate data");
+                return -1;
+            }
+        }
+    }
+
+private:
+    z_stream zs_{};
+    bool     gzip_;
+    bool     ok_{false};
+    bool     ended_{false};
+    bool     done_{false};
+    uint64_t members_{0};
+    uint64_t member_out_{0};
+};
+
+// xz / lzma (concatenated streams).
+class XzSource : public Decompressor {
+public:
+    XzSource(Source& in, DecodeCtx& c) : Decompressor(in, c) {
+        ok_ = lzma_stream_decoder(&zs_, c.lim.max_decoder_memory, LZMA_CONCATENATED) == LZMA_OK;
+    }
+    ~XzSource() override { lzma_end(&zs_); }
+
+    long read(char* dst, size_t n) override {
+        if (!ok_) return -1;
+        for (;;) {
+            if (done_) return 0;
+            if (!refill()) return -1;
+            zs_.next_in   = next_;
+            zs_.avail_in  = avail_;
+            zs_.next_out  = reinterpret_cast<uint8_t*>(dst);
+            zs_.avail_out = n;
+            const lzma_ret rc = lzma_code(&zs_, in_eof_ ? LZMA_FINISH : LZMA_RUN);
+            next_  = zs_.next_in;
+            avail_ = zs_.avail_in;
+            const size_t got = n - zs_.avail_out;
+            if (rc == LZMA_STREAM_END) done_ = true;
+            else if (rc == LZMA_MEMLIMIT_ERROR) {
+                c_.limit("xz decoder memory limit reached", false);
+                return -1;
+            } else if (rc != LZMA_OK) {
+                c_.fail("corrupt xz data");
+                return -1;
+            }
+            if (got > 0) return produced(got) ? static_cast<long>(got) : -1;
+        }
+    }
+
+private:
+    lzma_stream zs_ = LZMA_STREAM_INIT;
+    bool        ok_{false};
+    bool        done_{false};
+};
+
+#ifdef HAVE_ZSTD
+// zstd (concatenated frames).
+class ZstdSource : public Decompressor {
+public:
+    ZstdSource(Source& in, DecodeCtx& c) : Decompressor(in, c), ds_(ZSTD_createDStream()) {
+        if (ds_) ZSTD_initDStream(ds_);
+    }
+    ~ZstdSource() override { if (ds_) ZSTD_freeDStream(ds_); }
+
+    long read(char* dst, size_t n) override {
+        if (!ds_) return -1;
+        for (;;) {
+            if (!refill()) return -1;
+            if (avail_ == 0 && in_eof_) {
+                if (frame_left_ != 0) { c_.fail("truncated zstd data"); return -1; }
+                return 0;
+            }
+            ZSTD_inBuffer  zin{next_, avail_, 0};
+            ZSTD_outBuffer zout{dst, n, 0};
+            frame_left_ = ZSTD_decompressStream(ds_, &zout, &zin);
+            if (ZSTD_isError(frame_left_)) {
+                c_.fail("corrupt zstd data");
+                return -1;
+            }
+            next_  += zin.pos;
+            avail_ -= zin.pos;
+            if (zout.pos > 0) return produced(zout.pos) ? static_cast<long>(zout.pos) : -1;
+        }
+    }
+
+private:
+    ZSTD_DStream* ds_;
+    size_t        frame_left_{0};
+};
+#endif
+
+static Result decode_source(DecodeCtx& c, Source& src, const std::string& name, unsigned depth);
+
+// Desc: member path inside the scanned file ("a.tar/dir/b.txt" style)
+// In: const std::string& outer, const std::string& member
+// Out: std::string
+static std::string join(const std::string& outer, const std::string& member) {
+    return outer.empty() ? member : outer + "/" + member;
+}
+
+// Desc: hand a stream to the sink as text, kChunk bytes at a time with a kOverlap tail
+// In: DecodeCtx& c, Source& src, const std::string& name, FileKind kind, uint64_t max_bytes
+// Out: Result
+static Result stream_text(DecodeCtx& c, Source& src, const std::string& name, FileKind kind, uint64_t max_bytes) {
+    std::vector<char> buf(ArchiveDecoder::kOverlap + ArchiveDecoder::kChunk);
+    size_t tail = 0;
+    uint64_t total = 0;
+    while (total < max_bytes) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(ArchiveDecoder::kChunk, max_bytes - total));
+        const long r = read_full(src, buf.data() + tail, want);
+        if (r < 0) return Result::Error;
+        if (r == 0) break;
+        if (!c.take(static_cast<uint64_t>(r))) return Result::Limit;
+        total += static_cast<uint64_t>(r);
+        if (!c.sink.text || !c.sink.text(name, kind, std::string_view(buf.data(), tail + static_cast<size_t>(r)))) {
+            return Result::Stopped;
+        }
+        const size_t have = tail + static_cast<size_t>(r);
+        const size_t keep = std::min(ArchiveDecoder::kOverlap, have);
+        std::memmove(buf.data(), buf.data() + have - keep, keep);
+        tail = keep;
+        if (static_cast<size_t>(r) < want) break;
+    }
+    return Result::Done;
+}
+
+// Desc: read a whole member into memory, up to max_document_bytes
+// In: DecodeCtx& c, Source& src, std::vector<char>& out, const std::string& name
+// Out: Result (Done, Limit if the member is larger, Error)
+static Result materialize(DecodeCtx& c, Source& src, std::vector<char>& out, const std::string& name) {
+    const size_t cap = static_cast<size_t>(c.lim.max_document_bytes);
+    out.clear();
+    for (;;) {
+        const size_t at = out.size();
+        if (at > cap) {
+            c.limit("member too large to extract: " + name, false);
+            return Result::Limit;
+        }
+        out.resize(std::min(cap + 1, at + ArchiveDecoder::kChunk));
+        const long r = read_full(src, out.data() + at, out.size() - at);
+        if (r < 0) return Result::Error;
+        out.resize(at + static_cast<size_t>(r));
+        if (!c.take(static_cast<uint64_t>(r))) return Result::Limit;
+        if (r == 0) return Result::Done;
+    }
+}
+
+// Desc: decode one zip entry from its compressed bytes
+// In: DecodeCtx& c, Source& raw, const ZipEntry& e, const std::string& name (of the zip), unsigned depth
+// Out: Result
+static Result decode_zip_entry(DecodeCtx& c, Source& raw, const ZipEntry& e, const std::string& name,
+                               unsigned depth) {
+    if (e.method == 0) return decode_source(c, raw, join(name, e.name), depth + 1);
+    InflateSource inf(raw, c, false);
+    return decode_source(c, inf, join(name, e.name), depth + 1);
+}
+
+// Desc: decode every entry of an in-memory zip
+// In: DecodeCtx& c, std::string_view zip, const std::string& name, unsigned depth
+// Out: Result
+static Result decode_zip(DecodeCtx& c, std::string_view zip, const std::string& name, unsigned depth) {
+    std::vector<ZipEntry> entries;
+    std::string err;
+    if (!ZipReader::list(zip, entries, &err)) {
+        c.fail(err);
+        return Result::Error;
+    }
+    for (const ZipEntry& e : entries) {
+        if (e.name.empty() || e.name.back() == '/') continue;
+        if (++c.members > c.lim.max_members) {
+            c.limit("member count limit reached", true);
+            return Result::Limit;
+        }
+        std::string_view data;
+        if (e.encrypted || (e.method != 0 && e.method != 8) || !ZipReader::data(zip, e, data, &err)) {
+            c.limit("unreadable zip entry: " + join(name, e.name), false);
+            continue;
+        }
+        MemSource ms(data);
+        if (decode_zip_entry(c, ms, e, name, depth) == Result::Stopped) return Result::Stopped;
+        if (c.abort) return Result::Limit;
+    }
+    return Result::Done;
+}
+
+// Desc: decode every entry of a zip file read with pread (a file truncated meanwhile
+//       reads short and ends its entries early; only the directory is held in memory)
+// In: DecodeCtx& c, int fd, uint64_t fsz
+// Out: Result
+static Result decode_zip_file(DecodeCtx& c, int fd, uint64_t fsz) {
+    std::vector<ZipEntry> entries;
+    std::string err;
+    if (!ZipReader::list(fd, fsz, c.lim.max_document_bytes, entries, &err)) {
+        c.fail(err);
+        return Result::Error;
+    }
+    for (const ZipEntry& e : entries) {
+        if (e.name.empty() || e.name.back() == '/') continue;
+        if (++c.members > c.lim.max_members) {
+            c.limit("member count limit reached", true);
+            return Result::Limit;
+        }
+        uint64_t off = 0;
+        if (e.encrypted || (e.method != 0 && e.method != 8) || !ZipReader::data(fd, fsz, e, off, &err)) {
+            c.limit("unreadable zip entry: " + e.name, false);
+            continue;
+        }
+        FdSource fs(fd, e.comp_size, off);
+        if (decode_zip_entry(c, fs, e, std::string(), 0) == Result::Stopped) return Result::Stopped;
+        if (c.abort) return Result::Limit;
+    }
+    return Result::Done;
+}
+
+// Desc: parse an octal (or GNU base-256) tar number field
+// In: const char* p, size_t n, uint64_t& out
+// Out: bool
+static bool tar_number(const char* p, size_t n, uint64_t& out) {
+    out = 0;
+    if (static_cast<unsigned char>(p[0]) & 0x80) {
+        for (size_t i = 1; i < n; ++i) out = (out << 8) | static_cast<unsigned char>(p[i]);
+        return true;
+    }
+    size_t i = 0;
+    while (i < n && (p[i] == ' ' || p[i] == '\0')) ++i;
+    for (; i < n && p[i] >= '0' && p[i] <= '7'; ++i) out = (out << 3) | static_cast<uint64_t>(p[i] - '0');
+    return true;
+}
+
+// Desc: header checksum (chksum field counted as spaces)
+// In: const unsigned char* h
+// Out: bool
+static bool tar_checksum_ok(const char* h) {
+    uint64_t want = 0;
+    tar_number(h + 148, 8, want);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < 512; ++i) sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(h[i]);
+    return sum == want;
+}
+
+// Desc: read a small metadata member (GNU long name, pax header) fully
+// In: Source& src, uint64_t size, std::string& out
+// Out: bool
+static bool tar_meta(Source& src, uint64_t size, std::string& out) {
+    if (size > (1u << 20)) return false;
+    out.resize(static_cast<size_t>(size));
+    return read_full(src, &out[0], out.size()) == static_cast<long>(out.size());
+}
+
+// Desc: "path" record of a pax extended header
+// In: const std::string& pax
+// Out: std::string (empty if none)
+static std::string pax_path(const std::string& pax) {
+    size_t pos = 0;
+    while (pos < pax.size()) {
+        const size_t sp = pax.find(' ', pos);
+        if (sp == std::string::npos) break;
+        const size_t len = static_cast<size_t>(std::strtoull(pax.c_str() + pos, nullptr, 10));
+        if (len == 0 || pos + len > pax.size()) break;
+        const std::string rec = pax.substr(sp + 1, pos + len - sp - 2); // "key=value" without '\n'
+        if (rec.compare(0, 5, "path=") == 0) return rec.substr(5);
+        pos += len;
+    }
+    return std::string();
+}
+
+// Desc: decode every regular member of a tar stream
+// In: DecodeCtx& c, Source& src, const std::string& name, unsigned depth
+// Out: Result
+static Result decode_tar(DecodeCtx& c, Source& src, const std::string& name, unsigned depth) {
+    char h[512];
+    std::string long_name, meta;
+    for (;;) {
+        const long r = read_full(src, h, sizeof(h));
+        if (r < 0) return Result::Error;
+        if (r == 0) return Result::Done;
+        if (r < 512) { c.fail("truncated tar header"); return Result::Error; }
+        if (std::all_of(h, h + 512, [](char ch) { return ch == 0; })) return Result::Done; // end blocks
+        if (!tar_checksum_ok(h)) { c.fail("bad tar header checksum"); return Result::Error; }
+
+        uint64_t size = 0;
+        tar_number(h + 124, 12, size);
+        const char type = h[156];
+        const uint64_t pad = (512 - size % 512) % 512;
+
+        if (type == 'L' || type == 'x') {
+            if (!tar_meta(src, size, meta) || !src.skip(pad)) { c.fail("bad tar extended header"); return Result::Error; }
+            long_name = type == 'L' ? std::string(meta.c_str()) : pax_path(meta);
+            continue;
+        }
+        std::string member = long_name;
+        long_name.clear();
+        if (member.empty()) {
+            member.assign(h, strnlen(h, 100));
+            if (std::memcmp(h + 257, "ustar", 5) == 0 && h[345] != '\0') {
+                member = std::string(h + 345, strnlen(h + 345, 155)) + "/" + member;
+            }
+        }
+
+        LimitSource body(src, size);
+        if (type == '0' || type == '\0' || type == '7') {
+            if (++c.members > c.lim.max_members) {
+                c.limit("member count limit reached", true);
+                return Result::Limit;
+            }
+            const Result res = decode_source(c, body, join(name, member), depth + 1);
+            if (res == Result::Stopped) return res;
+            if (c.abort) return Result::Limit;
+        }
+        // a failure inside the member is local; one reading the archive itself is not
+        if (!body.drain() || !src.skip(pad)) {
+            c.fail("truncated tar member: " + member);
+            return Result::Error;
+        }
+    }
+}
+
+// Desc: decode a stream whose kind is known
+// In: DecodeCtx& c, Source& src, FileKind kind, const std::string& name, unsigned depth
+// Out: Result
+static Result decode_kind(DecodeCtx& c, Source& src, FileKind kind, const std::string& name, unsigned depth) {
+    const TypePolicy pol = c.pol ? c.pol->of(kind) : TypePolicy::Scan;
+    if (pol == TypePolicy::Skip) return Result::Done;
+    const uint64_t max_bytes = pol == TypePolicy::Head ? c.pol->head_bytes : UINT64_MAX;
+
+    if (depth < c.lim.max_depth) {
+        switch (kind) {
+        case FileKind::Gzip: {
+            InflateSource d(src, c, true);
+            return decode_source(c, d, name, depth + 1);
+        }
+        case FileKind::Xz: {
+            XzSource d(src, c);
+            return decode_source(c, d, name, depth + 1);
+        }
+#ifdef HAVE_ZSTD
+        case FileKind::Zstd: {
+            ZstdSource d(src, c);
+            return decode_source(c, d, name, depth + 1);
+        }
+#endif
+        case FileKind::Tar:
+            return decode_tar(c, src, name, depth);
+        default:
+            break;
+        }
+    } else if (ArchiveDecoder::isContainer(kind)) {
+        // too deep to open: the member is still scanned as raw bytes
+        c.limit("depth limit reached", false);
+    }
+    const bool nested_zip = kind == FileKind::Zip && depth < c.lim.max_depth;
+    if (nested_zip || kind == FileKind::Pdf || kind == FileKind::Office) {
+        // random-access formats: the member has to be in memory
+        std::vector<char> doc;
+        const Result r = materialize(c, src, doc, name);
+        if (r != Result::Done) return r;
+        const std::string_view bytes(doc.data(), doc.size());
+        if (nested_zip) return decode_zip(c, bytes, name, depth);
+        if (c.sink.document && !c.sink.document(name, kind, bytes)) return Result::Stopped;
+        return Result::Done;
+    }
+    return stream_text(c, src, name, kind, max_bytes);
+}
+
+// Desc: classify a stream from its head, then decode it
+// In: DecodeCtx& c, Source& src, const std::string& name, unsigned depth
+// Out: Result
+static Result decode_source(DecodeCtx& c, Source& src, const std::string& name, unsigned depth) {
+    PeekSource ps(src);
+    if (!ps.peek(FileClassifier::kHeadBytes)) return Result::Error;
+    if (ps.head().empty()) return Result::Done;
+    return decode_kind(c, ps, FileClassifier::classify(ps.head()).kind, name, depth);
+}
+
+// Desc: kinds decode() can open
+// In: FileKind k
+// Out: bool
+bool ArchiveDecoder::isContainer(FileKind k) {
+    switch (k) {
+    case FileKind::Gzip: case FileKind::Xz: case FileKind::Tar: case FileKind::Zip:
+        return true;
+#ifdef HAVE_ZSTD
+    case FileKind::Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Desc: decode a container file and stream its contents to the sink (see header)
+// In: int fd, size_t fsz, FileKind kind, const ArchiveLimits& limits, const TypePolicies* policies,
+//     const Sink& sink, std::string* error
+// Out: Result
+ArchiveDecoder::Result ArchiveDecoder::decode(int fd, size_t fsz, FileKind kind, const ArchiveLimits& limits,
+                                              const TypePolicies* policies, const Sink& sink, std::string* error) {
+    DecodeCtx c{limits, policies, sink};
+    Result r;
+    if (kind == FileKind::Zip) {
+        // the central directory is at the end: read it, then each entry, with pread
+        if (fsz == 0) return Result::Done;
+        r = decode_zip_file(c, fd, fsz);
+    } else {
+        FdSource src(fd, fsz);
+        r = decode_kind(c, src, kind, std::string(), 0);
+    }
+    if (error) *error = c.error;
+    if (r == Result::Stopped) return r;
+    return c.limited ? Result::Limit : r;
+}
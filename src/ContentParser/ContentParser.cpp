@@ -1,15 +1,18 @@
 #include "ContentParser.hpp"
+#include "FileClassifier.hpp"
+#include "OfficeExtractor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <poppler/cpp/poppler-document.h>
 #include <poppler/cpp/poppler-page.h>
 #include <ctime>
 #include <unistd.h>
 #include <cstring>
-#include <cstdlib>
-#include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <iterator>
+#include <limits>
 
 
 // Desc: write a timestamped Poppler error line to a log pipe
@@ -26,134 +29,223 @@ static inline void log_poppler_error(const char* msg, int log_pipe_fd) {
     (void)_wr;
 }
 
-// Desc: extract text from in-memory PDF data; log errors; fallback to raw
-// In: const std::string& data, int log_pipe_fd
-// Out: std::string (PDF text or original data on failure)
-static std::string extract_text_from_pdf_data(const std::string& data,
-                                                      int log_pipe_fd) {
-    try {
-        poppler::byte_array ba;
-        ba.assign(data.begin(), data.end());
-
-        std::unique_ptr<poppler::document> doc(
-            poppler::document::load_from_data(&ba)
-        );
-        if (!doc) {
-            log_poppler_error("load_from_data failed", log_pipe_fd);
-            return data;
-        }
+// extra page workers alive across all documents (bounded by PdfLimits::threads)
+static std::atomic<unsigned> g_pdf_helpers{0};
 
-        std::string text;
-        const int pages = doc->pages();
-        for (int i = 0; i < pages; ++i) {
-            auto page = doc->create_page(i);
-            if (!page) continue;
+// Desc: load a PDF straight from the caller's buffer (no byte_array copy)
+// In: std::string_view data
+// Out: poppler::document* (nullptr on failure; caller owns)
+static poppler::document* load_pdf(std::string_view data) {
+    return poppler::document::load_from_raw_data(data.data(), static_cast<int>(data.size()));
+}
 
-        auto u = page->text().to_utf8();     // u: poppler::byte_array = std::vector<char>
-        if (!u.empty()) {
-            text.append(u.begin(), u.end());
-            text.push_back('\n');
-        }
-        }
-        if (text.empty()) {
-            log_poppler_error("empty extraction result", log_pipe_fd);
-            return data;
-        }
-        return text;
+// Desc: stream PDF pages to on_page with early exit, parallel workers and budgets
+// In: std::string_view raw_content, int log_pipe_fd, const PdfLimits& limits, on_page
+// Out: int (pages delivered, -1 if the document cannot be loaded)
+int ContentParser::extract_pdf_pages(std::string_view raw_content, int log_pipe_fd, const PdfLimits& limits,
+                                     const std::function<bool(int, std::string_view)>& on_page) {
+    using Clock = std::chrono::steady_clock;
+    if (raw_content.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        log_poppler_error("pdf too large for in-memory load", log_pipe_fd);
+        return -1;
+    }
+    std::unique_ptr<poppler::document> doc;
+    try {
+        doc.reset(load_pdf(raw_content));
     } catch (const std::exception& e) {
         log_poppler_error(e.what(), log_pipe_fd);
-        return data;
+        return -1;
     } catch (...) {
         log_poppler_error("unknown exception", log_pipe_fd);
-        return data;
+        return -1;
+    }
+    if (!doc) {
+        log_poppler_error("load_from_raw_data failed", log_pipe_fd);
+        return -1;
     }
-}
-
-
-static std::string extract_text_from_doc_data(
-    const std::string& file_path,
-    int log_pipe_fd)
-{
-    namespace fs = std::filesystem;
-
-    try {
-        if (file_path.empty() || !fs::exists(file_path)) {
-            log_poppler_error("invalid file path", log_pipe_fd);
-            return {};
-        }
-
-        if (std::system("command -v libreoffice >/dev/null 2>&1") != 0) {
-            log_poppler_error("libreoffice not installed", log_pipe_fd);
-            return {};
-        }
 
-        std::string tmpdir_tmpl = (fs::temp_directory_path() / "cpXXXXXX").string();
-        std::vector<char> buf(tmpdir_tmpl.begin(), tmpdir_tmpl.end());
-        buf.push_back('\0');
-        char* tmpdir = mkdtemp(buf.data());
-        if (!tmpdir) {
-            log_poppler_error("mkdtemp failed", log_pipe_fd);
-            return {};
+    const int pages = doc->pages();
+    const int limit = (limits.max_pages > 0 && limits.max_pages < pages) ? limits.max_pages : pages;
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(limits.time_budget_ms);
+    std::atomic<int>  next{0};
+    std::atomic<int>  delivered{0};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> out_of_time{false};
+
+    // workers pull page indexes; the first on_page that returns false stops all of them
+    auto work = [&](poppler::document* d) {
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (limits.time_budget_ms > 0 && Clock::now() >= deadline) {
+                out_of_time.store(true, std::memory_order_relaxed);
+                return;
+            }
+            const int i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= limit) return;
+            std::unique_ptr<poppler::page> page(d->create_page(i));
+            if (!page) continue;
+            auto u = page->text().to_utf8();     // u: poppler::byte_array = std::vector<char>
+            if (u.empty()) continue;
+            delivered.fetch_add(1, std::memory_order_relaxed);
+            if (!on_page(i, std::string_view(u.data(), u.size()))) stop.store(true, std::memory_order_relaxed);
         }
-
-        fs::path tmpdir_path(tmpdir);
-        std::string filename = fs::path(file_path).filename().string();
-        fs::path out_txt = tmpdir_path / (filename + ".txt");
-        fs::path err_file = tmpdir_path / "stderr.txt";
-
-        std::string cmd = "libreoffice --headless --convert-to txt:Text \"" +
-            file_path + "\" --outdir \"" + tmpdir_path.string() +
-            "\" 2>\"" + err_file.string() + "\"";
-        std::system(cmd.c_str());
-
-        if (!fs::exists(out_txt)) {
-            if (fs::exists(err_file)) {
-                std::ifstream e(err_file);
-                std::string err((std::istreambuf_iterator<char>(e)), {});
-                log_poppler_error(("convert failed: " + err).c_str(), log_pipe_fd);
-            } else {
-                log_poppler_error("no output file", log_pipe_fd);
+    };
+
+    unsigned helpers = 0;
+    if (limits.threads > 1 && limit >= limits.parallel_min_pages) {
+        const unsigned want = std::min<unsigned>(limits.threads - 1, static_cast<unsigned>(limit - 1));
+        unsigned cur = g_pdf_helpers.load(std::memory_order_relaxed);
+        while (helpers < want && cur < limits.threads) {
+            if (g_pdf_helpers.compare_exchange_weak(cur, cur + 1, std::memory_order_relaxed)) {
+                ++helpers;
+                cur = g_pdf_helpers.load(std::memory_order_relaxed);
             }
-            fs::remove_all(tmpdir_path);
-            return {};
         }
-
-        std::ifstream in(out_txt);
-        std::string result((std::istreambuf_iterator<char>(in)), {});
-        fs::remove_all(tmpdir_path);
-        return result;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(helpers);
+    for (unsigned h = 0; h < helpers; ++h) {
+        pool.emplace_back([&]() {
+            // Poppler documents are not shared between threads: each helper loads its own
+            try {
+                std::unique_ptr<poppler::document> d(load_pdf(raw_content));
+                if (d) work(d.get());
+            } catch (...) {
+                // the pages it would have taken are picked up by the other workers
+            }
+            g_pdf_helpers.fetch_sub(1, std::memory_order_relaxed);
+        });
+    }
+    try {
+        work(doc.get());
     } catch (const std::exception& e) {
         log_poppler_error(e.what(), log_pipe_fd);
-        return {};
     } catch (...) {
         log_poppler_error("unknown exception", log_pipe_fd);
-        return {};
     }
+    for (auto& t : pool) t.join();
+
+    const int n = delivered.load();
+    if (!stop.load() && (limit < pages || out_of_time.load())) {
+        const std::string msg = "page budget reached: " + std::to_string(std::min(next.load(), limit)) +
+                                " of " + std::to_string(pages) + " pages extracted";
+        log_poppler_error(msg.c_str(), log_pipe_fd);
+    } else if (n == 0) {
+        log_poppler_error("empty extraction result", log_pipe_fd);
+    }
+    return n;
+}
+
+// Desc: extract the text of every page of in-memory PDF data as its own segment
+//       (Poppler reads the caller's buffer directly; pages are never concatenated)
+// In: std::string_view data, int log_pipe_fd, ExtractedText& out
+// Out: bool (false on failure or empty result; caller falls back to raw)
+static bool extract_pdf_segments(std::string_view data, int log_pipe_fd, ExtractedText& out) {
+    static const char kPageSep = '\n';
+    PdfLimits sequential;
+    sequential.threads = 1;   // pages arrive in order
+    const int n = ContentParser::extract_pdf_pages(data, log_pipe_fd, sequential,
+        [&](int, std::string_view page) {
+            out.owned.emplace_back(page.begin(), page.end());
+            return true;
+        });
+    if (n <= 0) return false;
+    // pages are separated as before ("page\n"), so matches cannot glue two pages' words
+    for (const auto& p : out.owned) {
+        out.segments.emplace_back(p.data(), p.size());
+        out.segments.emplace_back(&kPageSep, 1);
+    }
+    return true;
 }
 
 
+// Desc: write a timestamped office-extraction error line to a log pipe
+// In: const std::string& msg, int log_pipe_fd
+// Out: void
+static void log_office_error(const std::string& msg, int log_pipe_fd) {
+    std::time_t now = std::time(nullptr);
+    char* dt = std::ctime(&now);
+    if (dt) dt[strlen(dt)-1] = '\0'; // remove \n
 
-// Desc: detect content type from raw bytes ("%PDF-" => "pdf")
-// In: const std::string& raw_content
-// Out: std::string ("pdf" or "text")
-std::string ContentParser::detect_type(const std::string& raw_content) {
-    if (raw_content.rfind("%PDF-", 0) == 0) return "pdf";
-    if (raw_content.rfind("PK", 0) == 0) return "docx";  // ZIP signature
-    return "text";
+    std::string line = "[" + std::string(dt ? dt : "") + "] [ContentParser] office error: "
+                     + msg + "\n";
+    ssize_t _wr = ::write(log_pipe_fd, line.c_str(), line.size());
+    (void)_wr;
+}
+
+// Desc: OOXML/ODF text part by part (in-process, see OfficeExtractor)
+// In: std::string_view raw_content, int log_pipe_fd, on_part (false = stop), bool* limited
+// Out: bool (false if not a supported office document)
+bool ContentParser::extract_office_parts(std::string_view raw_content, int log_pipe_fd,
+                                         const std::function<bool(std::string_view)>& on_part,
+                                         bool* limited) {
+    std::string error;
+    const bool ok = OfficeExtractor::extract(raw_content, on_part, &error, limited);
+    // plain archives (jar, zip) simply have no document parts: not worth a log line
+    if (!error.empty() && error != "no document text parts") log_office_error(error, log_pipe_fd);
+    return ok;
 }
 
-// Desc: extract text based on type (PDF via Poppler, else passthrough)
-// In: const std::string& type, const std::string& raw_content, int log_pipe_fd
-// Out: std::string (extracted or original text)
-std::string ContentParser::extract_text(const std::string& type,
-                                        const std::string& file_path,
-                                        const std::string& raw_content,
-                                        int log_pipe_fd) {
+// Desc: decode a compressed file or archive into the sink (see header)
+// In: int fd, size_t fsz, FileKind kind, const ArchiveLimits& limits, const TypePolicies* policies,
+//     int log_pipe_fd, const ArchiveDecoder::Sink& sink
+// Out: ArchiveDecoder::Result (Error if the container could not be decoded at all)
+ArchiveDecoder::Result ContentParser::extract_archive(int fd, size_t fsz, FileKind kind, const ArchiveLimits& limits,
+                                                      const TypePolicies* policies, int log_pipe_fd,
+                                                      const ArchiveDecoder::Sink& sink) {
+    std::string error;
+    const ArchiveDecoder::Result r = ArchiveDecoder::decode(fd, fsz, kind, limits, policies, sink, &error);
+    if (r != ArchiveDecoder::Result::Stopped && !error.empty()) {
+        std::time_t now = std::time(nullptr);
+        char* dt = std::ctime(&now);
+        if (dt) dt[strlen(dt)-1] = '\0'; // remove \n
+        std::string line = "[" + std::string(dt ? dt : "") + "] [ContentParser] archive " +
+                           FileClassifier::name(kind) + ": " + error + "\n";
+        ssize_t _wr = ::write(log_pipe_fd, line.c_str(), line.size());
+        (void)_wr;
+    }
+    return r;
+}
+
+// Desc: detect content type from the first bytes (magic numbers, text/binary, entropy)
+// In: std::string_view raw_content
+// Out: std::string (FileClassifier kind name)
+std::string ContentParser::detect_type(std::string_view raw_content) {
+    return FileClassifier::name(FileClassifier::classify(raw_content).kind);
+}
+
+// Desc: extract text based on type (PDF via Poppler, OOXML/ODF in-process, else passthrough) as segments
+// In: const std::string& type, std::string_view raw_content,
+//     int log_pipe_fd, ExtractedText& out
+// Out: void (out.segments: extracted text, or the raw content on failure)
+void ContentParser::extract(const std::string& type,
+                            std::string_view raw_content,
+                            int log_pipe_fd,
+                            ExtractedText& out) {
+    out.owned.clear();
+    out.segments.clear();
     if (type == "pdf") {
-        return extract_text_from_pdf_data(raw_content, log_pipe_fd);
+        if (extract_pdf_segments(raw_content, log_pipe_fd, out)) return;
+        out.owned.clear();
+        out.segments.clear();
+        out.segments.push_back(raw_content);
+        return;
     }
-    if (type == "doc" || type == "docx") {
-        return extract_text_from_doc_data(file_path, log_pipe_fd);
+    if (type == "doc" || type == "docx" || type == "zip") {
+        static const char kPartSep = '\n';
+        const bool ok = extract_office_parts(raw_content, log_pipe_fd, [&](std::string_view part) {
+            out.owned.emplace_back(part.begin(), part.end());
+            return true;
+        });
+        if (!ok) {
+            out.owned.clear();
+            out.segments.push_back(raw_content); // not an office document: scan the bytes
+            return;
+        }
+        for (const auto& p : out.owned) {
+            out.segments.emplace_back(p.data(), p.size());
+            out.segments.emplace_back(&kPartSep, 1);
+        }
+        return;
     }
-    return raw_content;
+    out.segments.push_back(raw_content);
 }
@@ -0,0 +1,452 @@
+// === src/ContentParser/ExtractorPool.cpp ===
+#include "ExtractorPool.hpp"
+#include "FileIO.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using PoolClock = std::chrono::steady_clock;
+
+// parent -> helper message types (one byte, then the payload)
+static const char     kMsgJob    = 'J';   // JobHeader + memfd (SCM_RIGHTS)
+static const char     kMsgCancel = 'C';   // stop the running job after the current part
+static const char     kMsgGo     = 'G';   // pre-exec: the parent knows the child's pid
+// helper -> parent, once after startup
+static const char     kMsgReady  = 'R';
+// helper -> parent: u32 length + text, repeated; kEndFrame + i32 result ends a job
+// (PDF: pages; office: 0, or kResultLimited if a size limit cut the text short; -1 failure)
+static const uint32_t kEndFrame  = 0xFFFFFFFFu;
+static const int32_t  kResultLimited = 1;
+static const uint32_t kMaxFrame  = 256u << 20;
+// fd numbers the helper finds its socket and log pipe on
+static const int      kHelperSock = 3;
+static const int      kHelperLog  = 4;
+
+// One document to extract.
+struct JobHeader {
+    uint32_t kind;
+    uint32_t pdf_threads;
+    int32_t  pdf_max_pages;
+    int32_t  pdf_parallel_min_pages;
+    uint64_t pdf_time_budget_ms;
+    uint64_t size;
+};
+
+// Desc: timestamped pool message to the log pipe
+// In: const std::string& msg, int log_fd
+// Out: void
+static void log_pool(const std::string& msg, int log_fd) {
+    std::time_t now = std::time(nullptr);
+    char* dt = std::ctime(&now);
+    if (dt) dt[strlen(dt)-1] = '\0'; // remove \n
+    std::string line = "[" + std::string(dt ? dt : "") + "] [ExtractorPool] " + msg + "\n";
+    ssize_t _wr = ::write(log_fd, line.c_str(), line.size());
+    (void)_wr;
+}
+
+// Desc: write all bytes to a socket/fd (no SIGPIPE)
+// In: int fd, const void* p, size_t n
+// Out: bool
+static bool send_all(int fd, const void* p, size_t n) {
+    const char* c = static_cast<const char*>(p);
+    while (n > 0) {
+        const ssize_t w = ::send(fd, c, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        c += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+// Desc: read exactly n bytes, giving up at the deadline
+// In: int fd, void* p, size_t n, PoolClock::time_point deadline
+// Out: bool (false on EOF, error or timeout)
+static bool recv_until(int fd, void* p, size_t n, PoolClock::time_point deadline) {
+    char* c = static_cast<char*>(p);
+    while (n > 0) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - PoolClock::now()).count();
+        if (left <= 0) return false;
+        struct pollfd pfd{fd, POLLIN, 0};
+        const int pr = ::poll(&pfd, 1, static_cast<int>(std::min<long long>(left, INT_MAX)));
+        if (pr < 0 && errno == EINTR) continue;
+        if (pr <= 0) return false;
+        const ssize_t r = ::recv(fd, c, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        c += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+// Desc: read exactly n bytes (blocking)
+// In: int fd, void* p, size_t n
+// Out: bool
+static bool recv_all(int fd, void* p, size_t n) {
+    char* c = static_cast<char*>(p);
+    while (n > 0) {
+        const ssize_t r = ::recv(fd, c, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        c += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+ExtractorPool::~ExtractorPool() { stop(); }
+
+// Desc: locate the daemon binary and start the spawner thread (see header)
+// In: const ExtractorPoolOptions& opt, int log_fd
+// Out: bool
+bool ExtractorPool::start(const ExtractorPoolOptions& opt, int log_fd) {
+    char exe[PATH_MAX];
+    const ssize_t n = ::readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (n <= 0) return false;
+    exe[n] = '\0';
+
+    std::lock_guard<std::mutex> lk(mu_);
+    if (running_) return true;
+    opt_    = opt;
+    log_fd_ = log_fd;
+    exe_    = exe;
+    const size_t count = std::max(1u, opt.helpers);
+    helpers_.assign(count, Helper{});
+    pids_.reset(new std::atomic<pid_t>[count]);
+    idle_.clear();
+    dead_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        pids_[i].store(-1, std::memory_order_relaxed);
+        dead_.push_back(i);
+    }
+    running_ = true;
+    spawner_ = std::thread(&ExtractorPool::spawner_loop_, this);
+    return true;
+}
+
+// Desc: stop the spawner, close every helper socket (helpers exit on EOF) and reap them
+// In: (none)
+// Out: void
+void ExtractorPool::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (spawner_.joinable()) spawner_.join();
+    std::lock_guard<std::mutex> lk(mu_);
+    for (size_t i = 0; i < helpers_.size(); ++i) retire_(i, false);
+    idle_.clear();
+    dead_.clear();
+}
+
+// Desc: true if pid belongs to a helper
+// In: pid_t pid
+// Out: bool
+bool ExtractorPool::owns(pid_t pid) const {
+    if (!pids_) return false;
+    for (size_t i = 0; i < helpers_.size(); ++i) {
+        if (pids_[i].load(std::memory_order_acquire) == pid) return true;
+    }
+    return false;
+}
+
+// Desc: (re)start helpers whose slots are dead; a helper is idle once it reported ready
+// In: (none)
+// Out: void
+void ExtractorPool::spawner_loop_() {
+    for (;;) {
+        size_t slot = 0;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&]() { return !running_ || !dead_.empty(); });
+            if (!running_) return;
+            slot = dead_.back();
+            dead_.pop_back();
+        }
+        char ready = 0;
+        const auto deadline = PoolClock::now() + std::chrono::milliseconds(opt_.job_timeout_ms);
+        if (spawn_(slot) && recv_until(helpers_[slot].sock, &ready, 1, deadline) && ready == kMsgReady) {
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                idle_.push_back(slot);
+            }
+            cv_.notify_all();
+            continue;
+        }
+        log_pool("helper failed to start; retrying", log_fd_);
+        retire_(slot, true);
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            dead_.push_back(slot);
+            // back off before the next attempt
+            cv_.wait_for(lk, std::chrono::seconds(1), [&]() { return !running_; });
+        }
+    }
+}
+
+// Desc: fork + exec one helper connected through a socketpair
+// In: size_t slot
+// Out: bool
+bool ExtractorPool::spawn_(size_t slot) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return false;
+
+    // everything the child needs is prepared before fork: only async-signal-safe calls after it
+    const std::string mem = std::to_string(opt_.mem_limit_mb);
+    const std::string cpu = std::to_string(opt_.cpu_limit_sec);
+    const std::string s_fd = std::to_string(kHelperSock), l_fd = std::to_string(kHelperLog);
+    std::vector<char*> argv = {const_cast<char*>(exe_.c_str()), const_cast<char*>("extractor-helper"),
+                               const_cast<char*>(s_fd.c_str()), const_cast<char*>(l_fd.c_str()),
+                               const_cast<char*>(mem.c_str()), const_cast<char*>(cpu.c_str()), nullptr};
+    struct rlimit nof{};
+    ::getrlimit(RLIMIT_NOFILE, &nof);
+    const int max_fd = nof.rlim_cur == RLIM_INFINITY || nof.rlim_cur > 65536 ? 65536 : static_cast<int>(nof.rlim_cur);
+    const int log_fd = log_fd_;
+
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        ::close(sv[0]);
+        ::close(sv[1]);
+        return false;
+    }
+    if (pid == 0) {
+        ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+        // socket and log pipe on fixed numbers; every other inherited fd (fanotify
+        // event fds included) is closed so the helper pins nothing
+        const int s = ::fcntl(sv[1], F_DUPFD, 16);
+        const int l = log_fd >= 0 ? ::fcntl(log_fd, F_DUPFD, 16) : ::open("/dev/null", O_WRONLY);
+        if (s < 0 || l < 0 || ::dup2(s, kHelperSock) < 0 || ::dup2(l, kHelperLog) < 0) ::_exit(127);
+#ifdef SYS_close_range
+        if (::syscall(SYS_close_range, kHelperLog + 1, ~0u, 0) != 0)
+#endif
+            for (int fd = kHelperLog + 1; fd < max_fd; ++fd) ::close(fd);
+        // exec only once the parent has published our pid: the exec's own permission
+        // event is then recognized by owns()
+        char go = 0;
+        if (::read(kHelperSock, &go, 1) != 1) ::_exit(127);
+        ::execv(argv[0], argv.data());
+        ::_exit(127);
+    }
+    ::close(sv[1]);
+    Helper& h = helpers_[slot];
+    h.pid  = pid;
+    h.sock = sv[0];
+    h.jobs = 0;
+    pids_[slot].store(pid, std::memory_order_release);
+    return send_all(h.sock, &kMsgGo, 1);
+}
+
+// Desc: shut a helper down (EOF on its socket, or SIGKILL) and reap it
+// In: size_t slot, bool kill
+// Out: void
+void ExtractorPool::retire_(size_t slot, bool kill) {
+    Helper& h = helpers_[slot];
+    if (h.pid > 0 && kill) ::kill(h.pid, SIGKILL);
+    if (h.sock >= 0) ::close(h.sock);
+    if (h.pid > 0) {
+        // a helper told to exit finishes its current write and leaves; do not wait forever
+        int status = 0;
+        for (int i = 0; i < 100 && ::waitpid(h.pid, &status, WNOHANG) == 0; ++i) ::usleep(10000);
+        if (::waitpid(h.pid, &status, WNOHANG) == 0) {
+            ::kill(h.pid, SIGKILL);
+            ::waitpid(h.pid, &status, 0);
+        }
+    }
+    pids_[slot].store(-1, std::memory_order_release);
+    h = Helper{};
+}
+
+// Desc: run one document on a free helper (see header)
+// In: FileKind kind, std::string_view raw, const PdfLimits& pdf, on_part, bool* limited
+// Out: int
+int ExtractorPool::extract(FileKind kind, std::string_view raw, const PdfLimits& pdf,
+                           const std::function<bool(std::string_view)>& on_part, bool* limited) {
+    size_t slot = 0;
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait_for(lk, std::chrono::milliseconds(opt_.job_timeout_ms),
+                     [&]() { return !running_ || !idle_.empty(); });
+        if (!running_ || idle_.empty()) return -3;
+        slot = idle_.back();
+        idle_.pop_back();
+    }
+    Helper& h = helpers_[slot];
+    const int r = run_job_(h, kind, raw, pdf, on_part, limited);
+    bool respawn = false;
+    if (r == -2) {
+        log_pool("helper " + std::to_string(h.pid) + " failed (crash or timeout); restarting", log_fd_);
+        retire_(slot, true);
+        respawn = true;
+    } else if (++h.jobs >= opt_.max_jobs) {
+        retire_(slot, false);
+        respawn = true;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        (respawn ? dead_ : idle_).push_back(slot);
+    }
+    cv_.notify_all();
+    return r;
+}
+
+// Desc: send a document to a helper and relay its text parts until the end frame
+// In: Helper& h, FileKind kind, std::string_view raw, const PdfLimits& pdf, on_part, bool* limited
+// Out: int (parts delivered, -1 parse failure, -2 helper failure)
+int ExtractorPool::run_job_(Helper& h, FileKind kind, std::string_view raw, const PdfLimits& pdf,
+                            const std::function<bool(std::string_view)>& on_part, bool* limited) {
+    const int mfd = ::memfd_create("fileguard-doc", MFD_CLOEXEC);
+    if (mfd < 0) return -2;
+    if (!write_all(mfd, raw.data(), raw.size())) {
+        ::close(mfd);
+        return -2;
+    }
+
+    char msg[1 + sizeof(JobHeader)];
+    JobHeader hdr{};
+    hdr.kind                   = static_cast<uint32_t>(kind);
+    hdr.pdf_threads            = pdf.threads;
+    hdr.pdf_max_pages          = pdf.max_pages;
+    hdr.pdf_parallel_min_pages = pdf.parallel_min_pages;
+    hdr.pdf_time_budget_ms     = pdf.time_budget_ms;
+    hdr.size                   = raw.size();
+    msg[0] = kMsgJob;
+    std::memcpy(msg + 1, &hdr, sizeof(hdr));
+
+    struct iovec iov{msg, sizeof(msg)};
+    char cbuf[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr mh{};
+    mh.msg_iov        = &iov;
+    mh.msg_iovlen     = 1;
+    mh.msg_control    = cbuf;
+    mh.msg_controllen = sizeof(cbuf);
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&mh);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type  = SCM_RIGHTS;
+    cm->cmsg_len   = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cm), &mfd, sizeof(int));
+    const ssize_t sent = ::sendmsg(h.sock, &mh, MSG_NOSIGNAL);
+    ::close(mfd);
+    if (sent != static_cast<ssize_t>(sizeof(msg))) return -2;
+
+    const auto deadline = PoolClock::now() + std::chrono::milliseconds(opt_.job_timeout_ms);
+    std::string part;
+    int delivered = 0;
+    bool stopped = false;
+    for (;;) {
+        uint32_t len = 0;
+        if (!recv_until(h.sock, &len, sizeof(len), deadline)) return -2;
+        if (len == kEndFrame) {
+            int32_t result = 0;
+            if (!recv_until(h.sock, &result, sizeof(result), deadline)) return -2;
+            if (limited) *limited = kind != FileKind::Pdf && result == kResultLimited;
+            return result < 0 && delivered == 0 ? -1 : delivered;
+        }
+        if (len > kMaxFrame) return -2;
+        part.resize(len);
+        if (len > 0 && !recv_until(h.sock, &part[0], len, deadline)) return -2;
+        if (stopped) continue; // parts already in flight when the cancel was sent
+        ++delivered;
+        if (!on_part(part)) {
+            stopped = true;
+            if (!send_all(h.sock, &kMsgCancel, 1)) return -2;
+        }
+    }
+}
+
+// Desc: helper process main loop: extract documents sent by the pool until its socket closes
+// In: int argc, char** argv ("extractor-helper <sock> <log_fd> <mem_mb> <cpu_sec>")
+// Out: int (exit code)
+int run_extractor_helper(int argc, char** argv) {
+    if (argc < 6) return 2;
+    const int sock   = std::atoi(argv[2]);
+    const int log_fd = std::atoi(argv[3]);
+    const rlim_t mem = static_cast<rlim_t>(std::strtoull(argv[4], nullptr, 10)) << 20;
+    const rlim_t cpu = static_cast<rlim_t>(std::strtoull(argv[5], nullptr, 10));
+    if (mem > 0) { struct rlimit rl{mem, mem}; ::setrlimit(RLIMIT_AS, &rl); }
+    if (cpu > 0) { struct rlimit rl{cpu, cpu}; ::setrlimit(RLIMIT_CPU, &rl); }
+    ::signal(SIGPIPE, SIG_IGN);
+    ::prctl(PR_SET_NAME, "fg-extractor");
+    if (!send_all(sock, &kMsgReady, 1)) return 1;
+
+    for (;;) {
+        char type = 0;
+        char cbuf[CMSG_SPACE(sizeof(int))] = {};
+        struct iovec iov{&type, 1};
+        struct msghdr mh{};
+        mh.msg_iov        = &iov;
+        mh.msg_iovlen     = 1;
+        mh.msg_control    = cbuf;
+        mh.msg_controllen = sizeof(cbuf);
+        const ssize_t r = ::recvmsg(sock, &mh, MSG_CMSG_CLOEXEC);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0; // pool closed the socket: retire
+        int mfd = -1;
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+            if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS) std::memcpy(&mfd, CMSG_DATA(cm), sizeof(int));
+        }
+        if (type != kMsgJob) { // a cancel that arrived after its job ended
+            if (mfd >= 0) ::close(mfd);
+            continue;
+        }
+        JobHeader hdr{};
+        if (mfd < 0 || !recv_all(sock, &hdr, sizeof(hdr))) return 1;
+
+        void* map = nullptr;
+        if (hdr.size > 0) {
+            map = ::mmap(nullptr, hdr.size, PROT_READ, MAP_PRIVATE, mfd, 0);
+            if (map == MAP_FAILED) map = nullptr;
+        }
+        const std::string_view doc(static_cast<const char*>(map), map ? hdr.size : 0);
+
+        std::mutex out_mu;
+        bool cancelled = false, broken = false;
+        // one frame per part; a pending cancel byte stops the job
+        auto emit = [&](std::string_view part) {
+            std::lock_guard<std::mutex> lk(out_mu);
+            if (cancelled || broken) return false;
+            char c = 0;
+            if (::recv(sock, &c, 1, MSG_DONTWAIT) == 1) { cancelled = true; return false; }
+            const uint32_t len = static_cast<uint32_t>(std::min<size_t>(part.size(), kMaxFrame));
+            if (!send_all(sock, &len, sizeof(len)) || !send_all(sock, part.data(), len)) {
+                broken = true;
+                return false;
+            }
+            return true;
+        };
+        int32_t result = -1;
+        if (!doc.empty() && static_cast<FileKind>(hdr.kind) == FileKind::Pdf) {
+            PdfLimits lim;
+            lim.threads            = hdr.pdf_threads;
+            lim.max_pages          = hdr.pdf_max_pages;
+            lim.parallel_min_pages = hdr.pdf_parallel_min_pages;
+            lim.time_budget_ms     = hdr.pdf_time_budget_ms;
+            result = ContentParser::extract_pdf_pages(doc, log_fd, lim,
+                                                      [&](int, std::string_view page) { return emit(page); });
+        } else if (!doc.empty()) {
+            bool cut = false;
+            result = ContentParser::extract_office_parts(doc, log_fd, emit, &cut) ? (cut ? kResultLimited : 0) : -1;
+        }
+        if (map) ::munmap(map, hdr.size);
+        ::close(mfd);
+        if (broken) return 1;
+        const uint32_t end = kEndFrame;
+        if (!send_all(sock, &end, sizeof(end)) || !send_all(sock, &result, sizeof(result))) return 1;
+    }
+}
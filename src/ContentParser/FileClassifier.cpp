@@ -0,0 +1,209 @@
+// === src/ContentParser/FileClassifier.cpp ===
+#include "FileClassifier.hpp"
+#include <cmath>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std::literals;
+
+// One signature: 'magic' at 'off', and optionally 'magic2' at 'off2' (RIFF/ftyp subtypes).
+struct Magic {
+    size_t           off;
+    std::string_view magic;
+    size_t           off2;
+    std::string_view magic2;
+    FileKind         kind;
+};
+
+// First match wins: more specific entries come before the generic ones they share a prefix with.
+static const Magic kMagics[] = {
+    {0,   "%PDF-"sv,                         0, ""sv,           FileKind::Pdf},
+    {0,   "PK\x03\x04"sv,                    0, ""sv,           FileKind::Zip},
+    {0,   "PK\x05\x06"sv,                    0, ""sv,           FileKind::Zip},
+    {0,   "\x1f\x8b"sv,                      0, ""sv,           FileKind::Gzip},
+    {0,   "\x28\xb5\x2f\xfd"sv,              0, ""sv,           FileKind::Zstd},
+    {0,   "\xfd" "7zXZ\x00"sv,               0, ""sv,           FileKind::Xz},
+    {0,   "BZh"sv,                           0, ""sv,           FileKind::Bzip2},
+    {0,   "7z\xbc\xaf\x27\x1c"sv,            0, ""sv,           FileKind::SevenZip},
+    {257, "ustar"sv,                         0, ""sv,           FileKind::Tar},
+    {0,   "\x7f" "ELF"sv,                    0, ""sv,           FileKind::Elf},
+    {0,   "\xfe\xed\xfa\xce"sv,              0, ""sv,           FileKind::MachO},
+    {0,   "\xfe\xed\xfa\xcf"sv,              0, ""sv,           FileKind::MachO},
+    {0,   "\xce\xfa\xed\xfe"sv,              0, ""sv,           FileKind::MachO},
+    {0,   "\xcf\xfa\xed\xfe"sv,              0, ""sv,           FileKind::MachO},
+    {0,   "\x00" "asm"sv,                    0, ""sv,           FileKind::Wasm},
+    {0,   "\x89PNG\r\n\x1a\n"sv,             0, ""sv,           FileKind::Image},
+    {0,   "\xff\xd8\xff"sv,                  0, ""sv,           FileKind::Image},
+    {0,   "GIF87a"sv,                        0, ""sv,           FileKind::Image},
+    {0,   "GIF89a"sv,                        0, ""sv,           FileKind::Image},
+    {0,   "II*\x00"sv,                       0, ""sv,           FileKind::Image},
+    {0,   "MM\x00*"sv,                       0, ""sv,           FileKind::Image},
+    {0,   "8BPS"sv,                          0, ""sv,           FileKind::Image},
+    {0,   "\x00\x00\x01\x00"sv,              0, ""sv,           FileKind::Image},   // .ico
+    {0,   "BM"sv,                            6, "\x00\x00\x00\x00"sv, FileKind::Image},
+    {0,   "RIFF"sv,                          8, "WEBP"sv,       FileKind::Image},
+    {0,   "RIFF"sv,                          8, "WAVE"sv,       FileKind::Audio},
+    {0,   "RIFF"sv,                          8, "AVI "sv,       FileKind::Video},
+    {4,   "ftyp"sv,                          8, "heic"sv,       FileKind::Image},
+    {4,   "ftyp"sv,                          8, "heix"sv,       FileKind::Image},
+    {4,   "ftyp"sv,                          8, "mif1"sv,       FileKind::Image},
+    {4,   "ftyp"sv,                          8, "avif"sv,       FileKind::Image},
+    {4,   "ftyp"sv,                          8, "M4A "sv,       FileKind::Audio},
+    {4,   "ftyp"sv,                          0, ""sv,           FileKind::Video},   // mp4/mov/3gp
+    {0,   "ID3"sv,                           0, ""sv,           FileKind::Audio},
+    {0,   "\xff\xfb"sv,                      0, ""sv,           FileKind::Audio},
+    {0,   "\xff\xf3"sv,                      0, ""sv,           FileKind::Audio},
+    {0,   "fLaC"sv,                          0, ""sv,           FileKind::Audio},
+    {0,   "OggS"sv,                          0, ""sv,           FileKind::Audio},
+    {0,   "FORM"sv,                          8, "AIFF"sv,       FileKind::Audio},
+    {0,   "\x1a\x45\xdf\xa3"sv,              0, ""sv,           FileKind::Video},   // mkv/webm
+    {0,   "\x00\x00\x01\xba"sv,              0, ""sv,           FileKind::Video},
+    {0,   "\x00\x00\x01\xb3"sv,              0, ""sv,           FileKind::Video},
+    {0,   "FLV\x01"sv,                       0, ""sv,           FileKind::Video},
+    {0,   "wOFF"sv,                          0, ""sv,           FileKind::Font},
+    {0,   "wOF2"sv,                          0, ""sv,           FileKind::Font},
+    {0,   "OTTO"sv,                          0, ""sv,           FileKind::Font},
+    {0,   "\x00\x01\x00\x00\x00"sv,          0, ""sv,           FileKind::Font},
+    {0,   "SQLite format 3\x00"sv,           0, ""sv,           FileKind::Sqlite},
+};
+
+static const char* const kNames[kFileKindCount] = {
+    "text", "pdf", "docx", "zip", "gzip", "zstd", "xz", "bzip2", "7z", "tar",
+    "elf", "pe", "macho", "java", "wasm",
+    "image", "audio", "video", "font", "sqlite",
+    "binary", "random",
+};
+
+// Desc: true if 'head' holds 'm' at offset 'off'
+// In: std::string_view head, size_t off, std::string_view m
+// Out: bool
+static inline bool has_at(std::string_view head, size_t off, std::string_view m) {
+    return head.size() >= off + m.size() && std::memcmp(head.data() + off, m.data(), m.size()) == 0;
+}
+
+// Desc: a ZIP whose first entry is an OOXML/ODF marker is an office document
+// In: std::string_view head (starts with a local file header)
+// Out: bool
+static bool zip_is_office(std::string_view head) {
+    if (head.size() < 30) return false;
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(head.data());
+    const size_t name_len = static_cast<size_t>(b[26] | (b[27] << 8));
+    if (head.size() < 30 + name_len) return false;
+    const std::string_view name(head.data() + 30, name_len);
+    return name == "[Content_Types].xml"sv || name == "mimetype"sv ||
+           name.rfind("_rels/", 0) == 0 || name.rfind("docProps/", 0) == 0 ||
+           name.rfind("word/", 0) == 0 || name.rfind("xl/", 0) == 0 || name.rfind("ppt/", 0) == 0;
+}
+
+// Desc: count NUL bytes and control bytes that do not occur in text (all but \t \n \v \f \r ESC)
+// In: const unsigned char* p, size_t n, size_t& nul
+// Out: size_t (control bytes, NUL included)
+static size_t count_control(const unsigned char* p, size_t n, size_t& nul) {
+    size_t ctrl = 0, i = 0;
+    nul = 0;
+#ifdef __SSE2__
+    const __m128i k1f = _mm_set1_epi8(0x1f);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tab = _mm_set1_epi8('\t'), lf = _mm_set1_epi8('\n'), vt = _mm_set1_epi8('\v');
+    const __m128i ff = _mm_set1_epi8('\f'), cr = _mm_set1_epi8('\r'), esc = _mm_set1_epi8(0x1b);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i low = _mm_cmpeq_epi8(_mm_min_epu8(v, k1f), v);           // v <= 0x1f
+        __m128i ok = _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, lf));
+        ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, vt), _mm_cmpeq_epi8(v, ff)));
+        ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, esc)));
+        ctrl += static_cast<size_t>(__builtin_popcount(_mm_movemask_epi8(_mm_andnot_si128(ok, low))));
+        nul  += static_cast<size_t>(__builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))));
+    }
+#endif
+    for (; i < n; ++i) {
+        const unsigned char c = p[i];
+        if (c == 0) ++nul;
+        if (c <= 0x1f && c != '\t' && c != '\n' && c != '\v' && c != '\f' && c != '\r' && c != 0x1b) ++ctrl;
+    }
+    return ctrl;
+}
+
+// Desc: Shannon entropy of the byte distribution
+// In: const unsigned char* p, size_t n
+// Out: double (bits per byte, 0..8)
+static double byte_entropy(const unsigned char* p, size_t n) {
+    if (n == 0) return 0.0;
+    uint32_t hist[256] = {0};
+    for (size_t i = 0; i < n; ++i) ++hist[p[i]];
+    double h = 0.0;
+    const double inv = 1.0 / static_cast<double>(n);
+    for (uint32_t c : hist) {
+        if (!c) continue;
+        const double q = c * inv;
+        h -= q * std::log2(q);
+    }
+    return h;
+}
+
+// Desc: classify a file from its first bytes (see header)
+// In: std::string_view head (up to kHeadBytes are inspected)
+// Out: FileClass
+FileClass FileClassifier::classify(std::string_view head) {
+    FileClass fc;
+    if (head.size() > kHeadBytes) head = head.substr(0, kHeadBytes);
+    if (head.empty()) return fc;
+
+    for (const Magic& m : kMagics) {
+        if (!has_at(head, m.off, m.magic)) continue;
+        if (!m.magic2.empty() && !has_at(head, m.off2, m.magic2)) continue;
+        fc.kind = m.kind;
+        if (fc.kind == FileKind::Zip && zip_is_office(head)) fc.kind = FileKind::Office;
+        return fc;
+    }
+    // DOS stub: a PE image if e_lfanew points at "PE\0\0"
+    if (has_at(head, 0, "MZ"sv) && head.size() >= 0x40) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(head.data());
+        const size_t pe = static_cast<size_t>(b[0x3c] | (b[0x3d] << 8) | (b[0x3e] << 16)) | (static_cast<size_t>(b[0x3f]) << 24);
+        if (has_at(head, pe, "PE\x00\x00"sv)) {
+            fc.kind = FileKind::Pe;
+            return fc;
+        }
+    }
+    // 0xCAFEBABE: Java class (major version >= 45) or a fat Mach-O (small arch count)
+    if (has_at(head, 0, "\xca\xfe\xba\xbe"sv) && head.size() >= 8) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(head.data());
+        fc.kind = ((b[6] << 8) | b[7]) >= 45 ? FileKind::JavaClass : FileKind::MachO;
+        return fc;
+    }
+    // UTF-8/16/32 byte-order marks
+    if (has_at(head, 0, "\xef\xbb\xbf"sv) || has_at(head, 0, "\xff\xfe"sv) || has_at(head, 0, "\xfe\xff"sv)) {
+        return fc;
+    }
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(head.data());
+    size_t nul = 0;
+    const size_t ctrl = count_control(p, head.size(), nul);
+    // text: no NUL and at most ~1% stray control bytes
+    if (nul == 0 && ctrl * 100 <= head.size()) return fc;
+
+    fc.entropy = byte_entropy(p, head.size());
+    // a short head cannot show high entropy; only call it random with enough bytes
+    fc.kind = (head.size() >= 512 && fc.entropy >= 7.2) ? FileKind::Random : FileKind::Binary;
+    return fc;
+}
+
+// Desc: config / pattern-scope name of a kind
+// In: FileKind k
+// Out: const char*
+const char* FileClassifier::name(FileKind k) {
+    const size_t i = static_cast<size_t>(k);
+    return i < kFileKindCount ? kNames[i] : "binary";
+}
+
+// Desc: parse a kind name
+// In: const std::string& name, FileKind& out
+// Out: bool (false if unknown)
+bool FileClassifier::fromName(const std::string& name, FileKind& out) {
+    for (size_t i = 0; i < kFileKindCount; ++i) {
+        if (name == kNames[i]) { out = static_cast<FileKind>(i); return true; }
+    }
+    return false;
+}
@@ -0,0 +1,275 @@
+// === src/ContentParser/OfficeExtractor.cpp ===
+#include "OfficeExtractor.hpp"
+#include "ZipReader.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+// One text part found in the central directory.
+struct ZipPart {
+    ZipEntry entry;
+    int      rank{0};     // document order: document, sharedStrings, slides, content.xml
+    uint64_t seq{0};      // slide number
+};
+
+// Streaming XML-to-text: drops markup, decodes entities and turns paragraph, cell and
+// line ends into separators so words from different paragraphs never run together.
+class XmlText {
+public:
+    explicit XmlText(std::string& out) : out_(out) {}
+    void feed(const char* p, size_t n);
+
+private:
+    void endTag();
+    void endEntity();
+
+    std::string& out_;
+    enum class State { Text, Tag, Entity } st_ = State::Text;
+    std::string tag_;   // leading bytes of the current tag (enough for its name)
+    std::string ent_;
+};
+
+// Desc: consume the next chunk of XML (state carries over between chunks)
+// In: const char* p, size_t n
+// Out: void
+void XmlText::feed(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        if (st_ == State::Text) {
+            size_t j = i;
+            while (j < n && p[j] != '<' && p[j] != '&') ++j;
+            out_.append(p + i, j - i);
+            if (j == n) return;
+            if (p[j] == '<') { st_ = State::Tag; tag_.clear(); }
+            else             { st_ = State::Entity; ent_.clear(); }
+            i = j + 1;
+        } else if (st_ == State::Tag) {
+            const char c = p[i++];
+            if (c == '>') { endTag(); st_ = State::Text; }
+            else if (tag_.size() < 40) tag_ += c;
+        } else {
+            const char c = p[i++];
+            if (c == ';') { endEntity(); st_ = State::Text; }
+            else if (ent_.size() < 12) ent_ += c;
+            else { out_ += '&'; out_ += ent_; out_ += c; st_ = State::Text; }
+        }
+    }
+}
+
+// Desc: emit the separator a finished tag stands for (paragraph, cell, tab, line break)
+// In: (none)
+// Out: void
+void XmlText::endTag() {
+    if (tag_.empty() || tag_[0] == '?' || tag_[0] == '!') return;
+    const bool closing = tag_[0] == '/';
+    size_t b = closing ? 1 : 0;
+    size_t e = tag_.find_first_of(" \t\r\n/", b);
+    if (e == std::string::npos) e = tag_.size();
+    std::string name = tag_.substr(b, e - b);
+    const size_t colon = name.find(':');
+    if (colon != std::string::npos) name.erase(0, colon + 1);
+
+    if (closing) {
+        if (name == "p" || name == "h" || name == "si") out_ += '\n';
+        else if (name == "tc" || name == "table-cell") out_ += '\t';
+        return;
+    }
+    if (name == "tab") out_ += '\t';
+    else if (name == "br" || name == "cr" || name == "line-break") out_ += '\n';
+    else if (name == "s") out_ += ' ';
+}
+
+// Desc: append a code point as UTF-8
+// In: std::string& out, uint32_t cp
+// Out: void
+static void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x110000) {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Desc: decode the finished entity (&amp; &#65; &#x41; ...); unknown ones are kept verbatim
+// In: (none)
+// Out: void
+void XmlText::endEntity() {
+    if (ent_ == "amp")  { out_ += '&';  return; }
+    if (ent_ == "lt")   { out_ += '<';  return; }
+    if (ent_ == "gt")   { out_ += '>';  return; }
+    if (ent_ == "quot") { out_ += '"';  return; }
+    if (ent_ == "apos") { out_ += '\''; return; }
+    if (ent_.size() > 1 && ent_[0] == '#') {
+        const bool hex = ent_[1] == 'x' || ent_[1] == 'X';
+        const char* s = ent_.c_str() + (hex ? 2 : 1);
+        char* end = nullptr;
+        const unsigned long cp = std::strtoul(s, &end, hex ? 16 : 10);
+        if (end && *end == '\0' && end != s) { append_utf8(out_, static_cast<uint32_t>(cp)); return; }
+    }
+    out_ += '&';
+    out_ += ent_;
+    out_ += ';';
+}
+
+// Desc: document order of a text part
+// In: const std::string& name, uint64_t& seq (slide number)
+// Out: int (-1 = not a text part)
+static int part_rank(const std::string& name, uint64_t& seq) {
+    seq = 0;
+    if (name == "word/document.xml")    return 0;
+    if (name == "xl/sharedStrings.xml") return 1;
+    if (name == "content.xml")          return 3;
+    static const std::string kSlide = "ppt/slides/slide";
+    if (name.size() > kSlide.size() + 4 && name.size() <= kSlide.size() + 4 + 9 &&
+        name.compare(0, kSlide.size(), kSlide) == 0 &&
+        name.compare(name.size() - 4, 4, ".xml") == 0) {
+        for (size_t i = kSlide.size(); i < name.size() - 4; ++i) {
+            if (name[i] < '0' || name[i] > '9') return -1;
+            seq = seq * 10 + static_cast<uint64_t>(name[i] - '0');
+        }
+        return 2;
+    }
+    return -1;
+}
+
+// Desc: collect the text parts listed in the central directory, in document order
+// In: std::string_view zip, std::vector<ZipPart>& parts, std::string* error
+// Out: bool (false if the directory is corrupt)
+static bool list_parts(std::string_view zip, std::vector<ZipPart>& parts, std::string* error) {
+    std::vector<ZipEntry> entries;
+    if (!ZipReader::list(zip, entries, error)) return false;
+    for (ZipEntry& e : entries) {
+        ZipPart part;
+        part.rank = part_rank(e.name, part.seq);
+        if (part.rank < 0 || e.encrypted) continue; // encrypted entries cannot be read
+        part.entry = std::move(e);
+        parts.push_back(std::move(part));
+    }
+    std::stable_sort(parts.begin(), parts.end(), [](const ZipPart& a, const ZipPart& c) {
+        return a.rank != c.rank ? a.rank < c.rank : a.seq < c.seq;
+    });
+    return true;
+}
+
+// Desc: inflate (or copy) one part's bytes through the XML stripper; past the size limit
+//       the rest of the part is dropped and 'limited' is set (the text so far is kept)
+// In: const unsigned char* data, const ZipEntry& part, size_t& budget (inflated bytes left), XmlText& xml,
+//     bool& limited, std::string* error
+// Out: bool (false if nothing usable came out)
+static bool inflate_part(const unsigned char* data, const ZipEntry& part, size_t& budget,
+                         XmlText& xml, bool& limited, std::string* error) {
+    const size_t limit = std::min(budget, OfficeExtractor::kMaxPartBytes);
+    if (part.method == 0) {
+        size_t n = static_cast<size_t>(part.comp_size);
+        if (part.comp_size > limit) {
+            if (error) *error = "part exceeds size limit: " + part.name;
+            limited = true;
+            n = limit;
+        }
+        xml.feed(reinterpret_cast<const char*>(data), n);
+        budget -= n;
+        return true;
+    }
+    if (part.method != 8) {
+        if (error) *error = "unsupported compression method in " + part.name;
+        return false;
+    }
+
+    z_stream zs{};
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        if (error) *error = "inflateInit2 failed";
+        return false;
+    }
+    std::vector<char> out(64 * 1024);
+    uint64_t in_left = part.comp_size;
+    const unsigned char* in = data;
+    size_t produced = 0;
+    int rc = Z_OK;
+    bool ok = true;
+    while (rc != Z_STREAM_END) {
+        if (zs.avail_in == 0 && in_left > 0) {
+            const uInt chunk = static_cast<uInt>(std::min<uint64_t>(in_left, 1u << 30));
+            zs.next_in  = const_cast<Bytef*>(in);
+            zs.avail_in = chunk;
+            in      += chunk;
+            in_left -= chunk;
+        }
+        zs.next_out  = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = static_cast<uInt>(out.size());
+        rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END) {
+            if (error) *error = "inflate failed in " + part.name;
+            ok = false;
+            break;
+        }
+        const size_t n = out.size() - zs.avail_out;
+        if (produced + n > limit) {
+            // keep the text up to the limit: what was stripped so far is still matched
+            if (error) *error = "part exceeds size limit: " + part.name;
+            limited = true;
+            xml.feed(out.data(), limit - produced);
+            produced = limit;
+            break;
+        }
+        produced += n;
+        xml.feed(out.data(), n);
+        if (n == 0 && zs.avail_in == 0 && in_left == 0 && rc != Z_STREAM_END) {
+            if (error) *error = "truncated deflate data in " + part.name;
+            ok = false;
+            break;
+        }
+    }
+    inflateEnd(&zs);
+    budget -= std::min(budget, produced);
+    return ok;
+}
+
+// Desc: extract the text parts of an in-memory OOXML/ODF document (see header)
+// In: std::string_view zip, on_part, std::string* error, bool* limited
+// Out: bool
+bool OfficeExtractor::extract(std::string_view zip,
+                              const std::function<bool(std::string_view)>& on_part,
+                              std::string* error, bool* limited) {
+    std::vector<ZipPart> parts;
+    if (!list_parts(zip, parts, error)) return false;
+    if (parts.empty()) {
+        if (error) *error = "no document text parts";
+        return false;
+    }
+
+    size_t budget = kMaxTotalBytes;
+    bool delivered = false, cut = false;
+    std::string text;
+    for (const ZipPart& part : parts) {
+        if (budget == 0) {
+            // the document budget is spent: the remaining parts are never inflated
+            if (error) *error = "document exceeds size limit";
+            cut = true;
+            break;
+        }
+        std::string_view data;
+        if (!ZipReader::data(zip, part.entry, data, error)) continue;
+        text.clear();
+        XmlText xml(text);
+        if (!inflate_part(reinterpret_cast<const unsigned char*>(data.data()), part.entry, budget, xml, cut, error)) {
+            continue;
+        }
+        delivered = true;
+        if (!on_part(text)) break;
+    }
+    if (limited) *limited = cut;
+    return delivered;
+}
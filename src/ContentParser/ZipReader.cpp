@@ -0,0 +1,214 @@
+// === src/ContentParser/ZipReader.cpp ===
+#include "ZipReader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+
+static const uint32_t kSigEocd      = 0x06054b50;
+static const uint32_t kSigEocd64    = 0x06064b50;
+static const uint32_t kSigEocd64Loc = 0x07064b50;
+static const uint32_t kSigCentral   = 0x02014b50;
+static const uint32_t kSigLocal     = 0x04034b50;
+
+static inline uint16_t rd16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static inline uint32_t rd32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+static inline uint64_t rd64(const unsigned char* p) { return static_cast<uint64_t>(rd32(p)) | (static_cast<uint64_t>(rd32(p + 4)) << 32); }
+
+// Desc: find the end-of-central-directory record in the last bytes of a file
+// In: const unsigned char* b, size_t len
+// Out: size_t (offset in b, len if there is none)
+static size_t find_eocd(const unsigned char* b, size_t len) {
+    if (len < 22) return len;
+    const size_t lo = len > 22 + 0xFFFF ? len - 22 - 0xFFFF : 0;
+    for (size_t i = len - 22 + 1; i-- > lo;) {
+        if (rd32(b + i) == kSigEocd) return i;
+    }
+    return len;
+}
+
+// Desc: directory location from the classic record at b + eocd; for ZIP64 archives z is
+//       set to the file offset of the ZIP64 record (read with read_eocd64)
+// In: const unsigned char* b, size_t eocd, uint64_t& cd_off, uint64_t& cd_size, uint64_t& count, uint64_t& z
+// Out: bool (false if a ZIP64 archive has no locator)
+static bool read_eocd(const unsigned char* b, size_t eocd, uint64_t& cd_off, uint64_t& cd_size,
+                      uint64_t& count, uint64_t& z) {
+    count   = rd16(b + eocd + 10);
+    cd_size = rd32(b + eocd + 12);
+    cd_off  = rd32(b + eocd + 16);
+    z = UINT64_MAX;
+    if (count == 0xFFFF || cd_size == 0xFFFFFFFFu || cd_off == 0xFFFFFFFFu) {
+        // ZIP64: the locator sits right before the classic record
+        if (eocd < 20 || rd32(b + eocd - 20) != kSigEocd64Loc) return false;
+        z = rd64(b + eocd - 20 + 8);
+    }
+    return true;
+}
+
+// Desc: directory location from a ZIP64 end-of-central-directory record (56 bytes)
+// In: const unsigned char* r, uint64_t& cd_off, uint64_t& cd_size, uint64_t& count
+// Out: bool
+static bool read_eocd64(const unsigned char* r, uint64_t& cd_off, uint64_t& cd_size, uint64_t& count) {
+    if (rd32(r) != kSigEocd64) return false;
+    count   = rd64(r + 32);
+    cd_size = rd64(r + 40);
+    cd_off  = rd64(r + 48);
+    return true;
+}
+
+// Desc: parse cd_size bytes of central directory holding count entries
+// In: const unsigned char* p, uint64_t cd_size, uint64_t count, std::vector<ZipEntry>& out, std::string* error
+// Out: bool
+static bool parse_central_dir(const unsigned char* p, uint64_t cd_size, uint64_t count,
+                              std::vector<ZipEntry>& out, std::string* error) {
+    const unsigned char* end = p + cd_size;
+    for (uint64_t k = 0; k < count; ++k) {
+        if (end - p < 46 || rd32(p) != kSigCentral) {
+            if (error) *error = "corrupt ZIP central directory";
+            return false;
+        }
+        const uint16_t flags = rd16(p + 8);
+        const uint16_t nlen  = rd16(p + 28);
+        const uint16_t xlen  = rd16(p + 30);
+        const uint16_t clen  = rd16(p + 32);
+        if (end - p < 46 + nlen + xlen + clen) {
+            if (error) *error = "corrupt ZIP central directory";
+            return false;
+        }
+        ZipEntry e;
+        e.name.assign(reinterpret_cast<const char*>(p + 46), nlen);
+        e.encrypted = (flags & 1) != 0;
+        e.method    = rd16(p + 10);
+        e.comp_size = rd32(p + 20);
+        e.size      = rd32(p + 24);
+        e.local_off = rd32(p + 42);
+        // ZIP64 extra field (id 1): only the saturated values are present, in this order
+        const unsigned char* x  = p + 46 + nlen;
+        const unsigned char* xe = x + xlen;
+        while (xe - x >= 4) {
+            const uint16_t id = rd16(x), sz = rd16(x + 2);
+            if (static_cast<size_t>(xe - x - 4) < sz) break;
+            if (id == 1) {
+                const unsigned char* v = x + 4;
+                const unsigned char* ve = v + sz;
+                if (e.size == 0xFFFFFFFFu && ve - v >= 8)      { e.size = rd64(v); v += 8; }
+                if (e.comp_size == 0xFFFFFFFFu && ve - v >= 8) { e.comp_size = rd64(v); v += 8; }
+                if (e.local_off == 0xFFFFFFFFu && ve - v >= 8) { e.local_off = rd64(v); }
+            }
+            x += 4 + sz;
+        }
+        out.push_back(std::move(e));
+        p += 46 + nlen + xlen + clen;
+    }
+    return true;
+}
+
+// Desc: list the central directory entries (see header)
+// In: std::string_view zip, std::vector<ZipEntry>& out, std::string* error
+// Out: bool (false if the directory is missing or corrupt)
+bool ZipReader::list(std::string_view zip, std::vector<ZipEntry>& out, std::string* error) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(zip.data());
+    const size_t len = zip.size();
+    uint64_t cd_off = 0, cd_size = 0, count = 0, z = UINT64_MAX;
+    const size_t eocd = find_eocd(b, len);
+    bool ok = eocd < len && read_eocd(b, eocd, cd_off, cd_size, count, z);
+    if (ok && z != UINT64_MAX) ok = len >= 56 && z <= len - 56 && read_eocd64(b + z, cd_off, cd_size, count);
+    if (!ok || cd_off > len || cd_size > len - cd_off) {
+        if (error) *error = "no ZIP central directory";
+        return false;
+    }
+    return parse_central_dir(b + cd_off, cd_size, count, out, error);
+}
+
+// Desc: pread exactly n bytes at off
+// In: int fd, void* dst, size_t n, uint64_t off
+// Out: bool (false on error or end of file)
+static bool pread_full(int fd, void* dst, size_t n, uint64_t off) {
+    char* p = static_cast<char*>(dst);
+    while (n > 0) {
+        const ssize_t r = ::pread(fd, p, n, static_cast<off_t>(off));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= static_cast<size_t>(r);
+        off += static_cast<uint64_t>(r);
+    }
+    return true;
+}
+
+// Desc: list the central directory of a zip file with pread (see header)
+// In: int fd, uint64_t fsz, uint64_t max_dir_bytes, std::vector<ZipEntry>& out, std::string* error
+// Out: bool
+bool ZipReader::list(int fd, uint64_t fsz, uint64_t max_dir_bytes, std::vector<ZipEntry>& out,
+                     std::string* error) {
+    // the classic record is in the last 22 + 64 KB (comment), its ZIP64 locator just before
+    const size_t tail = static_cast<size_t>(std::min<uint64_t>(fsz, 22 + 0xFFFF + 20));
+    const uint64_t base = fsz - tail;
+    std::vector<unsigned char> t(tail);
+    if (!pread_full(fd, t.data(), tail, base)) {
+        if (error) *error = "cannot read ZIP directory";
+        return false;
+    }
+    uint64_t cd_off = 0, cd_size = 0, count = 0, z = UINT64_MAX;
+    const size_t eocd = find_eocd(t.data(), tail);
+    bool ok = eocd < tail && read_eocd(t.data(), eocd, cd_off, cd_size, count, z);
+    if (ok && z != UINT64_MAX) {
+        unsigned char r[56];
+        ok = fsz >= 56 && z <= fsz - 56 && pread_full(fd, r, sizeof(r), z) && read_eocd64(r, cd_off, cd_size, count);
+    }
+    if (!ok || cd_off > fsz || cd_size > fsz - cd_off) {
+        if (error) *error = "no ZIP central directory";
+        return false;
+    }
+    if (cd_size > max_dir_bytes) {
+        if (error) *error = "ZIP central directory too large";
+        return false;
+    }
+    std::vector<unsigned char> cd(static_cast<size_t>(cd_size));
+    if (!pread_full(fd, cd.data(), cd.size(), cd_off)) {
+        if (error) *error = "cannot read ZIP directory";
+        return false;
+    }
+    return parse_central_dir(cd.data(), cd_size, count, out, error);
+}
+
+// Desc: bounds-checked view of an entry's compressed bytes
+// In: std::string_view zip, const ZipEntry& e, std::string_view& out, std::string* error
+// Out: bool
+bool ZipReader::data(std::string_view zip, const ZipEntry& e, std::string_view& out, std::string* error) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(zip.data());
+    const size_t len = zip.size();
+    const uint64_t lo = e.local_off;
+    if (lo > len || len - lo < 30 || rd32(b + lo) != kSigLocal) {
+        if (error) *error = "bad local header: " + e.name;
+        return false;
+    }
+    const uint64_t data_off = lo + 30 + rd16(b + lo + 26) + rd16(b + lo + 28);
+    if (data_off > len || e.comp_size > len - data_off) {
+        if (error) *error = "truncated entry: " + e.name;
+        return false;
+    }
+    out = zip.substr(static_cast<size_t>(data_off), static_cast<size_t>(e.comp_size));
+    return true;
+}
+
+// Desc: file offset of an entry's compressed bytes, read from its local header with pread
+// In: int fd, uint64_t fsz, const ZipEntry& e, uint64_t& off, std::string* error
+// Out: bool
+bool ZipReader::data(int fd, uint64_t fsz, const ZipEntry& e, uint64_t& off, std::string* error) {
+    unsigned char h[30];
+    if (e.local_off > fsz || fsz - e.local_off < 30 || !pread_full(fd, h, sizeof(h), e.local_off) ||
+        rd32(h) != kSigLocal) {
+        if (error) *error = "bad local header: " + e.name;
+        return false;
+    }
+    off = e.local_off + 30 + rd16(h + 26) + rd16(h + 28);
+    if (off > fsz || e.comp_size > fsz - off) {
+        if (error) *error = "truncated entry: " + e.name;
+        return false;
+    }
+    return true;
+}
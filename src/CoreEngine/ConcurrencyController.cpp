@@ -0,0 +1,148 @@
+// === src/CoreEngine/ConcurrencyController.cpp ===
+#include "ConcurrencyController.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Desc: add the time since the last change to the busy/waiting integrals (m_ held)
+// In: (none)
+// Out: void
+void WorkerLimit::account_() {
+    const auto now = Clock::now();
+    const double dt = std::chrono::duration<double>(now - mark_).count();
+    busy_sec_ += dt * static_cast<double>(in_use_);
+    wait_sec_ += dt * static_cast<double>(waiting_);
+    mark_ = now;
+}
+
+// Desc: take a slot, waiting while all slots are in use
+// In: (none)
+// Out: void
+void WorkerLimit::acquire() {
+    std::unique_lock<std::mutex> lk(m_);
+    account_();
+    ++waiting_;
+    cv_.wait(lk, [&]{ return in_use_ < limit_; });
+    account_();
+    --waiting_;
+    ++in_use_;
+}
+
+// Desc: give a slot back
+// In: (none)
+// Out: void
+void WorkerLimit::release() {
+    std::lock_guard<std::mutex> lk(m_);
+    account_();
+    --in_use_;
+    cv_.notify_all();
+}
+
+// Desc: change the number of slots; callers in flight keep theirs
+// In: size_t limit
+// Out: void
+void WorkerLimit::set_limit(size_t limit) {
+    std::lock_guard<std::mutex> lk(m_);
+    limit_ = limit;
+    cv_.notify_all();
+}
+
+// Desc: current number of slots
+// In: (none)
+// Out: size_t
+size_t WorkerLimit::limit() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return limit_;
+}
+
+// Desc: block new acquires and wait until every slot is back
+// In: (none)
+// Out: void
+void WorkerLimit::drain() {
+    std::unique_lock<std::mutex> lk(m_);
+    limit_ = 0;
+    cv_.wait(lk, [&]{ return in_use_ == 0; });
+}
+
+// Desc: mean busy slots and waiting callers since the previous call
+// In: (none)
+// Out: WorkerLimit::Load
+WorkerLimit::Load WorkerLimit::take_load() {
+    std::lock_guard<std::mutex> lk(m_);
+    account_();
+    Load l;
+    const double window = std::chrono::duration<double>(mark_ - window_start_).count();
+    if (window > 0) {
+        l.busy    = busy_sec_ / window;
+        l.waiting = wait_sec_ / window;
+    }
+    busy_sec_     = 0;
+    wait_sec_     = 0;
+    window_start_ = mark_;
+    return l;
+}
+
+// Desc: "some avg10" of /proc/pressure/<resource>
+// In: const char* resource ("cpu", "io", "memory")
+// Out: double (percent, -1 if unavailable)
+double read_psi(const char* resource) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/pressure/%s", resource);
+    FILE* f = std::fopen(path, "r");
+    if (!f) return -1;
+    char line[256];
+    double avg10 = -1;
+    while (std::fgets(line, sizeof(line), f)) {
+        if (std::strncmp(line, "some ", 5) != 0) continue;
+        if (std::sscanf(line, "some avg10=%lf", &avg10) != 1) avg10 = -1;
+        break;
+    }
+    std::fclose(f);
+    return avg10;
+}
+
+ConcurrencyController::ConcurrencyController(const ConcurrencyOptions& opt, size_t sync_now, size_t async_now)
+    : opt_(opt) {
+    min_sync_  = std::max<size_t>(1, opt.min_sync);
+    max_sync_  = std::max<size_t>(min_sync_, opt.max_sync);
+    min_async_ = std::max<size_t>(1, opt.min_async);
+    max_async_ = std::max<size_t>(min_async_, opt.max_async);
+    sync_  = std::min(std::max(sync_now, min_sync_), max_sync_);
+    async_ = std::min(std::max(async_now, min_async_), max_async_);
+}
+
+// Desc: one control interval: new sizes of both pools (see header)
+// In: const Signals& s
+// Out: ConcurrencyController::Decision
+ConcurrencyController::Decision ConcurrencyController::step(const Signals& s) {
+    const bool pressure = (s.cpu_psi > static_cast<double>(opt_.cpu_psi_limit)) ||
+                          (s.io_psi  > static_cast<double>(opt_.io_psi_limit));
+    // multiplicative decrease: drop a quarter, at least one worker
+    auto cut = [](size_t n, size_t lo) { return std::max(lo, n - std::max<size_t>(1, n / 4)); };
+    Decision d{sync_, async_, "hold", "hold"};
+
+    const bool slow = s.latency_ms > static_cast<double>(opt_.target_latency_ms);
+    if (pressure) {
+        if (sync_ > min_sync_) { sync_ = cut(sync_, min_sync_); d.sync_reason = "pressure"; ++cuts_; }
+    } else if (s.sync_waiting >= 0.5 || (slow && s.sync_waiting > 0)) {
+        if (sync_ < max_sync_) { ++sync_; d.sync_reason = "grow"; ++grows_; }
+    } else if (!slow && s.sync_waiting < 0.05) {
+        // the mean number of busy workers is what the offered load needs; keep one spare
+        const size_t need = static_cast<size_t>(std::ceil(s.sync_busy)) + 1;
+        if (sync_ > std::max(need, min_sync_)) { --sync_; d.sync_reason = "idle"; }
+    }
+
+    if (pressure) {
+        if (async_ > min_async_) { async_ = cut(async_, min_async_); d.async_reason = "pressure"; ++cuts_; }
+    } else if (s.async_depth > async_) {
+        if (async_ < max_async_) { ++async_; d.async_reason = "grow"; ++grows_; }
+    } else if (s.async_depth == 0 && async_ > min_async_) {
+        --async_;
+        d.async_reason = "idle";
+    }
+
+    d.sync  = sync_;
+    d.async = async_;
+    return d;
+}
@@ -5,11 +5,19 @@
 #include "RuleEvaluator.hpp"
 #include "CacheL1.hpp"
 #include "CacheL2.hpp"
+#include "CacheShm.hpp"
+#include "MatcherRegistry.hpp"
+#include "requirements.hpp"
+#include "ContentHash.hpp"
+#include "ExtractorPool.hpp"
+#include "ByteBudget.hpp"
+#include "AppendIndex.hpp"
+#include "ChunkIndex.hpp"
 #include "StatisticStore.hpp"
 #include "AsyncScanQueue.hpp"
 #include "Warmup.hpp"
 #include "ContentParser.hpp"
-#include "SimpleSemaphore.hpp"
+#include "ConcurrencyController.hpp"
 
 #include <iostream>
 #include <fcntl.h>
@@ -28,12 +36,17 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <future>
+#include <algorithm>
+#include <memory>
+#include <vector>
 #include <math.h>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <sched.h>
 #include <errno.h>
 #include <string.h>
+#include <signal.h>
 
 #define BUF_SIZE 4096
 #define REPORT_PER_CYCLE 300
@@ -54,12 +67,234 @@ static std::atomic<uint64_t> hit_bytes{0};
 // L1 metrics
 static std::atomic<uint64_t> l1_hits{0};
 static std::atomic<uint64_t> l1_hit_bytes{0};
+// shared-memory tier metrics
+static std::atomic<uint64_t> shm_hits{0};
 
 
-// tune this based on CPU / IO
-unsigned int cores = std::thread::hardware_concurrency();
+// default bounds of the adaptive pools (config "concurrency")
+unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
 unsigned int max_concurrency = std::max(cores * 2, 8u);
-static SimpleSemaphore g_worker_slots(1);
+// sync miss workers; resized by the concurrency controller when it is enabled
+static WorkerLimit g_worker_slots(1);
+
+// set by SIGINT/SIGTERM; main loop drains and persists L2 before returning
+static std::atomic<bool> g_stop{false};
+// set by SIGHUP; the reload thread recompiles patterns from the config file
+static std::atomic<bool> g_reload{false};
+
+// Desc: async-signal-safe stop request handler
+// In: int sig
+// Out: void
+static void on_stop_signal(int) {
+    g_stop.store(true, std::memory_order_relaxed);
+}
+
+// Desc: async-signal-safe pattern reload request handler
+// In: int sig
+// Out: void
+static void on_reload_signal(int) {
+    g_reload.store(true, std::memory_order_relaxed);
+}
+
+// Desc: install SIGINT/SIGTERM stop and SIGHUP reload handlers (no SA_RESTART so blocking calls wake up)
+// In: (none)
+// Out: void
+static void install_stop_handlers() {
+    struct sigaction sa{};
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGINT,  &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    struct sigaction hup{};
+    hup.sa_handler = on_reload_signal;
+    sigemptyset(&hup.sa_mask);
+    hup.sa_flags = 0;
+    sigaction(SIGHUP, &hup, nullptr);
+}
+
+// Desc: periodically write the L2 snapshot until stop is requested
+// In: const CacheL2& l2, std::string path, const std::atomic<uint64_t>& ruleset, uint64_t interval_sec
+// Out: void
+static void l2_snapshot_loop(const CacheL2& l2, std::string path, const std::atomic<uint64_t>& ruleset,
+                             uint64_t interval_sec) {
+    uint64_t elapsed = 0;
+    while (!g_stop.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (++elapsed < interval_sec) continue;
+        elapsed = 0;
+        l2.save_snapshot(path, ruleset.load(std::memory_order_acquire));
+    }
+}
+
+// Desc: resize the sync miss pool and the async workers every interval from queue depth,
+//       decision latency and CPU/I/O pressure until stop is requested
+// In: ConcurrencyController& ctl, uint64_t interval_ms
+// Out: void
+static void concurrency_loop(ConcurrencyController& ctl, uint64_t interval_ms) {
+    uint64_t last_decisions = decisions.load(std::memory_order_relaxed);
+    uint64_t last_us = total_us.load(std::memory_order_relaxed);
+    g_worker_slots.take_load();
+    while (!g_stop.load(std::memory_order_relaxed)) {
+        // short sleeps so a stop is noticed quickly
+        for (uint64_t slept = 0; slept < interval_ms && !g_stop.load(std::memory_order_relaxed); slept += 100) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint64_t>(100, interval_ms - slept)));
+        }
+        if (g_stop.load(std::memory_order_relaxed)) break;
+
+        ConcurrencyController::Signals s;
+        const WorkerLimit::Load load = g_worker_slots.take_load();
+        s.sync_busy    = load.busy;
+        s.sync_waiting = load.waiting;
+        const uint64_t d  = decisions.load(std::memory_order_relaxed);
+        const uint64_t us = total_us.load(std::memory_order_relaxed);
+        if (d > last_decisions) s.latency_ms = (double)(us - last_us) / (double)(d - last_decisions) / 1000.0;
+        last_decisions = d;
+        last_us = us;
+        const AsyncQueueStats aq = async_scan_queue_stats();
+        for (size_t c = 0; c < kAsyncScanClasses; ++c) s.async_depth += aq.depth[c];
+        s.cpu_psi = read_psi("cpu");
+        s.io_psi  = read_psi("io");
+
+        const size_t sync_before  = g_worker_slots.limit();
+        const size_t async_before = async_worker_count();   // 0 until the pattern database is ready
+        const ConcurrencyController::Decision dec = ctl.step(s);
+        const bool async_changed = async_before && dec.async != async_before;
+        if (dec.sync != sync_before) g_worker_slots.set_limit(dec.sync);
+        if (async_changed) set_async_workers(dec.async);
+        if (dec.sync != sync_before || async_changed) {
+            std::cout << "[concurrency] sync=" << dec.sync << " (" << dec.sync_reason << ")"
+                      << " async=" << dec.async << " (" << dec.async_reason << ")"
+                      << " busy=" << s.sync_busy << " waiting=" << s.sync_waiting
+                      << " latency=" << s.latency_ms << " ms async_depth=" << s.async_depth
+                      << " cpu_psi=" << s.cpu_psi << " io_psi=" << s.io_psi << "\n";
+        }
+    }
+}
+
+// Everything a pattern reload swaps or invalidates.
+struct ReloadTargets {
+    const ConfigManager* config;
+    sqlite3* cache_db;
+    MatcherRegistry* registry;
+    CacheL1* l1;
+    CacheL2* l2;
+    std::vector<std::unique_ptr<CacheShm>>* shm_tiers; // old tiers stay mapped until exit
+    std::atomic<uint64_t>* ruleset_now;
+};
+
+// Desc: re-read patterns from the config file, compile them off the hot path and publish
+//       the new generation; in-flight scans finish on the set they already hold
+// In: ReloadTargets& t
+// Out: bool (true if the new patterns are active or nothing changed)
+static bool reload_patterns(ReloadTargets& t) {
+    auto cur = t.registry->current();
+    ConfigManager fresh;
+    if (!fresh.loadFromFile(t.config->configPath())) {
+        std::cerr << "[CoreEngine] reload: config invalid; keeping current patterns\n";
+        return false;
+    }
+    if (cur && fresh.patternsHash() == cur->patterns_hash) {
+        std::cout << "[CoreEngine] reload: patterns unchanged\n";
+        return true;
+    }
+    if (fresh.getWatchMode() != t.config->getWatchMode() || fresh.getWatchTarget() != t.config->getWatchTarget()) {
+        std::cerr << "[CoreEngine] reload: watch scope changes need a restart; applying patterns only\n";
+    }
+
+    // bump ruleset_version on a private connection (the shared one serves cache lookups)
+    const char* fn = sqlite3_db_filename(t.cache_db, "main");
+    const std::string db_path = fn ? fn : "";
+    sqlite3* db = nullptr;
+    bool ok = !db_path.empty() &&
+              sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_busy_timeout(db, 5000);
+        ok = fresh.initRulesetVersion(db);
+    }
+    if (db) sqlite3_close(db);
+    if (!ok) {
+        std::cerr << "[CoreEngine] reload: ruleset version update failed; keeping current patterns\n";
+        return false;
+    }
+
+    auto c0 = SteadyClock::now();
+    std::shared_ptr<MatcherSet> set = MatcherRegistry::build(fresh, t.config->hs_db_cache_dir(), cur.get(),
+                                                             static_cast<size_t>(t.config->pattern_max_tiers()));
+    if (!set) {
+        std::cerr << "[CoreEngine] reload: pattern compile failed; keeping current patterns\n";
+        return false;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - c0).count();
+
+    // order: new set visible before the version lookups use, delta rows only after both
+    t.l1->set_delta_base_version(0);
+    t.registry->publish(set);
+    t.l2->set_generation(set->ruleset_version);
+    t.ruleset_now->store(set->ruleset_version, std::memory_order_release);
+    t.l1->set_delta_base_version(set->has_delta ? set->delta_base_version : 0);
+
+    // the shared tier is per pattern set: the replaced set's segment is unlinked
+    if (t.config->shared_cache_enabled()) {
+        if (!t.shm_tiers->empty() && t.shm_tiers->back()->patterns_hash() != set->patterns_hash) t.shm_tiers->back()->unlink();
+        std::unique_ptr<CacheShm> shm(new CacheShm());
+        if (shm->attach(set->patterns_hash, t.config->shared_cache_slots())) {
+            t.l2->attach_shared(shm.get());
+            t.shm_tiers->push_back(std::move(shm));
+        } else {
+            t.l2->attach_shared(nullptr);
+        }
+    }
+
+    const size_t purged = t.l2->purge_stale();
+    Requirements::startBackgroundInvalidation(db_path, set->ruleset_version, fresh.getRulesetDelta());
+    std::cout << "[CoreEngine] patterns reloaded: generation=" << set->generation
+              << " ruleset=" << set->ruleset_version
+              << " patterns=" << fresh.getPatternStrings().size()
+              << " tiers=" << set->full.tierCount()
+              << " compile=" << ms << " ms"
+              << " L2_purged=" << purged << "\n";
+    return true;
+}
+
+// Desc: recompile a tiered pattern set into a single base database and publish it.
+//       Same patterns and ruleset version, so cached decisions stay valid.
+// In: ReloadTargets& t
+// Out: void
+static void merge_pattern_tiers(ReloadTargets& t) {
+    auto cur = t.registry->current();
+    if (!cur || cur->full.tierCount() < 2) return;
+    auto c0 = SteadyClock::now();
+    std::shared_ptr<MatcherSet> set = MatcherRegistry::merge(*cur, t.config->hs_db_cache_dir());
+    if (!set) {
+        std::cerr << "[CoreEngine] pattern tier merge failed; keeping delta tiers\n";
+        return;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - c0).count();
+    t.registry->publish(set);
+    std::cout << "[CoreEngine] pattern tiers merged: generation=" << set->generation
+              << " tiers=" << cur->full.tierCount() << "->1"
+              << " compile=" << ms << " ms\n";
+}
+
+// Desc: wait for SIGHUP requests and apply them until stop is requested; delta tiers
+//       left by reloads are merged once no reload came in for the merge interval
+// In: ReloadTargets t
+// Out: void
+static void pattern_reload_loop(ReloadTargets t) {
+    const uint64_t merge_ticks = t.config->pattern_merge_interval_sec() * 5;
+    uint64_t idle_ticks = 0;
+    while (!g_stop.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (g_reload.exchange(false, std::memory_order_relaxed)) {
+            reload_patterns(t);
+            idle_ticks = 0;
+        } else if (++idle_ticks >= merge_ticks) {
+            merge_pattern_tiers(t);
+            idle_ticks = 0;
+        }
+    }
+}
 
 
 // Desc: periodically print metrics every n decisions
@@ -74,6 +309,8 @@ auto report_every = [](uint64_t n) {
         double byte_hit_rate = tb ? (double)hit_bytes.load(std::memory_order_relaxed) * 100.0 / (double)tb : 0.0;
         double l1_hit_rate = (double)l1_hits.load(std::memory_order_relaxed) * 100.0 / (double)d;
         double l1_byte_hit_rate = tb ? (double)l1_hit_bytes.load(std::memory_order_relaxed) * 100.0 / (double)tb : 0.0;
+        double shm_hit_rate = (double)shm_hits.load(std::memory_order_relaxed) * 100.0 / (double)d;
+        AsyncQueueStats aq = async_scan_queue_stats();
 
         std::cout << COLOR_RED
           << "[metrics] decisions=" << d
@@ -81,7 +318,10 @@ auto report_every = [](uint64_t n) {
           << "L2_byte_hit_rate=" << byte_hit_rate << "% "
           << "L1_hit_rate=" << l1_hit_rate << "% "
           << "L1_byte_hit_rate=" << l1_byte_hit_rate << "% "
-          << "avg_decision=" << avg_ms << " ms"
+          << "shm_hit_rate=" << shm_hit_rate << "% "
+          << "avg_decision=" << avg_ms << " ms "
+          << "async_depth=" << aq.depth[0] << "/" << aq.depth[1] << "/" << aq.depth[2] << " "
+          << "workers=" << g_worker_slots.limit() << "/" << async_worker_count()
           << COLOR_RESET << std::endl;
     }
 };
@@ -125,17 +365,119 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
 
     // [Initialize and assignment for preparation]
     pid_t self_pid = getpid();
-    PatternMatcherHS hs;
-    hs.buildFromConfig(config);
-    RuleEvaluator evaluator(config, hs);
+    // [Staged startup] compile Hyperscan in parallel with cache warmup; only misses wait for it.
+    // The registry holds the active pattern generation; SIGHUP publishes a new one.
+    MatcherRegistry registry;
+    std::shared_future<bool> hs_ready = std::async(std::launch::async, [&registry, &config]() {
+        auto c0 = SteadyClock::now();
+        std::shared_ptr<MatcherSet> set = MatcherRegistry::build(config, config.hs_db_cache_dir());
+        bool ok = (set != nullptr);
+        if (ok) registry.publish(std::move(set));
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - c0).count();
+        std::cout << "[CoreEngine] pattern database ready (" << ms << " ms, ok=" << ok << ")\n";
+        return ok;
+    }).share();
+    // [Incremental revalidation] files cached as ALLOW under the previous ruleset are
+    // rescanned against the newly added patterns only
+    const RulesetDelta& delta = config.getRulesetDelta();
+    const bool use_delta = delta.active && !delta.added_ids.empty();
+    RuleEvaluator evaluator(config, registry);
     char buffer[BUF_SIZE];
     struct fanotify_event_metadata* metadata;
     CacheL1 l1(cache_db);
+    if (use_delta) l1.set_delta_base_version(delta.prev_version);
     CacheL2 l2(l1);
+    std::vector<std::unique_ptr<CacheShm>> shm_tiers;
+    if (config.shared_cache_enabled()) {
+        std::unique_ptr<CacheShm> shm(new CacheShm());
+        if (shm->attach(config.patternsHash(), config.shared_cache_slots())) {
+            l2.attach_shared(shm.get());
+            shm_tiers.push_back(std::move(shm));
+            std::cout << "[CoreEngine] shared decision cache attached\n";
+        } else {
+            std::cerr << "[CoreEngine] shared decision cache unavailable; continuing without it\n";
+        }
+    }
     const uint64_t RULESET_VERSION = config.getRulesetVersion();
+    // active ruleset version; changes when a reload publishes a new pattern generation
+    std::atomic<uint64_t> ruleset_now{RULESET_VERSION};
+    l2.set_generation(RULESET_VERSION);
+    std::unique_ptr<ContentHashCache> dedup;
+    if (config.content_hash_enabled()) {
+        dedup.reset(new ContentHashCache(cache_db, config.content_hash_max_entries()));
+        evaluator.set_content_hash_cache(dedup.get());
+    }
+    // [Memory governor] file bytes held by sync and async scans together stay under max_mb
+    std::unique_ptr<ByteBudget> budget;
+    if (config.memory_budget().enabled) {
+        budget.reset(new ByteBudget(config.memory_budget().max_mb << 20));
+        evaluator.set_byte_budget(budget.get());
+    }
+    // [Append-aware rescans] growing text files resume at their last clean length
+    std::unique_ptr<AppendIndex> appends;
+    if (config.append_scan().enabled) {
+        appends.reset(new AppendIndex(config.append_scan()));
+        evaluator.set_append_index(appends.get());
+    }
+    // [Chunk-level rescans] large files edited in place rescan only their changed chunks
+    std::unique_ptr<ChunkIndex> chunks;
+    if (config.chunk_scan().enabled) {
+        chunks.reset(new ChunkIndex(config.chunk_scan()));
+        evaluator.set_chunk_index(chunks.get());
+    }
+    // [Extractor pool] PDF/office parsing in resource-limited helper processes;
+    // helpers come up in the background (their exec is answered by the event loop)
+    ExtractorPool extractors;
+    if (config.extractor_pool().enabled) {
+        if (extractors.start(config.extractor_pool(), log_pipe[1])) {
+            evaluator.set_extractor_pool(&extractors);
+        } else {
+            std::cerr << "[CoreEngine] extractor pool unavailable; parsing in process\n";
+        }
+    }
 
-    // [Starting thread pool] (kept for other async parts if used)
-    start_async_workers(log_pipe[1], config, &hs, l2, /*num_workers=*/1);
+    // [Warm restart] restore hot L2 entries saved by the previous run
+    size_t restored = l2.load_snapshot(config.l2_snapshot_path(), RULESET_VERSION, config.max_cache_bytes());
+    std::cout << "[CoreEngine] L2 snapshot restored: " << restored << " entries\n";
+    size_t preloaded = l2.preload_from_l1(RULESET_VERSION, config.max_cache_bytes());
+    std::cout << "[CoreEngine] L2 preloaded from L1: " << preloaded << " entries\n";
+
+    // [Async queue bounds] set before warmup or a large-file miss can enqueue
+    configure_async_scan_queue(config.async_queue());
+
+    // [Adaptive concurrency] both pools start at their configured size (clamped to the
+    // controller's bounds) and are resized at runtime; without it: 1 sync + N async
+    ConcurrencyOptions conc = config.concurrency();
+    if (conc.max_sync == 0)  conc.max_sync  = max_concurrency;
+    if (conc.max_async == 0) conc.max_async = cores;
+    ConcurrencyController controller(conc, 1, config.async_queue().workers);
+    const size_t async_workers = conc.enabled
+        ? std::min<size_t>(std::max<size_t>(config.async_queue().workers, controller.min_async()), controller.max_async())
+        : config.async_queue().workers;
+    g_worker_slots.set_limit(conc.enabled ? controller.min_sync() : 1);
+
+    // [Starting thread pool] (kept for other async parts if used); tasks queue up until HS is ready
+    std::thread async_starter([&, hs_ready]() {
+        hs_ready.wait();
+        start_async_workers(log_pipe[1], config, &registry, l2, async_workers, dedup.get(),
+                            config.extractor_pool().enabled ? &extractors : nullptr, budget.get(),
+                            appends.get(), chunks.get());
+    });
+
+    install_stop_handlers();
+    std::thread snapshot_thr;
+    if (config.l2_snapshot_interval_sec() > 0) {
+        snapshot_thr = std::thread(l2_snapshot_loop, std::cref(l2), config.l2_snapshot_path(),
+                                   std::cref(ruleset_now), config.l2_snapshot_interval_sec());
+    }
+    std::thread concurrency_thr;
+    if (conc.enabled) {
+        concurrency_thr = std::thread(concurrency_loop, std::ref(controller), conc.interval_ms);
+    }
+    std::thread reload_thr([&, hs_ready]() {
+        hs_ready.wait(); // the first generation must exist before it can be replaced
+        pattern_reload_loop(ReloadTargets{&config, cache_db, &registry, &l1, &l2, &shm_tiers, &ruleset_now});
+    });
 
     // if (config.getWarmupMode() == WarmupMode::Pattern) {
     //     std::cout << "[CoreEngine] engine will start after pattern warmup…\n";
@@ -148,9 +490,87 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
     //     std::cout << "[CoreEngine] pattern warmup finished. starting engine…\n";
     // }
 
+    // [Staged startup] misses that arrive before the first pattern database is published
+    // wait here without a worker slot, so the main loop keeps answering cache hits meanwhile
+    std::mutex parked_mu;
+    std::vector<std::function<void()>> parked;
+    bool hs_published = false;
+    // run a miss job on its own thread; the caller has taken its worker slot
+    auto run_miss = [](std::function<void()> job) {
+        std::thread([job = std::move(job)]() {
+            job();
+            g_worker_slots.release();
+        }).detach();
+    };
+    auto dispatch_miss = [&](std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lk(parked_mu);
+            if (!hs_published) { parked.push_back(std::move(job)); return; }
+        }
+        g_worker_slots.acquire(); // backpressure on the main loop once scans can run
+        run_miss(std::move(job));
+    };
+    std::thread parked_thr([&, hs_ready]() {
+        hs_ready.wait();
+        std::vector<std::function<void()>> jobs;
+        {
+            std::lock_guard<std::mutex> lk(parked_mu);
+            hs_published = true;
+            jobs.swap(parked);
+        }
+        for (auto& job : jobs) {
+            g_worker_slots.acquire();
+            run_miss(std::move(job));
+        }
+    });
+
+    // [Small-file batching] misses up to max_file_bytes from one read() are scanned
+    // together by a single worker instead of one worker each
+    struct BatchMeta { struct stat st; SteadyClock::time_point t0; };
+    std::vector<BatchEvent> batch;
+    std::vector<BatchMeta> batch_meta;
+    const bool batching = config.small_batch_enabled();
+    const uint64_t batch_max_bytes = config.small_batch_max_file_bytes();
+    const size_t batch_max_files = static_cast<size_t>(config.small_batch_max_files());
+    auto flush_batch = [&]() {
+        if (batch.empty()) return;
+        std::vector<BatchEvent> events;
+        std::vector<BatchMeta> metas;
+        events.swap(batch);
+        metas.swap(batch_meta);
+        int fan_fd_local = fan_fd;
+        int log_fd = log_pipe[1];
+        uint64_t ruleset = ruleset_now.load(std::memory_order_acquire);
+        uint64_t cap_bytes = config.max_cache_bytes();
+
+        dispatch_miss([&, fan_fd_local, log_fd, ruleset, cap_bytes,
+                       events = std::move(events), metas = std::move(metas)]() mutable {
+            std::shared_ptr<const MatcherSet> set = registry.current();
+            evaluator.handle_small_batch(fan_fd_local, events, log_fd, set.get());
+            const uint64_t rs = set ? set->ruleset_version : ruleset;
+            const auto now = SteadyClock::now();
+            for (size_t i = 0; i < events.size(); ++i) {
+                l2.put(metas[i].st, rs, events[i].decision, cap_bytes, events[i].matched);
+                auto dt_us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                 now - metas[i].t0).count();
+                total_us.fetch_add(dt_us, std::memory_order_relaxed);
+                decisions.fetch_add(1, std::memory_order_relaxed);
+                total_bytes.fetch_add((uint64_t)metas[i].st.st_size, std::memory_order_relaxed);
+                report_every(REPORT_PER_CYCLE);
+            }
+            #ifdef DEBUG
+            std::cout << "[CoreEngine] small-file batch answered: files=" << events.size() << std::endl;
+            #endif
+        });
+    };
+
     // [Start main loop of program]
     std::cout << "[CoreEngine] Watching " << target << " for access events...\n";
-    while (true) {
+    struct pollfd pfd{};
+    pfd.fd = fan_fd;
+    pfd.events = POLLIN;
+    while (!g_stop.load(std::memory_order_relaxed)) {
+        if (poll(&pfd, 1, 1000) <= 0) continue;
         ssize_t len = read(fan_fd, buffer, sizeof(buffer));
         if (len <= 0) continue;
         metadata = (struct fanotify_event_metadata*)buffer;
@@ -167,8 +587,8 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                 continue;
             }
 
-            // Exclude program pid and logger pid from checking
-            if (metadata->pid == self_pid || metadata->pid == logger_pid) {
+            // Exclude program pid, logger pid and extractor helpers from checking
+            if (metadata->pid == self_pid || metadata->pid == logger_pid || extractors.owns(metadata->pid)) {
                 #ifdef DEBUG
                 std::cout << "[Access] By program itself" << std::endl;
                 #endif
@@ -214,8 +634,9 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                 #endif
 
                 // Cache path
-                int resp_cache = l2.get(st, RULESET_VERSION, decision, config.max_cache_bytes());
-                if (resp_cache != 0) {
+                const uint64_t ruleset_cur = ruleset_now.load(std::memory_order_acquire);
+                int resp_cache = l2.get(st, ruleset_cur, decision, config.max_cache_bytes());
+                if (resp_cache != 0 && resp_cache != 4) {
                      if (resp_cache != 0) {
                         if (resp_cache == 2) {
                             // L2 hit (counts for both L2 and L1)
@@ -227,6 +648,9 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                             // L1-only hit
                             l1_hits.fetch_add(1, std::memory_order_relaxed);
                             l1_hit_bytes.fetch_add((uint64_t)st.st_size, std::memory_order_relaxed);
+                        } else if (resp_cache == 3) {
+                            // decided by another local instance (shared tier)
+                            shm_hits.fetch_add(1, std::memory_order_relaxed);
                         }
                     }
                     total_bytes.fetch_add((uint64_t)st.st_size, std::memory_order_relaxed);
@@ -248,6 +672,27 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                     continue;
                 }
 
+                // Small miss: join this read's batch (answered when the buffer is drained)
+                if (batching && resp_cache != 4 && st.st_size > 0 &&
+                    (uint64_t)st.st_size <= batch_max_bytes) {
+                    BatchEvent ev;
+                    ev.fd   = metadata->fd;
+                    ev.pid  = static_cast<pid_t>(metadata->pid);
+                    ev.size = static_cast<size_t>(st.st_size);
+                    batch.push_back(std::move(ev));
+                    batch_meta.push_back(BatchMeta{st, t0});
+                    if (config.getWarmupMode() == WarmupMode::Scope) {
+                        char fd_link_opened[64];
+                        snprintf(fd_link_opened, sizeof(fd_link_opened), "/proc/self/fd/%d", metadata->fd);
+                        char opened_path_buf[512];
+                        ssize_t opened_n = readlink(fd_link_opened, opened_path_buf, sizeof(opened_path_buf) - 1);
+                        if (opened_n > 0) Warmup::scope_warmup_on_access(std::string(opened_path_buf, opened_n));
+                    }
+                    if (batch.size() >= batch_max_files) flush_batch();
+                    metadata = FAN_EVENT_NEXT(metadata, len);
+                    continue;
+                }
+
                 // Miss path: offload everything to a worker so the main loop never blocks
                 {
                     // Transfer ownership of the fd to the worker
@@ -257,14 +702,18 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                     int fan_fd_local = fan_fd;
                     int log_fd = log_pipe[1];
                     struct stat st_copy = st;
-                    uint64_t ruleset = RULESET_VERSION;
+                    uint64_t ruleset = ruleset_cur;
                     uint64_t cap_bytes = config.max_cache_bytes();
                     auto t0_copy = t0;
-
-                    // Limit concurrency
-                    g_worker_slots.acquire();
-
-                    std::thread([&, fan_fd_local, log_fd, event_fd, st_copy, ruleset, cap_bytes, t0_copy]() {
+                    const bool want_delta = (resp_cache == 4);
+
+                    // Limit concurrency (parked without a slot until the patterns are compiled)
+                    dispatch_miss([&, fan_fd_local, log_fd, event_fd, st_copy, ruleset, cap_bytes, t0_copy, want_delta]() {
+                        std::shared_ptr<const MatcherSet> set = registry.current();
+                        // ALLOW under the previous ruleset: only the added patterns need a scan,
+                        // as long as the set is the generation the lookup was made against
+                        const bool delta_only = want_delta && set && set->has_delta &&
+                                                set->ruleset_version == ruleset;
                         #ifdef DEBUG
                             {
                                 pid_t tid = (pid_t)syscall(SYS_gettid);
@@ -283,9 +732,11 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                         int decision_local = 0;
                         struct fanotify_event_metadata md_min{};
                         md_min.fd = event_fd;
-                        evaluator.handle_event(fan_fd_local, &md_min, log_fd, decision_local);
+                        std::string matched;
+                        evaluator.handle_event(fan_fd_local, &md_min, log_fd, decision_local, &matched,
+                                               set.get(), delta_only);
                         if (decision_local != 2) {
-                            l2.put(st_copy, ruleset, decision_local, cap_bytes);
+                            l2.put(st_copy, set ? set->ruleset_version : ruleset, decision_local, cap_bytes, matched);
                         }
 
                         auto dt_us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
@@ -305,9 +756,7 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                                     << std::endl;
                         }
                         #endif
-
-                        g_worker_slots.release();
-                    }).detach();
+                    });
 
                     // Important: the main thread must not touch/close event_fd now
                     char fd_link_opened[64];
@@ -338,5 +787,40 @@ void start_core_engine_blocking(const ConfigManager& config, sqlite3* cache_db)
                 metadata = FAN_EVENT_NEXT(metadata, len);
             }
         }
+        flush_batch();
+    }
+
+    // [Shutdown] wait for the in-flight miss workers, stop background scans, persist L2
+    std::cout << "[CoreEngine] stopping...\n";
+    if (concurrency_thr.joinable()) concurrency_thr.join();
+    if (parked_thr.joinable()) parked_thr.join(); // parked misses hold their slots from here on
+    g_worker_slots.drain();
+    if (conc.enabled) {
+        std::cout << "[CoreEngine] concurrency: grows=" << controller.grows() << " cuts=" << controller.cuts()
+                  << " sync_bounds=" << controller.min_sync() << ".." << controller.max_sync()
+                  << " async_bounds=" << controller.min_async() << ".." << controller.max_async() << "\n";
+    }
+    if (async_starter.joinable()) async_starter.join();
+    {
+        AsyncQueueStats aq = async_scan_queue_stats();
+        std::cout << "[CoreEngine] async queue: deduped=" << aq.deduped << " aged=" << aq.aged
+                  << " dropped=" << aq.dropped << " parked=" << aq.parked
+                  << " reopen_failed=" << aq.reopen_failed;
+        for (size_t c = 0; c < kAsyncScanClasses; ++c) {
+            std::cout << " " << async_scan_class_name(static_cast<AsyncScanClass>(c))
+                      << "=" << aq.served[c] << "/" << aq.enqueued[c] << "(" << aq.depth[c] << " queued)";
+        }
+        std::cout << "\n";
+    }
+    stop_async_workers_and_join();
+    extractors.stop();
+    if (budget) {
+        std::cout << "[CoreEngine] memory budget: waits=" << budget->waits()
+                  << " streamed=" << budget->streamed() << "\n";
     }
+    if (snapshot_thr.joinable()) snapshot_thr.join();
+    if (reload_thr.joinable()) reload_thr.join();
+    l2.save_snapshot(config.l2_snapshot_path(), ruleset_now.load());
+    close(fan_fd);
+    kill(logger_pid, SIGTERM);
 }
@@ -0,0 +1,187 @@
+#include "CoreEngine.hpp"
+#include "PatternMatcherHS.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <unistd.h>
+
+#define COLOR_GREEN "\033[1;32m"
+#define COLOR_RESET "\033[0m"
+
+using BenchClock = std::chrono::steady_clock;
+
+// Desc: time one pattern-database build path
+// In: const ConfigManager& config, const std::string& cache_dir ("" = plain compile), bool& ok
+// Out: double (milliseconds)
+static double time_build(const ConfigManager& config, const std::string& cache_dir, bool& ok) {
+    PatternMatcherHS hs;
+    auto t0 = BenchClock::now();
+    ok = hs.buildFromConfig(config, cache_dir);
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - t0).count();
+}
+
+// Desc: resident set size of this process (/proc/self/statm)
+// In: (none)
+// Out: size_t (bytes, 0 if unknown)
+static size_t rss_bytes() {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long size = 0, resident = 0;
+    const int n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    return n == 2 ? resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE)) : 0;
+}
+
+// Desc: compare startup cost of compiling the pattern set vs loading the serialized database
+// In: const ConfigManager& config, int rounds
+// Out: void
+void start_core_engine_benchmark(const ConfigManager& config, int rounds) {
+    if (rounds < 1) rounds = 1;
+    const std::string dir = config.hs_db_cache_dir().empty() ? "cache" : config.hs_db_cache_dir();
+    const std::string path = PatternMatcherHS::cachePath(dir, config.patternsHash());
+
+    std::cout << "[Benchmark] patterns=" << config.getPatternStrings().size()
+              << " rounds=" << rounds << " cache=" << (path.empty() ? "(unavailable)" : path) << "\n";
+
+    double compile_ms = 0.0, load_ms = 0.0;
+    bool ok = true;
+    for (int i = 0; i < rounds && ok; ++i) compile_ms += time_build(config, "", ok);
+    if (!ok) {
+        std::cerr << "[Benchmark] pattern compile failed\n";
+        return;
+    }
+
+    // first cached build compiles and writes the file; later ones must hit it
+    if (!path.empty()) ::unlink(path.c_str());
+    double first_ms = time_build(config, dir, ok);
+    for (int i = 0; i < rounds && ok; ++i) load_ms += time_build(config, dir, ok);
+    if (!ok) {
+        std::cerr << "[Benchmark] cached build failed\n";
+        return;
+    }
+
+    compile_ms /= rounds;
+    load_ms    /= rounds;
+    std::cout << std::fixed << std::setprecision(2)
+              << COLOR_GREEN
+              << "[Benchmark] compile=" << compile_ms << " ms"
+              << " | compile+serialize=" << first_ms << " ms"
+              << " | load(serialized)=" << load_ms << " ms"
+              << " | speedup=" << (load_ms > 0.0 ? compile_ms / load_ms : 0.0) << "x"
+              << COLOR_RESET << "\n";
+
+    // reload cost for a one-pattern change: delta tier on the current base vs full recompile
+    PatternMatcherHS base;
+    if (!base.buildFromConfig(config, "")) return;
+    std::vector<std::string> pats = config.getPatternStrings();
+    std::vector<std::string> ids  = config.patternIds();
+    pats.push_back("benchmark-added-[0-9]{6}");
+    ids.push_back("benchmark-added0");
+    double tier_ms = 0.0, full_ms = 0.0;
+    for (int i = 0; i < rounds; ++i) {
+        PatternMatcherHS tiered, full;
+        auto t0 = BenchClock::now();
+        if (!tiered.buildIncremental(base, pats, ids, 2)) {
+            std::cerr << "[Benchmark] delta tier build failed\n";
+            return;
+        }
+        auto t1 = BenchClock::now();
+        (void)full.buildFromPatterns(pats, ids);
+        auto t2 = BenchClock::now();
+        tier_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        full_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    }
+    std::cout << std::fixed << std::setprecision(2)
+              << COLOR_GREEN
+              << "[Benchmark] reload(+1 pattern): full_recompile=" << full_ms / rounds << " ms"
+              << " | delta_tier=" << tier_ms / rounds << " ms"
+              << COLOR_RESET << "\n";
+}
+
+// Desc: deterministic synthetic identifiers ("cust-" + 10 hex digits)
+// In: size_t n, uint64_t seed
+// Out: std::vector<std::string>
+static std::vector<std::string> synth_literals(size_t n, uint64_t seed) {
+    static const char* hex = "0123456789abcdef";
+    std::vector<std::string> out;
+    out.reserve(n);
+    uint64_t x = seed;
+    for (size_t i = 0; i < n; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::string s = "cust-";
+        for (int k = 0; k < 10; ++k) s += hex[(x >> (4 * k + 20)) & 0xF];
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+// Desc: time repeated no-match scans over a text buffer
+// In: const PatternMatcherHS& m, const std::string& text, int reps
+// Out: double (MB/s)
+static double scan_throughput(const PatternMatcherHS& m, const std::string& text, int reps) {
+    auto t0 = BenchClock::now();
+    for (int i = 0; i < reps; ++i) (void)m.matches(text);
+    const double sec = std::chrono::duration<double>(BenchClock::now() - t0).count();
+    return sec > 0.0 ? (double)text.size() * reps / (1024.0 * 1024.0) / sec : 0.0;
+}
+
+// Desc: literal API vs regex API on synthetic dictionaries: compile time, database size, scan speed
+// In: const std::vector<size_t>& sizes (number of literals per run)
+// Out: void
+void start_core_engine_dict_benchmark(const std::vector<size_t>& sizes) {
+    // 16 MB of lowercase words: no '-' so no literal can match (worst case: full scan)
+    std::string text;
+    text.reserve(16u << 20);
+    uint64_t x = 42;
+    while (text.size() < (16u << 20)) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        text += static_cast<char>('a' + (x >> 33) % 26);
+        if (((x >> 40) & 7) == 0) text += ' ';
+    }
+
+    const size_t kRegexLimit = 100000; // regex compile beyond this takes minutes
+    for (size_t n : sizes) {
+        const std::vector<std::string> lits = synth_literals(n, n);
+
+        PatternMatcherHS lit;
+        size_t rss0 = rss_bytes();
+        auto t0 = BenchClock::now();
+        if (!lit.buildFromLiterals(lits, "bench", true)) {
+            std::cerr << "[Benchmark] literal compile failed at n=" << n << "\n";
+            continue;
+        }
+        const double lit_ms = std::chrono::duration<double, std::milli>(BenchClock::now() - t0).count();
+        size_t rss1 = rss_bytes();
+
+        std::cout << std::fixed << std::setprecision(2) << COLOR_GREEN
+                  << "[Benchmark] literals=" << n
+                  << " | lit_compile=" << lit_ms << " ms"
+                  << " lit_db=" << lit.databaseBytes() / 1024 << " KB"
+                  << " lit_scratch=" << lit.scratchBytes() / 1024 << " KB"
+                  << " lit_rss=" << rss0 / 1024 << "->" << rss1 / 1024 << " KB"
+                  << " lit_scan=" << scan_throughput(lit, text, 4) << " MB/s";
+
+        if (n <= kRegexLimit) {
+            PatternMatcherHS rx;
+            rss0 = rss_bytes();
+            t0 = BenchClock::now();
+            // identifiers contain no regex metacharacters, so they compile as-is
+            if (rx.buildFromPatterns(lits, std::vector<std::string>(lits.size()))) {
+                const double rx_ms = std::chrono::duration<double, std::milli>(BenchClock::now() - t0).count();
+                rss1 = rss_bytes();
+                std::cout << " | regex_compile=" << rx_ms << " ms"
+                          << " regex_db=" << rx.databaseBytes() / 1024 << " KB"
+                          << " regex_scratch=" << rx.scratchBytes() / 1024 << " KB"
+                          << " regex_rss=" << rss0 / 1024 << "->" << rss1 / 1024 << " KB"
+                          << " regex_scan=" << scan_throughput(rx, text, 4) << " MB/s";
+            }
+        } else {
+            std::cout << " | regex: skipped (n > " << kRegexLimit << ")";
+        }
+        std::cout << COLOR_RESET << "\n";
+    }
+}
@@ -0,0 +1,39 @@
+// === src/FileScanner/AppendIndex.cpp ===
+#include "AppendIndex.hpp"
+#include "ContentHash.hpp"
+
+static const uint64_t kWindowSeed = 0x61707065ull; // "appe"
+
+// Desc: checksum of a window or prefix
+// In: const char* p, size_t n
+// Out: uint64_t
+std::uint64_t AppendIndex::hash(const char* p, size_t n) {
+    return xxh64(p, n, kWindowSeed);
+}
+
+// Desc: the entry of (dev, ino) if it was recorded under this ruleset
+// In: dev_t dev, ino_t ino, uint64_t ruleset_version, Entry& out
+// Out: bool
+bool AppendIndex::lookup(dev_t dev, ino_t ino, std::uint64_t ruleset_version, Entry& out) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    const Entry* e = map_.find(dev, ino);
+    if (!e || e->ruleset_version != ruleset_version) return false;
+    out = *e;
+    return true;
+}
+
+// Desc: remember a clean scan (replaces an older entry of the same file)
+// In: dev_t dev, ino_t ino, const Entry& e
+// Out: void
+void AppendIndex::record(dev_t dev, ino_t ino, const Entry& e) {
+    std::lock_guard<std::mutex> lk(mu_);
+    map_.put(dev, ino, e);
+}
+
+// Desc: drop the entry of (dev, ino)
+// In: dev_t dev, ino_t ino
+// Out: void
+void AppendIndex::forget(dev_t dev, ino_t ino) {
+    std::lock_guard<std::mutex> lk(mu_);
+    map_.erase(dev, ino);
+}
@@ -0,0 +1,128 @@
+// === src/FileScanner/ChunkIndex.cpp ===
+#include "ChunkIndex.hpp"
+#include "ContentHash.hpp"
+#include <array>
+#include <unordered_set>
+
+static const uint64_t kChunkSeed = 0x63686e6bull; // "chnk"
+// normalized chunking: harder to cut below the average size, easier above it
+static const uint64_t kMaskS = ~0ull << (64 - 18);
+static const uint64_t kMaskL = ~0ull << (64 - 14);
+
+// Desc: 256 pseudo-random gear values (splitmix64; fixed so chunking is stable across runs)
+// In: (none)
+// Out: const std::array<uint64_t, 256>&
+static const std::array<uint64_t, 256>& gear() {
+    static const std::array<uint64_t, 256> table = []() {
+        std::array<uint64_t, 256> t{};
+        uint64_t x = 0x243F6A8885A308D3ull;
+        for (auto& g : t) {
+            uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            g = z ^ (z >> 31);
+        }
+        return t;
+    }();
+    return table;
+}
+
+// Desc: length of the next chunk at p (FastCDC cut point)
+// In: const unsigned char* p, size_t n (bytes left)
+// Out: size_t
+static size_t cut_point(const unsigned char* p, size_t n) {
+    if (n <= ChunkIndex::kMinChunk) return n;
+    const auto& g = gear();
+    const size_t end    = std::min(n, ChunkIndex::kMaxChunk);
+    const size_t normal = std::min(end, ChunkIndex::kAvgChunk);
+    uint64_t h = 0;
+    size_t i = ChunkIndex::kMinChunk;
+    for (; i < normal; ++i) {
+        h = (h << 1) + g[p[i]];
+        if (!(h & kMaskS)) return i + 1;
+    }
+    for (; i < end; ++i) {
+        h = (h << 1) + g[p[i]];
+        if (!(h & kMaskL)) return i + 1;
+    }
+    return end;
+}
+
+// Desc: identity of two neighbouring chunks
+// In: uint64_t a (left), uint64_t b (right)
+// Out: uint64_t
+static uint64_t pair_key(uint64_t a, uint64_t b) {
+    return a * 0x9E3779B97F4A7C15ull ^ ((b << 31) | (b >> 33));
+}
+
+// Desc: cut data into content-defined chunks (see header)
+// In: const char* data, size_t n, std::vector<Chunk>& out
+// Out: void
+void ChunkIndex::split(const char* data, size_t n, std::vector<Chunk>& out) {
+    out.clear();
+    out.reserve(n / kAvgChunk + 1);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t off = 0;
+    while (off < n) {
+        const size_t len = cut_point(p + off, n - off);
+        out.push_back(Chunk{off, len, xxh64(p + off, len, kChunkSeed)});
+        off += len;
+    }
+}
+
+// Desc: ranges that the recorded clean scan does not vouch for (see header)
+// In: dev_t dev, ino_t ino, uint64_t ruleset_version, const std::vector<Chunk>& chunks, size_t total,
+//     std::vector<Range>& out
+// Out: bool
+bool ChunkIndex::dirty_ranges(dev_t dev, ino_t ino, std::uint64_t ruleset_version,
+                              const std::vector<Chunk>& chunks, size_t total, std::vector<Range>& out) const {
+    out.clear();
+    std::unordered_set<uint64_t> clean, joints;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        const Record* r = map_.find(dev, ino);
+        if (!r || r->ruleset_version != ruleset_version) return false;
+        const auto& h = r->hashes;
+        clean.reserve(h.size());
+        joints.reserve(h.size());
+        for (size_t k = 0; k < h.size(); ++k) {
+            clean.insert(h[k]);
+            if (k > 0) joints.insert(pair_key(h[k - 1], h[k]));
+        }
+    }
+    auto add = [&](size_t from, size_t to) {
+        from = from > kWindow ? from - kWindow : 0;
+        to   = std::min(total, to + kWindow);
+        if (!out.empty() && from <= out.back().second) out.back().second = std::max(out.back().second, to);
+        else out.emplace_back(from, to);
+    };
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const Chunk& c = chunks[i];
+        if (!clean.count(c.hash)) {
+            add(c.off, c.off + c.len);                 // new content
+        } else if (i > 0 && !joints.count(pair_key(chunks[i - 1].hash, c.hash))) {
+            add(c.off, c.off);                         // known chunks, new neighbours
+        }
+    }
+    return true;
+}
+
+// Desc: remember the chunks of a clean scan (replaces an older record of the file)
+// In: dev_t dev, ino_t ino, uint64_t ruleset_version, const std::vector<Chunk>& chunks
+// Out: void
+void ChunkIndex::record(dev_t dev, ino_t ino, std::uint64_t ruleset_version, const std::vector<Chunk>& chunks) {
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(chunks.size());
+    for (const auto& c : chunks) hashes.push_back(c.hash);
+
+    std::lock_guard<std::mutex> lk(mu_);
+    map_.put(dev, ino, Record{ruleset_version, std::move(hashes)});
+}
+
+// Desc: drop the record of (dev, ino)
+// In: dev_t dev, ino_t ino
+// Out: void
+void ChunkIndex::forget(dev_t dev, ino_t ino) {
+    std::lock_guard<std::mutex> lk(mu_);
+    map_.erase(dev, ino);
+}
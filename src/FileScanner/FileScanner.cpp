@@ -0,0 +1,464 @@
+// === src/FileScanner/FileScanner.cpp ===
+#include "FileScanner.hpp"
+#include "AppendIndex.hpp"
+#include "ByteBudget.hpp"
+#include "ChunkIndex.hpp"
+#include "ContentHash.hpp"
+#include "ContentParser.hpp"
+#include "ExtractorPool.hpp"
+#include "MatcherRegistry.hpp"
+#include "PatternMatcherHS.hpp"
+#include "ScanContext.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// streaming mode (memory budget exhausted): chunk size and tail carried into the next chunk
+static const size_t kStreamChunk   = ArchiveDecoder::kChunk;
+static const size_t kStreamOverlap = ArchiveDecoder::kOverlap;
+
+// Desc: read fsz bytes at file offset 'off' from fd into dst via pread
+// In: int fd, char* dst, size_t fsz, size_t off
+// Out: bool (true if all fsz bytes were read)
+static bool read_into(int fd, char* dst, size_t fsz, size_t off = 0) {
+    size_t done = 0;
+    while (done < fsz) {
+        ssize_t r = pread(fd, dst + done, fsz - done, static_cast<off_t>(off + done));
+        if (r <= 0) return false;
+        done += static_cast<size_t>(r);
+    }
+    return true;
+}
+
+// Desc: read the head of a file into the context's file buffer, classify it and apply the type policy
+// In: int fd, size_t fsz, const ScanEnv& env, ScanContext& ctx, FileKind& kind,
+//     size_t& len (out: bytes of the file to scan)
+// Out: int (1 = scan, 0 = skipped by policy, -1 = read failure)
+static int read_head(int fd, size_t fsz, const ScanEnv& env, ScanContext& ctx, FileKind& kind, size_t& len) {
+    const size_t head = std::min(fsz, FileClassifier::kHeadBytes);
+    char* buf = ctx.file().reserve(std::max<size_t>(head, 1), ctx.huge_pages());
+    if (!buf || !read_into(fd, buf, head)) return -1;
+    kind = FileClassifier::classify(std::string_view(buf, head)).kind;
+
+    len = fsz;
+    const TypePolicy pol = env.types ? env.types->of(kind) : TypePolicy::Scan;
+    if (pol == TypePolicy::Skip) return 0;
+    if (pol == TypePolicy::Head && env.types->head_bytes < len) len = static_cast<size_t>(env.types->head_bytes);
+    return 1;
+}
+
+// Desc: run the matchers that apply to one file's extracted text
+// In: segments, const std::string& type, const std::string& path, const ScanEnv& env,
+//     bool skip_matcher (env.matcher already known not to match), std::string* matched_ids
+// Out: int (0 = ALLOW, 1 = BLOCK)
+static int match_text(const std::vector<std::string_view>& segments, const std::string& type,
+                      const std::string& path, const ScanEnv& env, bool skip_matcher,
+                      std::string* matched_ids) {
+    unsigned hit_id = 0;
+    const PatternMatcherHS* hit_by = nullptr;
+    if (!skip_matcher && env.matcher && env.matcher->matches(segments, &hit_id)) hit_by = env.matcher;
+    if (!hit_by && env.scoped) {
+        for (const auto& sm : *env.scoped) {
+            if (!sm.scope.applies(type, path)) continue;
+            if (sm.matcher.matches(segments, &hit_id)) { hit_by = &sm.matcher; break; }
+        }
+    }
+    if (!hit_by && env.dict && env.dict->matches(segments, &hit_id)) hit_by = env.dict;
+    if (hit_by && matched_ids) *matched_ids = hit_by->stableId(hit_id);
+    return hit_by ? 1 : 0;
+}
+
+// Desc: content-dedup key of a file: its digest, salted with the scoped matchers that apply
+//       to it, so identical bytes under another path or type do not reuse a verdict reached
+//       with other patterns (files no scope covers keep the plain digest)
+// In: const ContentDigest& digest, const std::string& type, const std::string& path, const ScanEnv& env
+// Out: ContentDigest
+static ContentDigest dedup_key(const ContentDigest& digest, const std::string& type, const std::string& path,
+                               const ScanEnv& env) {
+    if (!env.scoped) return digest;
+    uint64_t salt = 0;
+    bool any = false;
+    for (size_t i = 0; i < env.scoped->size(); ++i) {
+        if (!(*env.scoped)[i].scope.applies(type, path)) continue;
+        const uint64_t idx = i;
+        salt = xxh64(&idx, sizeof(idx), salt);
+        any = true;
+    }
+    if (!any) return digest;
+    ContentDigest k = digest;
+    k.lo ^= salt;
+    k.hi ^= xxh64(&salt, sizeof(salt), digest.hi);
+    return k;
+}
+
+// Desc: log a file allowed although a limit kept part of its content from the matchers
+// In: int log_fd, const char* what, const std::string& path
+// Out: void
+static void log_partial(int log_fd, const char* what, const std::string& path) {
+    std::time_t now = std::time(nullptr);
+    char* dt = std::ctime(&now);
+    if (dt) dt[strlen(dt)-1] = '\0'; // remove \n
+    std::string line = "[" + std::string(dt ? dt : "") + "] [FileScanner] " + what +
+                       " only partly scanned (limit reached), allowed on the scanned part: " + path + "\n";
+    ssize_t _wr = ::write(log_fd, line.c_str(), line.size());
+    (void)_wr;
+}
+
+// Desc: match an in-memory PDF or office document part by part (first hit stops)
+// In: FileKind kind, std::string_view raw, const std::string& path, const ScanEnv& env, std::string* matched_ids
+// Out: int (0 = ALLOW, 1 = BLOCK)
+static int match_document(FileKind kind, std::string_view raw, const std::string& path, const ScanEnv& env,
+                          std::string* matched_ids) {
+    const std::string type = FileClassifier::name(kind);
+    int decision = 0;
+    bool limited = false;
+    if (env.extractors) {
+        // parsed in a helper process: a parser crash or hang costs the helper, not the daemon
+        const int parts = env.extractors->extract(kind, raw, env.pdf, [&](std::string_view part) {
+            decision = match_text({part}, type, path, env, false, matched_ids);
+            return decision == 0;
+        }, &limited);
+        if (parts > 0) {
+            if (limited && decision == 0) log_partial(env.log_fd, "office document", path);
+            return decision;
+        }
+        // no text, unparsable, or the document killed its helper: never retry it in process
+        if (parts != -3) return match_text({raw}, type, path, env, false, matched_ids);
+        // -3: no helper available, parse here
+    }
+    if (kind == FileKind::Pdf) {
+        // pages are matched as they are extracted (possibly on several page workers)
+        std::mutex mu;
+        const int pages = ContentParser::extract_pdf_pages(raw, env.log_fd, env.pdf,
+            [&](int, std::string_view page) {
+                std::string id;
+                if (match_text({page}, type, path, env, false, matched_ids ? &id : nullptr) == 0) return true;
+                std::lock_guard<std::mutex> lk(mu);
+                if (decision == 0) {
+                    decision = 1;
+                    if (matched_ids) *matched_ids = std::move(id);
+                }
+                return false;
+            });
+        if (pages <= 0) decision = match_text({raw}, type, path, env, false, matched_ids);
+        return decision;
+    }
+    // office parts are matched as they are inflated; a hit skips the remaining parts
+    const bool office = ContentParser::extract_office_parts(raw, env.log_fd, [&](std::string_view part) {
+        decision = match_text({part}, type, path, env, false, matched_ids);
+        return decision == 0;
+    }, &limited);
+    if (!office) decision = match_text({raw}, type, path, env, false, matched_ids);
+    else if (limited && decision == 0) log_partial(env.log_fd, "office document", path);
+    return decision;
+}
+
+// Desc: stream a compressed file or archive through the matchers without reading it into memory
+// In: int fd, size_t fsz, FileKind kind, const std::string& path, const ScanEnv& env, std::string* matched_ids
+// Out: int (0 = ALLOW, 1 = BLOCK, -1 = not decodable: scan the raw bytes instead)
+static int scan_archive(int fd, size_t fsz, FileKind kind, const std::string& path, const ScanEnv& env,
+                        std::string* matched_ids) {
+    int decision = 0;
+    ArchiveDecoder::Sink sink;
+    sink.text = [&](const std::string&, FileKind k, std::string_view bytes) {
+        decision = match_text({bytes}, FileClassifier::name(k), path, env, false, matched_ids);
+        return decision == 0;
+    };
+    sink.document = [&](const std::string&, FileKind k, std::string_view bytes) {
+        decision = match_document(k, bytes, path, env, matched_ids);
+        return decision == 0;
+    };
+    const ArchiveDecoder::Result r =
+        ContentParser::extract_archive(fd, fsz, kind, *env.archives, env.types, env.log_fd, sink);
+    if (decision != 0) return decision;
+    if (r == ArchiveDecoder::Result::Error) return -1;
+    if (r == ArchiveDecoder::Result::Limit) log_partial(env.log_fd, "archive", path);
+    return decision;
+}
+
+// Desc: match a file in fixed-size chunks (each carrying the previous chunk's tail) when the
+//       memory budget has no room for all of it; no content-hash tier (that needs every byte)
+// In: int fd, size_t len, const std::string& type, const std::string& path, const ScanEnv& env,
+//     ScanContext& ctx, std::string* matched_ids
+// Out: int (0 = ALLOW, 1 = BLOCK, -1 = read failure)
+static int scan_streamed(int fd, size_t len, const std::string& type, const std::string& path,
+                         const ScanEnv& env, ScanContext& ctx, std::string* matched_ids) {
+    char* buf = ctx.file().reserve(kStreamChunk + kStreamOverlap, ctx.huge_pages());
+    if (!buf) return -1;
+    size_t off = 0, carry = 0;
+    while (off < len) {
+        const size_t n = std::min(kStreamChunk, len - off);
+        if (!read_into(fd, buf + carry, n, off)) return -1;
+        if (match_text({std::string_view(buf, carry + n)}, type, path, env, false, matched_ids)) return 1;
+        off += n;
+        const size_t keep = std::min(kStreamOverlap, carry + n);
+        std::memmove(buf, buf + carry + n - keep, keep);
+        carry = keep;
+    }
+    return 0;
+}
+
+// Desc: can a part of a file (an appended suffix, a dirty chunk range) be matched on its
+//       own? Not if a pattern depends on buffer edges, word boundaries included (see
+//       PatternMatcherHS::batchable): it would see the part's edges as file edges
+// In: const ScanEnv& env
+// Out: bool
+static bool suffix_scannable(const ScanEnv& env) {
+    if (!env.matcher || !env.matcher->batchable()) return false;
+    if (env.dict && !env.dict->batchable()) return false;
+    if (env.scoped) {
+        for (const auto& sm : *env.scoped) if (!sm.matcher.batchable()) return false;
+    }
+    return true;
+}
+
+// Desc: does every match fit in `window` bytes? A part matched with that much context
+//       around it then sees every match touching it; longer or unbounded patterns could
+//       start in bytes that are not rescanned
+// In: const ScanEnv& env, size_t window
+// Out: bool
+static bool fits_window(const ScanEnv& env, size_t window) {
+    if (!env.matcher || env.matcher->maxWidth() > window) return false;
+    if (env.dict && env.dict->maxWidth() > window) return false;
+    if (env.scoped) {
+        for (const auto& sm : *env.scoped) if (sm.matcher.maxWidth() > window) return false;
+    }
+    return true;
+}
+
+// Desc: a text file that grew since its clean scan: match only the appended bytes plus the
+//       last window of the old length (matches spanning the old end), if the bytes scanned
+//       before are unchanged. Expects the file's head in the context's file buffer.
+// In: int fd, size_t fsz, const struct stat& st, const std::string& path, const ScanEnv& env,
+//     ScanContext& ctx, std::string* matched_ids
+// Out: int (0 = ALLOW, 1 = BLOCK, -1 = not an append of a recorded scan: scan it all)
+static int scan_appended(int fd, size_t fsz, const struct stat& st, const std::string& path,
+                         const ScanEnv& env, ScanContext& ctx, std::string* matched_ids) {
+    const size_t W = AppendIndex::kWindow;
+    AppendIndex::Entry e;
+    if (!env.appends->lookup(st.st_dev, st.st_ino, env.ruleset_version, e) || e.length >= fsz || e.length < 2 * W) {
+        return -1;
+    }
+    if (AppendIndex::hash(ctx.file().data(), W) != e.head_hash) return -1; // cheap early reject
+
+    // the whole file is read to checksum the old prefix: an edit anywhere in it means a rescan
+    ByteBudget::Grant grant;
+    if (env.budget && fsz > kStreamChunk && !env.budget->try_acquire(fsz, grant)) return -1;
+    char* buf = ctx.file().reserve(fsz, ctx.huge_pages());
+    if (!buf || !read_into(fd, buf, fsz)) return -1;
+    if (AppendIndex::hash(buf, e.length) != e.prefix_hash) return -1; // rewritten, not appended
+
+    const size_t from = static_cast<size_t>(e.length) - W;
+    const int decision = match_text({std::string_view(buf + from, fsz - from)}, "text", path, env, false,
+                                    matched_ids);
+    if (decision == 0) {
+        e.length      = fsz;
+        e.prefix_hash = AppendIndex::hash(buf, fsz);
+        env.appends->record(st.st_dev, st.st_ino, e);
+    } else {
+        env.appends->forget(st.st_dev, st.st_ino);
+    }
+    #ifdef DEBUG
+    std::cout << "[append] resumed at " << from << " of " << fsz << ": " << path << std::endl;
+    #endif
+    return decision;
+}
+
+// Desc: run the full content pipeline for one file
+// In: int fd, size_t fsz, const std::string& path, const ScanEnv& env, std::string* matched_ids
+// Out: int (0 = ALLOW, 1 = BLOCK, -1 = read failure)
+int scan_file_contents(int fd, size_t fsz, const std::string& path, const ScanEnv& env,
+                       std::string* matched_ids) {
+    // without a worker context the buffers live for this scan only
+    ScanContext local;
+    ScanContext& ctx = env.ctx ? *env.ctx : local;
+    FileKind kind = FileKind::Text;
+    size_t len = fsz;
+    const int rd = read_head(fd, fsz, env, ctx, kind, len);
+    if (rd <= 0) {
+        #ifdef DEBUG
+        if (rd == 0) std::cout << "[types] skipped " << FileClassifier::name(kind) << ": " << path << std::endl;
+        #endif
+        return rd;
+    }
+    // containers are decoded straight from the fd (no content-hash tier: that needs every byte)
+    if (env.archives && env.archives->enabled && len == fsz && ArchiveDecoder::isContainer(kind)) {
+        const int d = scan_archive(fd, fsz, kind, path, env, matched_ids);
+        if (d >= 0) return d;
+    }
+    // files rescanned in parts (appends, chunks) are identified by dev/ino
+    struct stat st{};
+    const bool partial = (env.appends || env.chunks) && len == fsz && suffix_scannable(env) &&
+                         ::fstat(fd, &st) == 0;
+    // append-only growth of a text file scanned clean before: only the new bytes are matched
+    const bool appendable = partial && env.appends && kind == FileKind::Text &&
+                            fsz >= env.appends->min_file_bytes() && fits_window(env, AppendIndex::kWindow);
+    if (appendable) {
+        const int d = scan_appended(fd, fsz, st, path, env, ctx, matched_ids);
+        if (d >= 0) return d;
+        // the attempt may have reused the buffer: put the head back
+        if (!read_into(fd, ctx.file().data(), std::min(fsz, FileClassifier::kHeadBytes))) return -1;
+    }
+    // admission: the bytes held for this file are charged to the shared budget. Without
+    // room, text-like kinds are matched chunk by chunk; documents need every byte and wait.
+    const bool document = kind == FileKind::Pdf || kind == FileKind::Office || kind == FileKind::Zip;
+    ByteBudget::Grant grant;
+    if (env.budget && len > kStreamChunk && !env.budget->try_acquire(len, grant)) {
+        if (!document) {
+            env.budget->count_streamed();
+            return scan_streamed(fd, len, FileClassifier::name(kind), path, env, ctx, matched_ids);
+        }
+        env.budget->acquire(len, grant);
+    }
+    // head-only policy: the rest of the file is never read
+    const size_t head = std::min(fsz, FileClassifier::kHeadBytes);
+    char* buf = ctx.file().reserve(std::max<size_t>(len, 1), ctx.huge_pages());
+    if (!buf) return -1;
+    if (len > head && !read_into(fd, buf + head, len - head, head)) return -1;
+    fsz = len;
+
+    // identical content already decided under this ruleset (and scopes) => skip extraction and matching
+    const std::string type = FileClassifier::name(kind);
+    ContentDigest digest;
+    if (env.dedup) {
+        digest = dedup_key(env.dedup->digest(buf, len), type, path, env);
+        int d = 0;
+        if (env.dedup->get(digest, fsz, env.ruleset_version, d)) {
+            #ifdef DEBUG
+            std::cout << "[dedup] content hit: " << path << " decision=" << d << std::endl;
+            #endif
+            return d;
+        }
+    }
+
+    const std::string_view raw(buf, len);
+    if (document) {
+        const int decision = match_document(kind, raw, path, env, matched_ids);
+        if (env.dedup) env.dedup->put(digest, fsz, env.ruleset_version, decision);
+        return decision;
+    }
+    // large file edited in place since its clean scan: match only the chunks that changed
+    std::vector<ChunkIndex::Chunk> chunks;
+    const bool chunkable = partial && env.chunks && len >= env.chunks->min_file_bytes() &&
+                           fits_window(env, ChunkIndex::kWindow);
+    if (chunkable) {
+        ChunkIndex::split(buf, len, chunks);
+        std::vector<ChunkIndex::Range> dirty;
+        if (env.chunks->dirty_ranges(st.st_dev, st.st_ino, env.ruleset_version, chunks, len, dirty)) {
+            size_t dirty_bytes = 0;
+            for (const auto& r : dirty) dirty_bytes += r.second - r.first;
+            // most of the file changed: one pass over all of it is cheaper
+            if (dirty_bytes <= len / 2) {
+                int decision = 0;
+                for (const auto& r : dirty) {
+                    const std::string_view part(buf + r.first, r.second - r.first);
+                    if (match_text({part}, type, path, env, false, matched_ids)) { decision = 1; break; }
+                }
+                #ifdef DEBUG
+                std::cout << "[chunks] rescanned " << dirty_bytes << " of " << len << " bytes: " << path << std::endl;
+                #endif
+                if (decision == 0) env.chunks->record(st.st_dev, st.st_ino, env.ruleset_version, chunks);
+                else env.chunks->forget(st.st_dev, st.st_ino);
+                if (env.dedup) env.dedup->put(digest, fsz, env.ruleset_version, decision);
+                return decision;
+            }
+        }
+    }
+    // segments point into the file buffer or into extracted pages: no whole-file string copies
+    ExtractedText text;
+    ContentParser::extract(type, raw, env.log_fd, text);
+
+    const int decision = match_text(text.segments, type, path, env, false, matched_ids);
+    if (env.dedup) env.dedup->put(digest, fsz, env.ruleset_version, decision);
+    if (chunkable) {
+        if (decision == 0) env.chunks->record(st.st_dev, st.st_ino, env.ruleset_version, chunks);
+        else env.chunks->forget(st.st_dev, st.st_ino);
+    }
+    if (appendable && decision == 0) {
+        const size_t W = AppendIndex::kWindow;
+        AppendIndex::Entry e;
+        e.ruleset_version = env.ruleset_version;
+        e.length          = len;
+        e.head_hash       = AppendIndex::hash(buf, W);
+        e.prefix_hash     = AppendIndex::hash(buf, len);
+        env.appends->record(st.st_dev, st.st_ino, e);
+    }
+    return decision;
+}
+
+// Desc: batched miss path for small files (see header)
+// In: std::vector<SmallFile>& files, const ScanEnv& env
+// Out: void (verdict/matched_id filled per file)
+void scan_small_files(std::vector<SmallFile>& files, const ScanEnv& env) {
+    static const char kSep = '\n'; // non-word byte between files keeps \b semantics per file
+    size_t total = 0;
+    for (const auto& f : files) total += f.size;
+
+    ScanContext local;
+    ScanContext& ctx = env.ctx ? *env.ctx : local;
+    char* arena = ctx.batch().reserve(std::max<size_t>(total, 1), ctx.huge_pages());
+    if (!arena) {
+        for (auto& f : files) f.verdict = scan_file_contents(f.fd, f.size, f.path, env, &f.matched_id);
+        return;
+    }
+    std::vector<size_t> at(files.size());
+    std::vector<ContentDigest> digests(files.size());
+    std::vector<size_t> text;     // files scanned straight from the arena
+    size_t off = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        SmallFile& f = files[i];
+        at[i] = off;
+        off += f.size;
+        f.verdict = -1;
+        if (!read_into(f.fd, arena + at[i], f.size)) continue;
+        const std::string_view head(arena + at[i], std::min(f.size, FileClassifier::kHeadBytes));
+        const FileKind kind = FileClassifier::classify(head).kind;
+        if (env.dedup) {
+            digests[i] = dedup_key(env.dedup->digest(arena + at[i], f.size), FileClassifier::name(kind), f.path, env);
+            int d = 0;
+            if (env.dedup->get(digests[i], f.size, env.ruleset_version, d)) { f.verdict = d; continue; }
+        }
+        if (kind != FileKind::Text || (env.types && env.types->of(kind) != TypePolicy::Scan)) {
+            f.verdict = scan_file_contents(f.fd, f.size, f.path, env, &f.matched_id);
+            continue;
+        }
+        text.push_back(i);
+    }
+
+    // one pass of the unscoped patterns over all text files; a match is attributed to
+    // the file its end falls in (it may have started in an earlier file: confirmed below)
+    std::vector<char> flagged(files.size(), 0);
+    const bool batched = env.matcher && text.size() > 1 && env.matcher->batchable();
+    if (batched) {
+        std::vector<std::string_view> segs;
+        std::vector<unsigned long long> ends;
+        segs.reserve(text.size() * 2);
+        ends.reserve(text.size());
+        unsigned long long pos = 0;
+        for (size_t i : text) {
+            segs.emplace_back(arena + at[i], files[i].size);
+            segs.emplace_back(&kSep, 1);
+            pos += files[i].size;
+            ends.push_back(pos);
+            pos += 1;
+        }
+        const bool ok = env.matcher->forEachMatch(segs, [&](unsigned, unsigned long long end) {
+            const size_t k = static_cast<size_t>(std::lower_bound(ends.begin(), ends.end(), end) - ends.begin());
+            if (k < text.size()) flagged[text[k]] = 1;
+            return true;
+        });
+        if (!ok) for (size_t i : text) flagged[i] = 1; // scan error: check every file alone
+    }
+
+    for (size_t i : text) {
+        SmallFile& f = files[i];
+        const std::vector<std::string_view> segs{std::string_view(arena + at[i], f.size)};
+        f.verdict = match_text(segs, "text", f.path, env, batched && !flagged[i], &f.matched_id);
+        if (env.dedup) env.dedup->put(digests[i], f.size, env.ruleset_version, f.verdict);
+    }
+}
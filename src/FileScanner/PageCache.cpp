@@ -0,0 +1,114 @@
+// === src/FileScanner/PageCache.cpp ===
+#include "PageCache.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// cachestat(2) (Linux 6.5); the number is shared by all architectures
+static const long kSysCachestat = 451;
+
+struct CachestatRange { std::uint64_t off, len; };
+struct Cachestat {
+    std::uint64_t nr_cache, nr_dirty, nr_writeback, nr_evicted, nr_recently_evicted;
+};
+
+// Desc: bytes per page
+// In: (none)
+// Out: size_t
+static size_t page_size() {
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return page;
+}
+
+// Desc: resident pages of the file via cachestat
+// In: int fd, size_t fsz, uint64_t& cached
+// Out: bool (false if the kernel has no cachestat)
+static bool cachestat_pages(int fd, size_t fsz, std::uint64_t& cached) {
+    CachestatRange range{0, fsz};
+    Cachestat cs{};
+    if (::syscall(kSysCachestat, fd, &range, &cs, 0) != 0) return false;
+    cached = cs.nr_cache;
+    return true;
+}
+
+// Desc: per-page residency of the file via mmap + mincore (mapping faults nothing in)
+// In: int fd, size_t fsz, std::vector<unsigned char>& out (1 = resident)
+// Out: bool
+static bool mincore_pages(int fd, size_t fsz, std::vector<unsigned char>& out) {
+    void* map = ::mmap(nullptr, fsz, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) return false;
+    out.assign((fsz + page_size() - 1) / page_size(), 0);
+    const bool ok = ::mincore(map, fsz, out.data()) == 0;
+    ::munmap(map, fsz);
+    if (!ok) return false;
+    for (auto& b : out) b &= 1;
+    return true;
+}
+
+// Desc: whether process pid still has the file (dev, ino) open; stat() on its fd links
+//       opens nothing, so no fanotify event is raised
+// In: pid_t pid, dev_t dev, ino_t ino
+// Out: bool
+static bool process_has_open(pid_t pid, dev_t dev, ino_t ino) {
+    char dir_path[64];
+    snprintf(dir_path, sizeof(dir_path), "/proc/%d/fd", static_cast<int>(pid));
+    DIR* d = ::opendir(dir_path);
+    if (!d) return false;
+    bool found = false;
+    while (struct dirent* ent = ::readdir(d)) {
+        if (ent->d_name[0] == '.') continue;
+        // relative to the directory: no path is built, so nothing can be truncated
+        struct stat st{};
+        if (::fstatat(::dirfd(d), ent->d_name, &st, 0) == 0 && st.st_dev == dev && st.st_ino == ino) {
+            found = true;
+            break;
+        }
+    }
+    ::closedir(d);
+    return found;
+}
+
+PageCache::ScanGuard::ScanGuard(int fd, size_t fsz, const PageCacheOptions& opt, pid_t opener) {
+    if (!opt.enabled || fd < 0 || fsz < opt.min_file_bytes) return;
+    std::uint64_t cached = 0;
+    if (cachestat_pages(fd, fsz, cached)) {
+        const std::uint64_t pages = (fsz + page_size() - 1) / page_size();
+        if (cached >= pages) return;          // the user's data: leave it cached
+        all_cold_ = cached == 0;
+    }
+    if (!all_cold_ && !mincore_pages(fd, fsz, resident_)) return;
+    fd_     = fd;
+    fsz_    = fsz;
+    opener_ = opener;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+PageCache::ScanGuard::~ScanGuard() {
+    if (fd_ < 0) return;
+    struct stat st{};
+    if (opener_ > 0 && ::fstat(fd_, &st) == 0 && process_has_open(opener_, st.st_dev, st.st_ino)) {
+        // the opener is still reading: what came in during the scan may be its data
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_NORMAL);
+        return;
+    }
+    if (all_cold_) {
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+        return;
+    }
+    // drop runs of pages that were not resident before the scan
+    const size_t page = page_size();
+    size_t i = 0;
+    while (i < resident_.size()) {
+        if (resident_[i]) { ++i; continue; }
+        size_t j = i;
+        while (j < resident_.size() && !resident_[j]) ++j;
+        ::posix_fadvise(fd_, static_cast<off_t>(i * page), static_cast<off_t>((j - i) * page), POSIX_FADV_DONTNEED);
+        i = j;
+    }
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_NORMAL);
+}
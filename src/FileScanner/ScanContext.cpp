@@ -0,0 +1,79 @@
+// === src/FileScanner/ScanContext.cpp ===
+#include "ScanContext.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const size_t kHugePage = 2u << 20;
+
+// Desc: round n up to whole pages (whole huge pages when they are requested)
+// In: size_t n, bool huge_pages
+// Out: size_t
+static size_t round_up(size_t n, bool huge_pages) {
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t unit = huge_pages && n >= kHugePage ? kHugePage : page;
+    return (n + unit - 1) / unit * unit;
+}
+
+ScanBuffer::~ScanBuffer() { release(); }
+
+// Desc: grow the mapping to at least n bytes, keeping its contents
+// In: size_t n, bool huge_pages
+// Out: char* (nullptr on failure; the old mapping is left intact)
+char* ScanBuffer::reserve(size_t n, bool huge_pages) {
+    if (n <= cap_) return p_;
+    const size_t cap = round_up(n, huge_pages);
+    void* p = p_ ? ::mremap(p_, cap_, cap, MREMAP_MAYMOVE)
+                 : ::mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+    if (huge_pages && cap >= kHugePage) ::madvise(p, cap, MADV_HUGEPAGE);
+#endif
+    p_   = static_cast<char*>(p);
+    cap_ = cap;
+    return p_;
+}
+
+// Desc: unmap the buffer
+// In: (none)
+// Out: void
+void ScanBuffer::release() {
+    if (p_) ::munmap(p_, cap_);
+    p_   = nullptr;
+    cap_ = 0;
+}
+
+ScanContext::ScanContext(const ScanContextOptions& opt) : opt_(opt) {}
+
+// Desc: unmap buffers so that at most memory_ceiling_mb stay mapped (the larger goes first)
+// In: (none)
+// Out: void
+void ScanContext::trim() {
+    const size_t ceiling = static_cast<size_t>(opt_.memory_ceiling_mb) << 20;
+    while (retained_bytes() > ceiling) {
+        ScanBuffer& big = file_.capacity() >= batch_.capacity() ? file_ : batch_;
+        big.release();
+    }
+}
+
+ScanContextPool::Lease::~Lease() {
+    PatternMatcherHS::bindScratch(nullptr);
+    ctx_->trim();
+    std::lock_guard<std::mutex> lk(pool_.mu_);
+    pool_.idle_.push_back(std::move(ctx_));
+}
+
+// Desc: lease an idle context, or a new one if all are in use
+// In: (none)
+// Out: Lease
+ScanContextPool::Lease ScanContextPool::acquire() {
+    std::unique_ptr<ScanContext> ctx;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!idle_.empty()) {
+            ctx = std::move(idle_.back());
+            idle_.pop_back();
+        }
+    }
+    if (!ctx) ctx.reset(new ScanContext(opt_));
+    return Lease(*this, std::move(ctx));
+}
@@ -5,6 +5,12 @@
 #include <fcntl.h>
 #include <cstring>
 #include <ctime>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 
 
 // Cerate tables query
@@ -19,11 +25,26 @@ CREATE TABLE IF NOT EXISTS cache_entries (
   decision        INTEGER NOT NULL,
   last_access_ts  INTEGER NOT NULL DEFAULT (strftime('%s','now')),
   hit_count       INTEGER NOT NULL DEFAULT 0,
+  matched_ids     TEXT    NOT NULL DEFAULT '',
   PRIMARY KEY (dev, ino)
 );
 
 CREATE INDEX IF NOT EXISTS idx_cache_version ON cache_entries(ruleset_version);
 
+CREATE TABLE IF NOT EXISTS content_hashes (
+  hash_lo         INTEGER NOT NULL,
+  hash_hi         INTEGER NOT NULL,
+  size            INTEGER NOT NULL,
+  ruleset_version INTEGER NOT NULL,
+  decision        INTEGER NOT NULL,
+  last_access_ts  INTEGER NOT NULL DEFAULT (strftime('%s','now')),
+  hit_count       INTEGER NOT NULL DEFAULT 0,
+  PRIMARY KEY (hash_lo, hash_hi, size)
+);
+
+CREATE INDEX IF NOT EXISTS idx_content_version ON content_hashes(ruleset_version);
+CREATE INDEX IF NOT EXISTS idx_content_access ON content_hashes(last_access_ts);
+
 CREATE TABLE IF NOT EXISTS meta (
   key   TEXT PRIMARY KEY,
   value TEXT NOT NULL
@@ -139,6 +160,24 @@ bool Requirements::validateConfig(const ConfigManager& cfg, StartupResult& out)
     return true;
 }
 
+// Desc: add a column to an existing table if it is missing (schema upgrade)
+// In: sqlite3* db, const char* table, const char* column, const char* decl
+// Out: bool (true if present or added)
+static bool ensure_column(sqlite3* db, const char* table, const char* column, const char* decl) {
+    const std::string info = std::string("PRAGMA table_info(") + table + ");";
+    sqlite3_stmt* st = nullptr;
+    if (sqlite3_prepare_v2(db, info.c_str(), -1, &st, nullptr) != SQLITE_OK) return false;
+    bool found = false;
+    while (sqlite3_step(st) == SQLITE_ROW) {
+        const unsigned char* name = sqlite3_column_text(st, 1);
+        if (name && std::strcmp((const char*)name, column) == 0) { found = true; break; }
+    }
+    sqlite3_finalize(st);
+    if (found) return true;
+    const std::string alter = std::string("ALTER TABLE ") + table + " ADD COLUMN " + column + " " + decl + ";";
+    return sqlite3_exec(db, alter.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
 // Desc: open/init SQLite cache DB and apply schema
 // In: const std::string& db_path, StartupResult& out
 // Out: bool (true on success)
@@ -169,6 +208,11 @@ bool Requirements::initCacheDb(const std::string& db_path, StartupResult& out) {
         if (err) sqlite3_free(err);
         return false;
     }
+    if (!ensure_column(out.db.get(), "cache_entries", "matched_ids", "TEXT NOT NULL DEFAULT ''")) {
+        out.error = "[cache] schema upgrade failed (cache_entries.matched_ids)";
+        out.logs.push_back(out.error);
+        return false;
+    }
     out.logs.push_back("[cache] schema ok (tables/indexes)");
     return true;
 }
@@ -188,27 +232,197 @@ bool Requirements::initRulesetVersion(StartupResult& out) {
 }
 
 
-// Desc: delete cache entries with outdated ruleset_version
-// In: sqlite3* db
-// Out: void
-static void invalidate_to_meta_ruleset(sqlite3* db) {
-    if (!db) return;
-    char* err = nullptr;
-    sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, &err);
+// Background runs (one per reload) take turns on g_invalidation_mu; a run started for an
+// older reload stops at its next batch once a newer one was requested, so it never deletes
+// or moves rows of the version the engine writes now.
+static std::mutex                 g_invalidation_mu;
+static std::atomic<std::uint64_t> g_invalidation_gen{0};
 
-    const char* del_sql =
-        "DELETE FROM cache_entries "
-        "WHERE ruleset_version <> ("
-        "  SELECT CAST(value AS INTEGER) "
-        "  FROM meta WHERE key='ruleset_version' LIMIT 1"
+// Desc: has a newer background run been requested since this one started?
+// In: std::uint64_t gen (the run's generation)
+// Out: bool
+static bool superseded(std::uint64_t gen) {
+    return g_invalidation_gen.load(std::memory_order_acquire) != gen;
+}
+
+// Desc: step a batched UPDATE/DELETE (rowid IN (... LIMIT n)) until it stops changing rows
+//       or the run is superseded
+// In: sqlite3* db, sqlite3_stmt* st (prepared and bound; finalized here), std::uint64_t gen
+// Out: long long (rows changed)
+static long long run_batched(sqlite3* db, sqlite3_stmt* st, std::uint64_t gen) {
+    long long total = 0;
+    for (;;) {
+        if (superseded(gen) || sqlite3_step(st) != SQLITE_DONE) break;
+        const int n = sqlite3_changes(db);
+        (void)sqlite3_reset(st);
+        total += n;
+        if (n == 0) break;
+        // short write transactions; let the engine's own cache writes in between
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    (void)sqlite3_finalize(st);
+    return total;
+}
+
+// Desc: delete rows of a decision table with outdated ruleset_version in small batches
+// In: sqlite3* db, const char* table, std::uint64_t ruleset_version, std::uint64_t keep_version (0 = none),
+//     std::uint64_t gen
+// Out: long long (rows deleted)
+static long long invalidate_to_meta_ruleset(sqlite3* db, const char* table, std::uint64_t ruleset_version,
+                                            std::uint64_t keep_version, std::uint64_t gen) {
+    if (!db) return 0;
+    const std::string del_sql =
+        std::string("DELETE FROM ") + table + " WHERE rowid IN ("
+        "  SELECT rowid FROM " + table +
+        "  WHERE (ruleset_version < ?1 OR ruleset_version > ?1) AND ruleset_version <> ?3 "
+        "  LIMIT ?2"
         ");";
 
     sqlite3_stmt* st = nullptr;
-    if (sqlite3_prepare_v2(db, del_sql, -1, &st, nullptr) == SQLITE_OK) {
-        (void)sqlite3_step(st);
-        (void)sqlite3_finalize(st);
+    if (sqlite3_prepare_v2(db, del_sql.c_str(), -1, &st, nullptr) != SQLITE_OK) return 0;
+    sqlite3_bind_int64(st, 1, static_cast<long long>(ruleset_version));
+    sqlite3_bind_int(st, 2, 2000);
+    sqlite3_bind_int64(st, 3, static_cast<long long>(keep_version));
+    return run_batched(db, st, gen);
+}
+
+// Desc: drop removed pattern ids from a comma-separated id list
+// In: const std::string& ids, const std::unordered_set<std::string>& removed
+// Out: std::string (remaining ids)
+static std::string strip_removed_ids(const std::string& ids, const std::unordered_set<std::string>& removed) {
+    std::string kept;
+    size_t start = 0;
+    while (start < ids.size()) {
+        size_t end = ids.find(',', start);
+        if (end == std::string::npos) end = ids.size();
+        const std::string id = ids.substr(start, end - start);
+        if (!id.empty() && !removed.count(id)) {
+            if (!kept.empty()) kept += ',';
+            kept += id;
+        }
+        start = end + 1;
+    }
+    return kept;
+}
+
+// Desc: carry decisions of the previous ruleset over after a patterns-only change.
+//       BLOCK rows survive if one of their matched patterns still exists; ALLOW rows
+//       survive if nothing was added (otherwise they stay on prev_version and are
+//       rescanned lazily against the added patterns only). Stops when superseded or
+//       when a batch cannot be committed.
+// In: sqlite3* db, std::uint64_t new_ver, const RulesetDelta& delta, std::uint64_t gen
+// Out: long long (rows migrated)
+static long long migrate_to_ruleset(sqlite3* db, std::uint64_t new_ver, const RulesetDelta& delta,
+                                    std::uint64_t gen) {
+    if (!db || !delta.active) return 0;
+    long long migrated = 0;
+    const std::unordered_set<std::string> removed(delta.removed_ids.begin(), delta.removed_ids.end());
+
+    // ALLOW rows: removing patterns can never turn them into a BLOCK
+    if (delta.added_ids.empty()) {
+        const char* tables[] = {"cache_entries", "content_hashes"};
+        for (const char* table : tables) {
+            const std::string sql =
+                std::string("UPDATE ") + table + " SET ruleset_version=?1 WHERE rowid IN ("
+                "  SELECT rowid FROM " + table + " WHERE ruleset_version=?2 AND decision=0 LIMIT ?3);";
+            sqlite3_stmt* st = nullptr;
+            if (sqlite3_prepare_v2(db, sql.c_str(), -1, &st, nullptr) != SQLITE_OK) continue;
+            sqlite3_bind_int64(st, 1, static_cast<long long>(new_ver));
+            sqlite3_bind_int64(st, 2, static_cast<long long>(delta.prev_version));
+            sqlite3_bind_int(st, 3, 2000);
+            migrated += run_batched(db, st, gen);
+        }
     }
-    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &err);
+
+    // BLOCK rows (cache_entries only; content_hashes carry no pattern ids)
+    sqlite3_stmt* sel = nullptr;
+    sqlite3_stmt* upd = nullptr;
+    if (sqlite3_prepare_v2(db,
+            "SELECT rowid, matched_ids FROM cache_entries "
+            "WHERE ruleset_version=?1 AND decision=1 AND rowid>?2 ORDER BY rowid LIMIT 1000;",
+            -1, &sel, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db,
+            "UPDATE cache_entries SET ruleset_version=?1, matched_ids=?2 WHERE rowid=?3;",
+            -1, &upd, nullptr) != SQLITE_OK) {
+        if (sel) sqlite3_finalize(sel);
+        if (upd) sqlite3_finalize(upd);
+        return migrated;
+    }
+
+    long long last_rowid = 0;
+    while (!superseded(gen)) {
+        std::vector<std::pair<long long, std::string>> keep;
+        size_t scanned = 0;
+        sqlite3_bind_int64(sel, 1, static_cast<long long>(delta.prev_version));
+        sqlite3_bind_int64(sel, 2, last_rowid);
+        while (sqlite3_step(sel) == SQLITE_ROW) {
+            ++scanned;
+            last_rowid = sqlite3_column_int64(sel, 0);
+            const unsigned char* t = sqlite3_column_text(sel, 1);
+            std::string kept = strip_removed_ids(t ? (const char*)t : "", removed);
+            if (!kept.empty()) keep.emplace_back(last_rowid, std::move(kept));
+        }
+        (void)sqlite3_reset(sel);
+        if (scanned == 0) break;
+
+        // a batch that cannot be written stays on prev_version (rescanned or deleted later)
+        if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) break;
+        long long done = 0;
+        for (const auto& r : keep) {
+            sqlite3_bind_int64(upd, 1, static_cast<long long>(new_ver));
+            sqlite3_bind_text(upd, 2, r.second.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(upd, 3, r.first);
+            if (sqlite3_step(upd) == SQLITE_DONE) ++done;
+            (void)sqlite3_reset(upd);
+        }
+        if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            (void)sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            break;
+        }
+        migrated += done;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    sqlite3_finalize(sel);
+    sqlite3_finalize(upd);
+    return migrated;
+}
+
+
+// Desc: migrate still-valid rows, then delete stale rows on its own connection in a detached
+//       thread; runs are serialized and only the latest request runs to completion
+// In: const std::string& db_path, std::uint64_t ruleset_version, const RulesetDelta& delta
+// Out: void
+void Requirements::startBackgroundInvalidation(const std::string& db_path,
+                                               std::uint64_t ruleset_version,
+                                               const RulesetDelta& delta) {
+    const std::uint64_t gen = g_invalidation_gen.fetch_add(1, std::memory_order_acq_rel) + 1;
+    std::thread([db_path, ruleset_version, delta, gen]() {
+        std::lock_guard<std::mutex> lk(g_invalidation_mu);
+        if (superseded(gen)) {
+            fileLog("[cache] background invalidation for ruleset " + std::to_string(ruleset_version) +
+                    " skipped: superseded by a newer reload");
+            return;
+        }
+        sqlite3* db = nullptr;
+        if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+            fileLog("[cache] background invalidation: open failed");
+            if (db) sqlite3_close(db);
+            return;
+        }
+        sqlite3_busy_timeout(db, 5000);
+        const auto t0 = std::chrono::steady_clock::now();
+        const long long m = migrate_to_ruleset(db, ruleset_version, delta, gen);
+        // with added patterns, leftover prev_version rows are kept for lazy delta rescans
+        const std::uint64_t keep = (delta.active && !delta.added_ids.empty()) ? delta.prev_version : 0;
+        const long long n = invalidate_to_meta_ruleset(db, "cache_entries", ruleset_version, keep, gen)
+                          + invalidate_to_meta_ruleset(db, "content_hashes", ruleset_version, keep, gen);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - t0).count();
+        sqlite3_close(db);
+        fileLog(std::string("[cache] background invalidation ") + (superseded(gen) ? "stopped (superseded)" : "done") +
+                ": migrated=" + std::to_string(m) + " removed=" + std::to_string(n) +
+                " rows in " + std::to_string(ms) + " ms");
+    }).detach();
 }
 
 
@@ -246,7 +460,8 @@ StartupResult Requirements::run(const std::string& config_path,
         for (auto& l : res.logs) fileLog(l);
         return res;
     }
-    invalidate_to_meta_ruleset(res.db.get());
+    // stale-row invalidation is started by the engine in the background
+    res.db_path = db_path;
     // Ok
     res.ok = true;
     for (auto& l : res.logs) fileLog(l);
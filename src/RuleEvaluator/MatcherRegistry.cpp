@@ -0,0 +1,138 @@
+// === src/RuleEvaluator/MatcherRegistry.cpp ===
+#include "MatcherRegistry.hpp"
+#include "ConfigManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// Patterns of one scope, before compilation.
+struct ScopeGroup {
+    PatternScope             scope;
+    std::vector<std::string> pats;
+    std::vector<std::string> ids;
+};
+
+// Desc: split patterns into the unscoped list and one group per distinct scope
+// In: pats, ids, scopes (parallel), const std::vector<std::string>* only (nullptr = all, else keep these ids),
+//     std::vector<std::string>& flat_pats, std::vector<std::string>& flat_ids
+// Out: std::vector<ScopeGroup> (in first-seen order)
+static std::vector<ScopeGroup> split_by_scope(const std::vector<std::string>& pats,
+                                              const std::vector<std::string>& ids,
+                                              const std::vector<PatternScope>& scopes,
+                                              const std::vector<std::string>* only,
+                                              std::vector<std::string>& flat_pats,
+                                              std::vector<std::string>& flat_ids) {
+    std::vector<ScopeGroup> groups;
+    std::map<std::string, size_t> by_key;
+    for (size_t i = 0; i < pats.size(); ++i) {
+        if (only && std::find(only->begin(), only->end(), ids[i]) == only->end()) continue;
+        if (scopes[i].empty()) {
+            flat_pats.push_back(pats[i]);
+            flat_ids.push_back(ids[i]);
+            continue;
+        }
+        auto it = by_key.emplace(scopes[i].key(), groups.size()).first;
+        if (it->second == groups.size()) groups.push_back(ScopeGroup{scopes[i], {}, {}});
+        groups[it->second].pats.push_back(pats[i]);
+        groups[it->second].ids.push_back(ids[i]);
+    }
+    return groups;
+}
+
+// Desc: compile one database per scope group; a group identical to one in prev reuses it
+// In: std::vector<ScopeGroup>& groups, const std::vector<ScopedMatcher>* prev, std::vector<ScopedMatcher>& out
+// Out: bool (false if a compile fails)
+static bool build_scoped(std::vector<ScopeGroup>& groups, const std::vector<ScopedMatcher>* prev,
+                         std::vector<ScopedMatcher>& out) {
+    out.clear();
+    out.reserve(groups.size());
+    for (auto& g : groups) {
+        ScopedMatcher sm;
+        sm.scope       = g.scope;
+        sm.pattern_ids = g.ids;
+        const ScopedMatcher* same = nullptr;
+        if (prev) {
+            for (const auto& p : *prev) {
+                if (p.pattern_ids == g.ids && p.scope.key() == g.scope.key()) { same = &p; break; }
+            }
+        }
+        if (same) sm.matcher = same->matcher;
+        else if (!sm.matcher.buildFromPatterns(g.pats, g.ids)) return false;
+        out.push_back(std::move(sm));
+    }
+    return true;
+}
+
+// Desc: stamp the next generation on a set and make it the active one
+// In: std::shared_ptr<MatcherSet> set
+// Out: void
+void MatcherRegistry::publish(std::shared_ptr<MatcherSet> set) {
+    if (!set) return;
+    set->generation = gen_.load(std::memory_order_relaxed) + 1;
+    const uint64_t g = set->generation;
+    std::atomic_store(&cur_, std::shared_ptr<const MatcherSet>(std::move(set)));
+    gen_.store(g, std::memory_order_release);
+}
+
+// Desc: compile the unscoped patterns, one database per pattern scope and, for a
+//       patterns-only change, the added patterns. Given the previous set, its compiled
+//       tiers and unchanged scope databases are reused.
+// In: const ConfigManager& cfg, const std::string& cache_dir, const MatcherSet* prev, size_t max_tiers
+// Out: std::shared_ptr<MatcherSet> (nullptr if compilation fails)
+std::shared_ptr<MatcherSet> MatcherRegistry::build(const ConfigManager& cfg, const std::string& cache_dir,
+                                                   const MatcherSet* prev, size_t max_tiers) {
+    auto set = std::make_shared<MatcherSet>();
+    set->ruleset_version = cfg.getRulesetVersion();
+    set->patterns_hash   = cfg.patternsHash();
+    set->dict_ids        = cfg.dictionaryIds();
+    const std::vector<std::string> all_ids = cfg.patternIds();
+    std::vector<ScopeGroup> groups = split_by_scope(cfg.getPatternStrings(), all_ids, cfg.getPatternScopes(),
+                                                    nullptr, set->patterns, set->pattern_ids);
+
+    const bool tiered = prev && max_tiers > 1 &&
+                        set->full.buildIncremental(prev->full, set->patterns, set->pattern_ids, max_tiers);
+    if (tiered) {
+        std::cout << "[MatcherRegistry] delta tier added: tiers=" << set->full.tierCount()
+                  << " masked=" << set->full.maskedCount() << "\n";
+    } else if (!set->full.buildCached(set->patterns, set->pattern_ids, set->patterns_hash, cache_dir)) {
+        return nullptr;
+    }
+    if (!build_scoped(groups, prev ? &prev->scoped : nullptr, set->scoped)) return nullptr;
+    if (!set->scoped.empty()) {
+        std::cout << "[MatcherRegistry] scoped databases: " << set->scoped.size()
+                  << " (unscoped patterns=" << set->patterns.size() << ")\n";
+    }
+
+    if (prev && !set->dict_ids.empty() && prev->dict_ids == set->dict_ids) {
+        set->dict = prev->dict; // same dictionary contents: share the compiled database
+    } else if (!cfg.getDictionaries().empty()) {
+        auto c0 = std::chrono::steady_clock::now();
+        if (!set->dict.buildFromDictionaries(cfg.getDictionaries(), cfg.dictionaryIds(), cache_dir)) return nullptr;
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - c0).count();
+        std::cout << "[MatcherRegistry] dictionaries ready: files=" << cfg.getDictionaries().size()
+                  << " db_bytes=" << set->dict.databaseBytes() << " (" << ms << " ms)\n";
+    }
+
+    const RulesetDelta& delta = cfg.getRulesetDelta();
+    if (delta.active && !delta.added_ids.empty()) {
+        std::vector<std::string> add_pats, add_ids;
+        std::vector<ScopeGroup> add_groups = split_by_scope(cfg.getPatternStrings(), all_ids, cfg.getPatternScopes(),
+                                                            &delta.added_ids, add_pats, add_ids);
+        if (!set->delta.buildFromPatterns(add_pats, add_ids)) return nullptr;
+        if (!build_scoped(add_groups, nullptr, set->delta_scoped)) return nullptr;
+        set->has_delta          = true;
+        set->delta_base_version = delta.prev_version;
+    }
+    return set;
+}
+
+// Desc: fold the delta tiers of a set back into one database (same ruleset, new generation)
+// In: const MatcherSet& cur, const std::string& cache_dir
+// Out: std::shared_ptr<MatcherSet> (nullptr if compilation fails)
+std::shared_ptr<MatcherSet> MatcherRegistry::merge(const MatcherSet& cur, const std::string& cache_dir) {
+    auto set = std::make_shared<MatcherSet>(cur);
+    if (!set->full.buildCached(set->patterns, set->pattern_ids, set->patterns_hash, cache_dir)) return nullptr;
+    return set;
+}
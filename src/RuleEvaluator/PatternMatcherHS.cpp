@@ -1,27 +1,119 @@
 #include "PatternMatcherHS.hpp"
 #include "ConfigManager.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <unordered_set>
 
-thread_local hs_scratch_t* PatternMatcherHS::tls_scratch_ = nullptr;
+thread_local PatternMatcherHS::Scratch* PatternMatcherHS::tls_bound_ = nullptr;
+
+static std::atomic<uint64_t> g_scratch_gen{0};
+// hs_scan_vector lengths are unsigned int
+static const size_t kMaxSegment = 0xFFFFFFFFu;
+
+// Desc: fresh identity for a newly built database (never 0)
+// In: (none)
+// Out: uint64_t
+uint64_t PatternMatcherHS::nextScratchGen() {
+    return g_scratch_gen.fetch_add(1, std::memory_order_relaxed) + 1;
+}
 
 PatternMatcherHS::PatternMatcherHS() = default;
 
-PatternMatcherHS::~PatternMatcherHS() {
-    freeAll_();
+PatternMatcherHS::~PatternMatcherHS() = default;
+
+PatternMatcherHS::Scratch::~Scratch() {
+    if (s) hs_free_scratch(s);
+}
+
+// Desc: select the scratch the calling thread scans with (see header)
+// In: Scratch* s
+// Out: void
+void PatternMatcherHS::bindScratch(Scratch* s) {
+    tls_bound_ = s;
+}
+
+PatternMatcherHS::Tier::~Tier() {
+    if (db) hs_free_database(db);
 }
 
 void PatternMatcherHS::freeAll_() noexcept {
-    if (base_scratch_) { hs_free_scratch(base_scratch_); base_scratch_ = nullptr; }
-    if (db_)           { hs_free_database(db_);           db_           = nullptr; }
+    tiers_.clear();
+    offsets_.clear();
+    masked_.clear();
+    base_scratch_.reset();
     ready_ = false;
+    anchored_ = false;
+    max_width_ = 0;
     count_ = 0;
 }
 
-bool PatternMatcherHS::buildFromConfig(const ConfigManager& cfg) {
+// Desc: scratch prototype owned by a shared_ptr (freed with hs_free_scratch)
+// In: hs_scratch_t* s
+// Out: std::shared_ptr<hs_scratch_t>
+static std::shared_ptr<hs_scratch_t> own_scratch(hs_scratch_t* s) {
+    return std::shared_ptr<hs_scratch_t>(s, [](hs_scratch_t* p) { if (p) hs_free_scratch(p); });
+}
+
+// Desc: make a freshly compiled/loaded database the only tier (takes ownership of db)
+// In: hs_database_t* db, const std::vector<std::string>& stable_ids, size_t expressions, bool literal
+// Out: bool (false if scratch allocation fails)
+bool PatternMatcherHS::adoptSingle_(hs_database_t* db, const std::vector<std::string>& stable_ids,
+                                    size_t expressions, bool literal) {
+    auto tier = std::make_shared<Tier>();
+    tier->db          = db;
+    tier->stable_ids  = stable_ids;
+    tier->expressions = expressions;
+    tier->literal     = literal;
+
+    hs_scratch_t* scratch = nullptr;
+    if (hs_alloc_scratch(db, &scratch) != HS_SUCCESS) {
+        std::cerr << "[PatternMatcherHS] hs_alloc_scratch failed\n";
+        freeAll_();
+        return false;
+    }
+    freeAll_();
+    base_scratch_ = own_scratch(scratch);
+    tiers_.push_back(std::move(tier));
+    offsets_.push_back(0);
+    masked_.assign(stable_ids.size(), 0);
+    count_ = expressions;
+    max_width_ = kUnbounded; // unknown until the caller sets it from the sources
+    scratch_gen_ = nextScratchGen();
+    ready_ = true;
+    return true;
+}
+
+bool PatternMatcherHS::buildFromConfig(const ConfigManager& cfg, const std::string& cache_dir) {
+    return buildCached(cfg.getPatternStrings(), cfg.patternIds(), cfg.patternsHash(), cache_dir);
+}
+
+// Desc: load the serialized database for this pattern set, or compile and save it
+// In: pats, stable_ids, const std::string& patterns_hash, const std::string& cache_dir
+// Out: bool
+bool PatternMatcherHS::buildCached(const std::vector<std::string>& pats, const std::vector<std::string>& stable_ids,
+                                   const std::string& patterns_hash, const std::string& cache_dir) {
+    const std::string path = cachePath(cache_dir, patterns_hash);
+    if (!path.empty() && loadDatabase(path, stable_ids)) {
+        anchored_ = anyAnchored_(pats);
+        max_width_ = maxWidth_(pats);
+        #ifdef DEBUG
+        std::cout << "[PatternMatcherHS] loaded cached database: " << path << std::endl;
+        #endif
+        return true;
+    }
+    if (!buildFromPatterns(pats, stable_ids)) return false;
+    if (!path.empty()) (void)saveDatabase(path);
+    return true;
+}
+
+bool PatternMatcherHS::buildFromPatterns(const std::vector<std::string>& pats,
+                                         const std::vector<std::string>& stable_ids) {
     freeAll_();
 
-    const auto& pats = cfg.getPatternStrings();
-    count_ = pats.size();
     if (pats.empty()) {
         // No patterns: treat as ready but trivially false on matches()
         ready_ = true;
@@ -40,15 +132,16 @@ bool PatternMatcherHS::buildFromConfig(const ConfigManager& cfg) {
     ids.reserve(pats.size());
     for (size_t i = 0; i < pats.size(); ++i) ids.push_back(static_cast<unsigned>(i));
 
+    hs_database_t* db = nullptr;
     hs_compile_error_t* ce = nullptr;
     hs_error_t rc = hs_compile_multi(
         cpat.data(),
         flags.data(),
         ids.data(),
         static_cast<unsigned>(cpat.size()),
-        HS_MODE_BLOCK,
+        HS_MODE_VECTORED,
         nullptr,
-        &db_,
+        &db,
         &ce
     );
 
@@ -59,58 +152,446 @@ bool PatternMatcherHS::buildFromConfig(const ConfigManager& cfg) {
         } else {
             std::cerr << "[PatternMatcherHS] compile failed (unknown)\n";
         }
-        freeAll_();
         return false;
     }
     if (ce) hs_free_compile_error(ce);
 
-    rc = hs_alloc_scratch(db_, &base_scratch_);
-    if (rc != HS_SUCCESS) {
-        std::cerr << "[PatternMatcherHS] hs_alloc_scratch failed: " << rc << "\n";
-        freeAll_();
+    if (!adoptSingle_(db, stable_ids, pats.size(), false)) return false;
+    anchored_ = anyAnchored_(pats);
+    max_width_ = maxWidth_(pats);
+    return true;
+}
+
+// Desc: longest match of any pattern (hs_expression_info, same flags as the compile)
+// In: const std::vector<std::string>& pats
+// Out: unsigned (kUnbounded if any pattern is unbounded or cannot be analysed)
+unsigned PatternMatcherHS::maxWidth_(const std::vector<std::string>& pats) {
+    unsigned width = 0;
+    for (const auto& p : pats) {
+        hs_expr_info_t* info = nullptr;
+        hs_compile_error_t* ce = nullptr;
+        if (hs_expression_info(p.c_str(), HS_FLAG_CASELESS, &info, &ce) != HS_SUCCESS || !info) {
+            if (ce) hs_free_compile_error(ce);
+            return kUnbounded;
+        }
+        const unsigned w = info->max_width;
+        std::free(info); // allocated with the default (malloc) allocator
+        if (w == kUnbounded) return kUnbounded;
+        width = std::max(width, w);
+    }
+    return width;
+}
+
+// Desc: does any pattern use a buffer-edge assertion (^ $ \A \z \Z outside a class), or a
+//       word-boundary assertion (\b \B), which treats a buffer edge as a non-word byte?
+// In: const std::vector<std::string>& pats
+// Out: bool (conservative: escapes and classes are skipped, nothing else is parsed)
+bool PatternMatcherHS::anyAnchored_(const std::vector<std::string>& pats) {
+    for (const auto& p : pats) {
+        bool in_class = false;
+        for (size_t i = 0; i < p.size(); ++i) {
+            const char c = p[i];
+            if (c == '\\') {
+                if (!in_class && i + 1 < p.size()) {
+                    const char e = p[i + 1];
+                    if (e == 'A' || e == 'z' || e == 'Z' || e == 'b' || e == 'B') return true;
+                }
+                ++i;
+            } else if (in_class) {
+                if (c == ']') in_class = false;
+            } else if (c == '[') {
+                in_class = true;
+                if (i + 1 < p.size() && p[i + 1] == '^') ++i;
+                if (i + 1 < p.size() && p[i + 1] == ']') ++i; // leading ']' is a literal
+            } else if (c == '^' || c == '$') {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Desc: tiered rebuild on top of prev: shared tiers + one delta tier for added patterns,
+//       removed patterns masked out
+// In: const PatternMatcherHS& prev, pats, stable_ids (parallel), size_t max_tiers
+// Out: bool (false = caller should do a full build)
+bool PatternMatcherHS::buildIncremental(const PatternMatcherHS& prev, const std::vector<std::string>& pats,
+                                        const std::vector<std::string>& stable_ids, size_t max_tiers) {
+    freeAll_();
+    if (!prev.ready_ || prev.tiers_.empty() || max_tiers < 2) return false;
+    for (const auto& t : prev.tiers_) if (t->literal) return false;
+
+    // live ids of prev vs the wanted set
+    std::unordered_set<std::string> have, want(stable_ids.begin(), stable_ids.end());
+    std::vector<uint8_t> masked = prev.masked_;
+    for (size_t ti = 0; ti < prev.tiers_.size(); ++ti) {
+        const auto& ids = prev.tiers_[ti]->stable_ids;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const size_t gid = prev.offsets_[ti] + i;
+            if (masked[gid]) continue;
+            if (want.count(ids[i])) have.insert(ids[i]);
+            else                    masked[gid] = 1;
+        }
+    }
+
+    std::vector<std::string> add_pats, add_ids;
+    for (size_t i = 0; i < pats.size(); ++i) {
+        if (have.count(stable_ids[i])) continue;
+        have.insert(stable_ids[i]); // a duplicate pattern line compiles once
+        add_pats.push_back(pats[i]);
+        add_ids.push_back(stable_ids[i]);
+    }
+    if (!add_pats.empty() && prev.tiers_.size() + 1 > max_tiers) return false;
+
+    PatternMatcherHS delta;
+    if (!add_pats.empty() && !delta.buildFromPatterns(add_pats, add_ids)) return false;
+
+    // prev's scratch prototype is read concurrently by scanning threads: grow a clone
+    hs_scratch_t* scratch = nullptr;
+    if (hs_clone_scratch(prev.base_scratch_.get(), &scratch) != HS_SUCCESS ||
+        (!add_pats.empty() && hs_alloc_scratch(delta.tiers_[0]->db, &scratch) != HS_SUCCESS)) {
+        std::cerr << "[PatternMatcherHS] scratch allocation for delta tier failed\n";
+        if (scratch) hs_free_scratch(scratch);
         return false;
     }
 
+    tiers_   = prev.tiers_;
+    offsets_ = prev.offsets_;
+    masked_  = std::move(masked);
+    if (!add_pats.empty()) {
+        offsets_.push_back(masked_.size());
+        masked_.resize(masked_.size() + add_ids.size(), 0);
+        tiers_.push_back(delta.tiers_[0]);
+    }
+    base_scratch_ = own_scratch(scratch);
+    anchored_ = prev.anchored_ || delta.anchored_;
+    max_width_ = std::max(prev.max_width_, delta.max_width_);
+    count_ = 0;
+    for (size_t ti = 0; ti < tiers_.size(); ++ti) {
+        for (size_t i = 0; i < tiers_[ti]->stable_ids.size(); ++i) count_ += masked_[offsets_[ti] + i] ? 0 : 1;
+    }
+    scratch_gen_ = nextScratchGen();
     ready_ = true;
     return true;
 }
 
-bool PatternMatcherHS::matches(const std::string& text) const {
-    if (!ready_) return false;
-    if (count_ == 0) return false;
+// Desc: see header; literal tiers use single-match, so a batch would hide later files' hits
+// In: (none)
+// Out: bool
+bool PatternMatcherHS::batchable() const {
+    if (anchored_) return false;
+    for (const auto& t : tiers_) if (t->literal) return false;
+    return true;
+}
+
+// Desc: number of compiled patterns hidden because they were removed from the config
+// In: (none)
+// Out: size_t
+size_t PatternMatcherHS::maskedCount() const {
+    size_t n = 0;
+    for (uint8_t m : masked_) n += m;
+    return n;
+}
 
+// Desc: compile a literal database; literal i reports ids[i] (index into stable_ids)
+// In: lits/lens/ids/flags (parallel), const std::vector<std::string>& stable_ids
+// Out: bool (true on success; an empty list yields a ready matcher that never matches)
+bool PatternMatcherHS::compileLiterals_(const std::vector<const char*>& lits, const std::vector<size_t>& lens,
+                                        const std::vector<unsigned>& ids, const std::vector<unsigned>& flags,
+                                        const std::vector<std::string>& stable_ids) {
+    freeAll_();
+    if (lits.empty()) {
+        ready_ = true;
+        return true;
+    }
+
+    hs_database_t* db = nullptr;
+    hs_compile_error_t* ce = nullptr;
+    hs_error_t rc = hs_compile_lit_multi(
+        lits.data(),
+        flags.data(),
+        ids.data(),
+        lens.data(),
+        static_cast<unsigned>(lits.size()),
+        HS_MODE_VECTORED,
+        nullptr,
+        &db,
+        &ce
+    );
+    if (rc != HS_SUCCESS) {
+        if (ce) {
+            std::cerr << "[PatternMatcherHS] literal compile failed: " << ce->message
+                      << " (literal " << ce->expression << ")\n";
+            hs_free_compile_error(ce);
+        } else {
+            std::cerr << "[PatternMatcherHS] literal compile failed (unknown)\n";
+        }
+        return false;
+    }
+    if (ce) hs_free_compile_error(ce);
+
+    if (!adoptSingle_(db, stable_ids, lits.size(), true)) return false;
+    max_width_ = static_cast<unsigned>(*std::max_element(lens.begin(), lens.end()));
+    return true;
+}
+
+// Desc: build one literal database from in-memory strings (all report stable_id)
+// In: const std::vector<std::string>& literals, const std::string& stable_id, bool caseless
+// Out: bool
+bool PatternMatcherHS::buildFromLiterals(const std::vector<std::string>& literals,
+                                         const std::string& stable_id, bool caseless) {
+    std::vector<const char*> lits;
+    std::vector<size_t> lens;
+    lits.reserve(literals.size());
+    lens.reserve(literals.size());
+    for (const auto& l : literals) {
+        if (l.empty()) continue;
+        lits.push_back(l.data());
+        lens.push_back(l.size());
+    }
+    const unsigned flag = HS_FLAG_SINGLEMATCH | (caseless ? HS_FLAG_CASELESS : 0u);
+    return compileLiterals_(lits, lens, std::vector<unsigned>(lits.size(), 0u),
+                            std::vector<unsigned>(lits.size(), flag), {stable_id});
+}
+
+// Desc: load dictionary files (one literal per line) into a single literal database.
+//       Uses the serialized-database cache when the files still match the config hashes.
+// In: const std::vector<DictionarySpec>& dicts, const std::vector<std::string>& stable_ids, const std::string& cache_dir
+// Out: bool
+bool PatternMatcherHS::buildFromDictionaries(const std::vector<DictionarySpec>& dicts,
+                                             const std::vector<std::string>& stable_ids,
+                                             const std::string& cache_dir) {
+    std::vector<std::string> blobs(dicts.size());
+    bool changed = false;
+    std::string key;
+    for (size_t i = 0; i < dicts.size(); ++i) {
+        std::ifstream f(dicts[i].path, std::ios::binary);
+        if (!f.is_open()) {
+            std::cerr << "[PatternMatcherHS] cannot open dictionary: " << dicts[i].path << "\n";
+            return false;
+        }
+        blobs[i].assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        if (ConfigManager::hashCanonical(blobs[i]) != dicts[i].content_hash) {
+            // compiled as found on disk, but never cached under the stale key
+            std::cerr << "[PatternMatcherHS] dictionary changed since config load: " << dicts[i].path << "\n";
+            changed = true;
+        }
+        key += stable_ids[i];
+    }
+
+    const std::string path = changed ? "" : cachePath(cache_dir, ConfigManager::hashCanonical("dictionaries:" + key));
+    if (!path.empty() && loadDatabase(path, stable_ids, true)) return true;
+
+    std::vector<const char*> lits;
+    std::vector<size_t> lens;
+    std::vector<unsigned> ids, flags;
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        const std::string& b = blobs[i];
+        const unsigned flag = HS_FLAG_SINGLEMATCH | (dicts[i].caseless ? HS_FLAG_CASELESS : 0u);
+        size_t start = 0;
+        while (start < b.size()) {
+            size_t end = b.find('\n', start);
+            if (end == std::string::npos) end = b.size();
+            size_t len = end - start;
+            if (len > 0 && b[start + len - 1] == '\r') --len;
+            if (len > 0) {
+                lits.push_back(b.data() + start);
+                lens.push_back(len);
+                ids.push_back(static_cast<unsigned>(i));
+                flags.push_back(flag);
+            }
+            start = end + 1;
+        }
+    }
+    if (!compileLiterals_(lits, lens, ids, flags, stable_ids)) return false;
+    if (!path.empty()) (void)saveDatabase(path);
+    return true;
+}
+
+// Desc: compiled database size in bytes, all tiers (0 if none)
+// In: (none)
+// Out: size_t
+size_t PatternMatcherHS::databaseBytes() const {
+    size_t total = 0;
+    for (const auto& t : tiers_) {
+        size_t sz = 0;
+        if (hs_database_size(t->db, &sz) == HS_SUCCESS) total += sz;
+    }
+    return total;
+}
+
+// Desc: size of the scratch prototype (each scanning thread holds a clone of it), 0 if none
+// In: (none)
+// Out: size_t
+size_t PatternMatcherHS::scratchBytes() const {
+    size_t sz = 0;
+    if (!base_scratch_ || hs_scratch_size(base_scratch_.get(), &sz) != HS_SUCCESS) return 0;
+    return sz;
+}
+
+const std::string& PatternMatcherHS::globalStableId_(size_t gid) const {
+    static const std::string kNone;
+    auto it = std::upper_bound(offsets_.begin(), offsets_.end(), gid);
+    if (it == offsets_.begin()) return kNone;
+    const size_t ti = static_cast<size_t>(it - offsets_.begin()) - 1;
+    const size_t local = gid - offsets_[ti];
+    return local < tiers_[ti]->stable_ids.size() ? tiers_[ti]->stable_ids[local] : kNone;
+}
+
+const std::string& PatternMatcherHS::stableId(unsigned id) const {
+    return globalStableId_(id);
+}
+
+// Desc: scan one buffer
+// In: std::string_view text, unsigned* matched_id (optional)
+// Out: bool (true if an active pattern matched)
+bool PatternMatcherHS::matches(std::string_view text, unsigned* matched_id) const {
+    if (text.size() > kMaxSegment) return matches(std::vector<std::string_view>{text}, matched_id);
+    const char* data = text.data();
+    const unsigned len = static_cast<unsigned>(text.size());
+    return scanVector_(&data, &len, 1, matched_id);
+}
+
+// Desc: scan segments as one logical buffer (segments over 4 GB are split, which is
+//       transparent in vectored mode)
+// In: const std::vector<std::string_view>& segments, unsigned* matched_id (optional)
+// Out: bool
+bool PatternMatcherHS::matches(const std::vector<std::string_view>& segments, unsigned* matched_id) const {
+    std::vector<const char*> data;
+    std::vector<unsigned> lens;
+    data.reserve(segments.size());
+    lens.reserve(segments.size());
+    for (std::string_view seg : segments) {
+        do {
+            const size_t n = std::min<size_t>(seg.size(), kMaxSegment);
+            data.push_back(seg.data());
+            lens.push_back(static_cast<unsigned>(n));
+            seg.remove_prefix(n);
+        } while (!seg.empty());
+    }
+    if (data.empty()) return matches(std::string_view(), matched_id);
+    return scanVector_(data.data(), lens.data(), static_cast<unsigned>(data.size()), matched_id);
+}
+
+// Desc: make this thread's scratch usable for every tier of this matcher
+// In: (none)
+// Out: hs_scratch_t* (nullptr if allocation fails)
+hs_scratch_t* PatternMatcherHS::prepareScratch_() const {
+    // unbound threads (short-lived helpers) get one that is freed at thread exit
+    static thread_local Scratch tls_own;
+    Scratch& sc = tls_bound_ ? *tls_bound_ : tls_own;
     // Clone per-thread scratch lazily and reuse.
-    if (!tls_scratch_) {
+    if (!sc.s) {
         if (base_scratch_) {
-            if (hs_clone_scratch(base_scratch_, &tls_scratch_) != HS_SUCCESS) {
+            if (hs_clone_scratch(base_scratch_.get(), &sc.s) != HS_SUCCESS) {
                 std::cerr << "[PatternMatcherHS] hs_clone_scratch failed\n";
-                return false;
+                sc.s = nullptr;
+                return nullptr;
             }
         } else {
             std::cerr << "[PatternMatcherHS] base scratch is null\n";
-            return false;
+            return nullptr;
         }
+        sc.gen = scratch_gen_;
+    } else if (sc.gen != scratch_gen_) {
+        // another tier list (reloaded set or delta matcher): grow in place if it needs more
+        for (const auto& t : tiers_) {
+            if (hs_alloc_scratch(t->db, &sc.s) != HS_SUCCESS) {
+                std::cerr << "[PatternMatcherHS] hs_alloc_scratch (thread) failed\n";
+                return nullptr;
+            }
+        }
+        sc.gen = scratch_gen_;
     }
+    return sc.s;
+}
+
+// Desc: hs_scan_vector over every tier until an active pattern matches
+// In: const char* const* data, const unsigned* lens, unsigned count, unsigned* matched_id
+// Out: bool
+bool PatternMatcherHS::scanVector_(const char* const* data, const unsigned* lens, unsigned count,
+                                   unsigned* matched_id) const {
+    if (!ready_) return false;
+    if (count_ == 0 || tiers_.empty()) return false;
+
+    hs_scratch_t* scratch = prepareScratch_();
+    if (!scratch) return false;
 
-    bool matched = false;
-    auto on_match = [](unsigned int, unsigned long long, unsigned long long, unsigned int, void* ctx) -> int {
-        *static_cast<bool*>(ctx) = true;
+    // hits on masked (removed) patterns are skipped and the scan continues
+    struct Hit { bool matched; unsigned id; size_t offset; const uint8_t* masked; } hit{false, 0, 0, nullptr};
+    auto on_match = [](unsigned int id, unsigned long long, unsigned long long, unsigned int, void* ctx) -> int {
+        auto* h = static_cast<Hit*>(ctx);
+        const size_t gid = h->offset + id;
+        if (h->masked && h->masked[gid]) return 0;
+        h->matched = true;
+        h->id = static_cast<unsigned>(gid);
         return HS_SCAN_TERMINATED;
     };
 
-    hs_error_t rc = hs_scan(
-        db_,
-        text.data(),
-        static_cast<unsigned int>(text.size()),
-        0,
-        tls_scratch_,
-        on_match,
-        &matched
-    );
+    for (size_t ti = 0; ti < tiers_.size() && !hit.matched; ++ti) {
+        hit.offset = offsets_[ti];
+        hit.masked = masked_.empty() ? nullptr : masked_.data();
+        hs_error_t rc = hs_scan_vector(
+            tiers_[ti]->db,
+            data,
+            lens,
+            count,
+            0,
+            scratch,
+            on_match,
+            &hit
+        );
 
-    if (rc != HS_SUCCESS && rc != HS_SCAN_TERMINATED) {
-        std::cerr << "[PatternMatcherHS] hs_scan error: " << rc << "\n";
-        return false;
+        if (rc != HS_SUCCESS && rc != HS_SCAN_TERMINATED) {
+            std::cerr << "[PatternMatcherHS] hs_scan_vector error: " << rc << "\n";
+            return false;
+        }
+    }
+    if (hit.matched && matched_id) *matched_id = hit.id;
+    return hit.matched;
+}
+
+// Desc: report every active match (id, end offset) over the segments until on_hit says stop
+// In: const std::vector<std::string_view>& segments, on_hit
+// Out: bool (false on scan error)
+bool PatternMatcherHS::forEachMatch(const std::vector<std::string_view>& segments,
+                                    const std::function<bool(unsigned, unsigned long long)>& on_hit) const {
+    if (!ready_ || count_ == 0 || tiers_.empty() || segments.empty()) return true;
+    std::vector<const char*> data;
+    std::vector<unsigned> lens;
+    for (std::string_view seg : segments) {
+        do {
+            const size_t n = std::min<size_t>(seg.size(), kMaxSegment);
+            data.push_back(seg.data());
+            lens.push_back(static_cast<unsigned>(n));
+            seg.remove_prefix(n);
+        } while (!seg.empty());
+    }
+    hs_scratch_t* scratch = prepareScratch_();
+    if (!scratch) return false;
+
+    struct Ctx {
+        size_t offset;
+        const uint8_t* masked;
+        const std::function<bool(unsigned, unsigned long long)>* on_hit;
+        bool stopped;
+    } ctx{0, masked_.empty() ? nullptr : masked_.data(), &on_hit, false};
+    auto on_match = [](unsigned int id, unsigned long long, unsigned long long to, unsigned int, void* p) -> int {
+        auto* c = static_cast<Ctx*>(p);
+        const size_t gid = c->offset + id;
+        if (c->masked && c->masked[gid]) return 0;
+        if ((*c->on_hit)(static_cast<unsigned>(gid), to)) return 0;
+        c->stopped = true;
+        return HS_SCAN_TERMINATED;
+    };
+    for (size_t ti = 0; ti < tiers_.size() && !ctx.stopped; ++ti) {
+        ctx.offset = offsets_[ti];
+        hs_error_t rc = hs_scan_vector(tiers_[ti]->db, data.data(), lens.data(),
+                                       static_cast<unsigned>(data.size()), 0, scratch, on_match, &ctx);
+        if (rc != HS_SUCCESS && rc != HS_SCAN_TERMINATED) {
+            std::cerr << "[PatternMatcherHS] hs_scan_vector error: " << rc << "\n";
+            return false;
+        }
     }
-    return matched;
+    return true;
 }
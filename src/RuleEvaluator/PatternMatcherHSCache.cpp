@@ -0,0 +1,156 @@
+// === src/RuleEvaluator/PatternMatcherHSCache.cpp ===
+#include "PatternMatcherHS.hpp"
+#include "FileIO.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk layout: DbFileHeader, id_count fixed-width stable ids, then the
+// hs_serialize_database() bytes. The ids pin the pattern order the database
+// was compiled with (Hyperscan match ids are indexes into that order).
+static const char     kDbMagic[8]  = {'F','G','H','S','D','B','\0','\1'};
+static const uint32_t kDbFormat    = 2; // bump when compile flags/mode change
+static const size_t   kIdWidth     = 16;
+
+struct DbFileHeader {
+    char     magic[8];
+    uint32_t format;
+    uint32_t id_count;
+    uint64_t db_len;
+    uint64_t tune;
+    uint64_t cpu_features;
+    char     hs_version[48];
+    uint64_t checksum;
+};
+
+// Desc: fill the version/platform fields a cached database must match
+// In: DbFileHeader& h
+// Out: bool (false if the host platform cannot be queried)
+static bool fill_platform(DbFileHeader& h) {
+    hs_platform_info_t plat{};
+    if (hs_populate_platform(&plat) != HS_SUCCESS) return false;
+    h.tune         = plat.tune;
+    h.cpu_features = plat.cpu_features;
+    std::snprintf(h.hs_version, sizeof(h.hs_version), "%s", hs_version());
+    return true;
+}
+
+// Desc: cache file name for a pattern set on this host (patterns hash + tune + cpu features)
+// In: const std::string& dir, const std::string& patterns_hash
+// Out: std::string (empty if the platform cannot be queried)
+std::string PatternMatcherHS::cachePath(const std::string& dir, const std::string& patterns_hash) {
+    DbFileHeader h{};
+    if (dir.empty() || !fill_platform(h)) return "";
+    char tag[64];
+    std::snprintf(tag, sizeof(tag), "-t%llu-f%llx.hsdb",
+                  static_cast<unsigned long long>(h.tune),
+                  static_cast<unsigned long long>(h.cpu_features));
+    return dir + "/hs-" + patterns_hash.substr(0, 16) + tag;
+}
+
+// Desc: serialize the compiled database (tmp file + rename); only a single-tier matcher
+//       is written, a tiered one is saved after its background merge
+// In: const std::string& path
+// Out: bool (true on success)
+bool PatternMatcherHS::saveDatabase(const std::string& path) const {
+    if (path.empty() || tiers_.size() != 1 || maskedCount() != 0) return false;
+    hs_database_t* db = tiers_[0]->db;
+    const std::vector<std::string>& stable_ids = tiers_[0]->stable_ids;
+    for (const auto& id : stable_ids) if (id.size() != kIdWidth) return false;
+
+    char*  bytes = nullptr;
+    size_t len   = 0;
+    if (hs_serialize_database(db, &bytes, &len) != HS_SUCCESS) {
+        std::cerr << "[PatternMatcherHS] hs_serialize_database failed\n";
+        return false;
+    }
+
+    std::string ids;
+    ids.reserve(stable_ids.size() * kIdWidth);
+    for (const auto& id : stable_ids) ids += id;
+
+    DbFileHeader hdr{};
+    std::memcpy(hdr.magic, kDbMagic, sizeof(hdr.magic));
+    hdr.format   = kDbFormat;
+    hdr.id_count = static_cast<uint32_t>(stable_ids.size());
+    hdr.db_len   = static_cast<uint64_t>(len);
+    bool ok = fill_platform(hdr);
+    hdr.checksum = fnv1a64(bytes, len, fnv1a64(ids.data(), ids.size()));
+
+    const std::string tmp = path + ".tmp";
+    int fd = ok ? ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600) : -1;
+    if (fd >= 0) {
+        ok = write_all(fd, &hdr, sizeof(hdr)) &&
+             write_all(fd, ids.data(), ids.size()) &&
+             write_all(fd, bytes, len) &&
+             ::fsync(fd) == 0;
+        ::close(fd);
+        ok = ok && ::rename(tmp.c_str(), path.c_str()) == 0;
+    } else {
+        ok = false;
+    }
+    std::free(bytes);
+
+    if (!ok) {
+        std::cerr << "[PatternMatcherHS] database cache write failed: " << path
+                  << " (" << std::strerror(errno) << ")\n";
+        ::unlink(tmp.c_str());
+    }
+    return ok;
+}
+
+// Desc: mmap a cached database and deserialize it if it matches this host and pattern order
+// In: const std::string& path, const std::vector<std::string>& stable_ids, bool literal
+// Out: bool (true if loaded and ready; false if missing/stale/corrupt)
+bool PatternMatcherHS::loadDatabase(const std::string& path, const std::vector<std::string>& stable_ids,
+                                    bool literal) {
+    if (path.empty()) return false;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(DbFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const size_t file_len = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return false;
+
+    const auto* hdr   = static_cast<const DbFileHeader*>(base);
+    const char* ids   = static_cast<const char*>(base) + sizeof(DbFileHeader);
+    const size_t ids_len = static_cast<size_t>(hdr->id_count) * kIdWidth;
+    const char* bytes = ids + ids_len;
+
+    DbFileHeader host{};
+    bool ok = std::memcmp(hdr->magic, kDbMagic, sizeof(hdr->magic)) == 0 &&
+              hdr->format == kDbFormat &&
+              ids_len <= file_len - sizeof(DbFileHeader) &&
+              hdr->db_len == file_len - sizeof(DbFileHeader) - ids_len &&
+              fill_platform(host) &&
+              hdr->tune == host.tune && hdr->cpu_features == host.cpu_features &&
+              std::strncmp(hdr->hs_version, host.hs_version, sizeof(host.hs_version)) == 0 &&
+              hdr->id_count == stable_ids.size();
+    for (size_t i = 0; ok && i < stable_ids.size(); ++i) {
+        ok = stable_ids[i].size() == kIdWidth &&
+             std::memcmp(ids + i * kIdWidth, stable_ids[i].data(), kIdWidth) == 0;
+    }
+    ok = ok && fnv1a64(bytes, hdr->db_len, fnv1a64(ids, ids_len)) == hdr->checksum;
+
+    hs_database_t* db = nullptr;
+    if (ok && hs_deserialize_database(bytes, static_cast<size_t>(hdr->db_len), &db) != HS_SUCCESS) {
+        std::cerr << "[PatternMatcherHS] cached database rejected by Hyperscan: " << path << "\n";
+        ok = false;
+    }
+    ::munmap(base, file_len);
+    if (!ok) return false;
+
+    return adoptSingle_(db, stable_ids, stable_ids.size(), literal);
+}
@@ -1,7 +1,8 @@
 #include "RuleEvaluator.hpp"
-#include "PatternMatcherHS.hpp"
+#include "MatcherRegistry.hpp"
 #include "AsyncScanQueue.hpp"
-#include "ContentParser.hpp"
+#include "FileScanner.hpp"
+#include "ScanContext.hpp"
 #include <iostream>
 #include <unistd.h>
 #include <fcntl.h>
@@ -16,29 +17,63 @@
 #ifdef DEBUG
 static std::atomic<uint64_t> g_big_files{0};
 #endif
-RuleEvaluator::RuleEvaluator(const ConfigManager& config, const PatternMatcherHS& matcher)
-    : config(config), matcher(matcher) {}
+RuleEvaluator::RuleEvaluator(const ConfigManager& config, const MatcherRegistry& registry)
+    : config(config), registry(registry), contexts_(config.scan_context()) {}
+
+// Desc: answer one permission event and close its fd
+// In: int fan_fd, int fd, bool allow
+// Out: void
+static void send_response(int fan_fd, int fd, bool allow) {
+    struct fanotify_response resp{
+        .fd       = fd,
+        .response = allow ? (__u32)FAN_ALLOW : (__u32)FAN_DENY
+    };
+    ssize_t _wr = ::write(fan_fd, &resp, sizeof(resp)); // ignore retval
+    (void)_wr;
+    close(fd);
+}
+
+// Desc: write the BLOCKED line for a file to the log pipe
+// In: int log_pipe_fd, const char* path, long pid
+// Out: void
+static void log_blocked(int log_pipe_fd, const char* path, long pid) {
+    std::time_t now = std::time(nullptr);
+    char* date_time = std::ctime(&now);
+    if (!date_time) return;
+    date_time[strlen(date_time) - 1] = '\0'; // strip '\n'
+    std::string log_line = "[" + std::string(date_time) + "] BLOCKED: " +
+                           path + " for PID [" + std::to_string(pid) + "]\n";
+    ssize_t _wr = ::write(log_pipe_fd, log_line.c_str(), log_line.size());
+    (void)_wr;
+}
+
+// Desc: resolve the path behind an event fd ("[unknown]" if it cannot be read)
+// In: int fd
+// Out: std::string
+static std::string fd_path(int fd) {
+    char fd_link[64];
+    snprintf(fd_link, sizeof(fd_link), "/proc/self/fd/%d", fd);
+    char path_buf[512];
+    ssize_t n = readlink(fd_link, path_buf, sizeof(path_buf) - 1);
+    return n >= 0 ? std::string(path_buf, static_cast<size_t>(n)) : std::string("[unknown]");
+}
 
 
 // Desc: evaluate file access against rules and respond via fanotify
-// In: int fan_fd, const fanotify_event_metadata* metadata, int log_pipe_fd, int& out_decision
+// In: int fan_fd, const fanotify_event_metadata* metadata, int log_pipe_fd, int& out_decision,
+//     std::string* out_matched, const MatcherSet* set, bool delta_only
 // Out: void (writes fanotify response, sets out_decision)
 void RuleEvaluator::handle_event(int fan_fd,
                                  const struct fanotify_event_metadata* metadata,
                                  int log_pipe_fd,
-                                 int& out_decision) {
+                                 int& out_decision,
+                                 std::string* out_matched,
+                                 const MatcherSet* set,
+                                 bool delta_only) {
     out_decision = 0; // 0 = ALLOW
     if (metadata->fd < 0) return;
 
-    auto respond = [&](bool allow) {
-        struct fanotify_response resp{
-            .fd       = metadata->fd,
-            .response = allow ? (__u32)FAN_ALLOW : (__u32)FAN_DENY
-        };
-        ssize_t _wr = ::write(fan_fd, &resp, sizeof(resp)); // ignore retval
-        (void)_wr;
-        close(metadata->fd);
-    };
+    auto respond = [&](bool allow) { send_response(fan_fd, metadata->fd, allow); };
     char fd_link[64];
     snprintf(fd_link, sizeof(fd_link), "/proc/self/fd/%d", metadata->fd);
 
@@ -72,43 +107,97 @@ void RuleEvaluator::handle_event(int fan_fd,
         int dupfd = fcntl(metadata->fd, F_DUPFD_CLOEXEC, 3);
         if (dupfd >= 0) {
             out_decision = 2; // UNDECIDED
+            // a revalidation keeps to the added patterns while this generation stays current
+            const bool use_delta = delta_only && set && set->has_delta;
             enqueue_async_scan(dupfd, static_cast<pid_t>(metadata->pid),
-                            static_cast<size_t>(st.st_size));
+                            static_cast<size_t>(st.st_size),
+                            delta_only ? AsyncScanClass::Revalidate : AsyncScanClass::Miss,
+                            use_delta ? set->ruleset_version : 0);
         }
         respond(true);
         return;
     }
-    std::vector<char> buffer(fsz);
-    ssize_t done = 0;
-    while (static_cast<size_t>(done) < fsz) {
-        ssize_t r = pread(metadata->fd, buffer.data() + done, fsz - done, done);
-        if (r <= 0) { 
-            respond(true);
-            return;
-        }
-        done += r;
-    }
+    // hold the generation for the whole scan; a concurrent reload cannot free it
+    std::shared_ptr<const MatcherSet> cur;
+    if (!set) { cur = registry.current(); set = cur.get(); }
+    if (!set) { respond(true); return; }
 
-    std::string header(buffer.data(), std::min<size_t>(5, buffer.size()));
-    std::string type = ContentParser::detect_type(header);
-    std::string extracted = ContentParser::extract_text(type,path_buf,std::string(buffer.data(), buffer.size()),log_pipe_fd);
+    ScanEnv env;
+    const bool use_delta = delta_only && set->has_delta;
+    env.matcher         = use_delta ? &set->delta : &set->full;
+    env.dict            = use_delta ? nullptr : &set->dict;
+    env.scoped          = use_delta ? &set->delta_scoped : &set->scoped;
+    env.dedup           = dedup_;
+    env.ruleset_version = set->ruleset_version;
+    env.log_fd          = log_pipe_fd;
+    env.pdf             = config.pdf_limits();
+    env.types           = &config.type_policies();
+    env.archives        = &config.archive_limits();
+    env.extractors      = extractors_;
+    env.budget          = budget_;
+    env.appends         = appends_;
+    env.chunks          = chunks_;
+    // buffers and scratch outlive this (per-event) thread
+    ScanContextPool::Lease ctx = contexts_.acquire();
+    env.ctx             = ctx.get();
+    const int verdict = scan_file_contents(metadata->fd, fsz, path_buf, env, out_matched);
+    if (verdict < 0) {
+        respond(true);
+        return;
+    }
 
-    if (matcher.matches(extracted)) {
+    if (verdict == 1) {
         out_decision = 1; // BLOCK
-
-        std::time_t now = std::time(nullptr);
-        char* date_time = std::ctime(&now);
-        if (date_time) {
-            date_time[strlen(date_time) - 1] = '\0'; // strip '\n'
-            std::string log_line = "[" + std::string(date_time) + "] BLOCKED: " +
-                                   path_buf + " for PID [" + std::to_string(metadata->pid) + "]\n";
-            ssize_t _wr = ::write(log_pipe_fd, log_line.c_str(), log_line.size());
-            (void)_wr;
-        }
-
+        log_blocked(log_pipe_fd, path_buf, static_cast<long>(metadata->pid));
         respond(false); // DENY
         return;
     }
 
     respond(true);
 }
+
+// Desc: evaluate a batch of small-file misses in one pass and answer all of them
+// In: int fan_fd, std::vector<BatchEvent>& events, int log_pipe_fd, const MatcherSet* set
+// Out: void (writes one fanotify response per event, sets each decision)
+void RuleEvaluator::handle_small_batch(int fan_fd, std::vector<BatchEvent>& events, int log_pipe_fd,
+                                       const MatcherSet* set) {
+    std::shared_ptr<const MatcherSet> cur;
+    if (!set) { cur = registry.current(); set = cur.get(); }
+
+    std::vector<SmallFile> files(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        files[i].fd   = events[i].fd;
+        files[i].size = events[i].size;
+        files[i].path = fd_path(events[i].fd);
+    }
+    if (set) {
+        ScanEnv env;
+        env.matcher         = &set->full;
+        env.dict            = &set->dict;
+        env.scoped          = &set->scoped;
+        env.dedup           = dedup_;
+        env.ruleset_version = set->ruleset_version;
+        env.log_fd          = log_pipe_fd;
+        env.pdf             = config.pdf_limits();
+        env.types           = &config.type_policies();
+        env.archives        = &config.archive_limits();
+        env.extractors      = extractors_;
+        env.budget          = budget_;
+        env.appends         = appends_;
+        env.chunks          = chunks_;
+        ScanContextPool::Lease ctx = contexts_.acquire();
+        env.ctx             = ctx.get();
+        scan_small_files(files, env);
+    }
+
+    for (size_t i = 0; i < events.size(); ++i) {
+        BatchEvent& ev = events[i];
+        ev.decision = files[i].verdict == 1 ? 1 : 0; // read failures are allowed
+        if (ev.decision == 1) {
+            ev.matched = files[i].matched_id;
+            log_blocked(log_pipe_fd, files[i].path.c_str(), static_cast<long>(ev.pid));
+        }
+        send_response(fan_fd, ev.fd, ev.decision == 0);
+        ev.fd = -1;
+    }
+}
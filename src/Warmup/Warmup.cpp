@@ -83,7 +83,8 @@ void scope_warmup_on_access(const std::string& path) {
             if (!S_ISREG(st.st_mode)) { ::close(fd); continue; }
             if (st.st_size <= 0)     { ::close(fd); continue; }
 
-            enqueue_async_scan(fd, 0, (std::size_t)st.st_size);
+            // a full queue refuses warmup first: leave the rest of this directory
+            if (!enqueue_async_scan(fd, 0, (std::size_t)st.st_size, AsyncScanClass::Warmup)) break;
 
             {
                 std::lock_guard<std::mutex> lk(g_mu);